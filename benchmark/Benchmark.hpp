@@ -0,0 +1,24 @@
+#pragma once
+
+#include <sys/time.h>
+
+#include <cstdio>
+
+// Runs a benchmark case `iterations` times after a warm-up of the same size,
+// and prints the mean time of one iteration.
+template <class Case>
+double  RunBenchmark(const char *name, Case &benchmark_case, long iterations)
+{
+  struct timeval  start;
+  struct timeval  end;
+
+  for (long i = 0; i < iterations; i++)
+    benchmark_case.run();
+  gettimeofday(&start, NULL);
+  for (long i = 0; i < iterations; i++)
+    benchmark_case.run();
+  gettimeofday(&end, NULL);
+  double nanoseconds = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_usec - start.tv_usec) * 1e3) / iterations;
+  std::printf("%-40s %10.1f ns\n", name, nanoseconds);
+  return nanoseconds;
+}
@@ -0,0 +1,72 @@
+#include "Benchmark.hpp"
+
+#include <cstring>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+#include "Request.hpp"
+
+// Header names of a browser request: interning them alone, then the analysis
+// of the parsed fields into a request.
+
+namespace
+{
+  const char* const kNames[] = {
+    "Host", "Connection", "sec-ch-ua", "sec-ch-ua-mobile", "sec-ch-ua-platform",
+    "Upgrade-Insecure-Requests", "User-Agent", "Accept", "Sec-Fetch-Site",
+    "Sec-Fetch-Mode", "Sec-Fetch-User", "Sec-Fetch-Dest", "Referer",
+    "Accept-Encoding", "Accept-Language", "Cookie", "If-None-Match",
+    "If-Modified-Since", "Cache-Control", "DNT"
+  };
+  const size_t  kNameCount = sizeof(kNames) / sizeof(kNames[0]);
+
+  struct Names
+  {
+    size_t  lengths[kNameCount];
+    int     known;
+
+    Names() : known(0)
+    {
+      for (size_t i = 0; i < kNameCount; i++)
+        lengths[i] = std::strlen(kNames[i]);
+    }
+
+    void  run()
+    {
+      for (size_t i = 0; i < kNameCount; i++)
+        known += (header::Intern(kNames[i], lengths[i]) != kHeaderUnknown);
+    }
+  };
+
+  struct Fields
+  {
+    std::string fields;
+    Request     request;
+
+    Fields()
+    {
+      for (size_t i = 0; i < kNameCount; i++)
+        fields += std::string(kNames[i]) + ": " + (i == 0 ? "localhost" : "?1") + "\r\n";
+      fields += "\r\n";
+    }
+
+    void  run()
+    {
+      http_parser::ParseOutput  parsed = http_parser::ParseFields(http_parser::StringSlice(fields.data(), fields.size()));
+      AnalysisRequestHeaders(static_cast<http_parser::PTNodeFields *>(parsed.result), &request);
+      request.cleanHeaderMap();
+      temporary::arena.clear();
+    }
+  };
+}
+
+int main()
+{
+  Names   names;
+  Fields  fields;
+
+  double nanoseconds = RunBenchmark("intern 20 browser header names", names, 1000000);
+  std::printf("%-40s %10.1f ns\n", "    per name", nanoseconds / kNameCount);
+  RunBenchmark("parse and analyse 20 header fields", fields, 200000);
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include "Benchmark.hpp"
+
+#include <cstring>
+#include <string>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+#include "Http/Scanner.hpp"
+
+// Throughput of the scanning loops of the http parser on realistic inputs,
+// for each span kernel the cpu supports.
+
+namespace
+{
+  const char  kUserAgent[] =
+    "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n";
+
+  const char  kAccept[] =
+    "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,"
+    "image/webp,image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7\r\n";
+
+  const char  kPath[] =
+    "/static/assets/2024/11/components/navigation/dropdown-menu/icons/"
+    "chevron-down%20outline/sprite-sheet.v3.1.4.min.svg";
+
+  const char  kQuery[] =
+    "utm_source=newsletter&utm_medium=email&utm_campaign=black-friday-2024"
+    "&redirect=%2Fcheckout%2Fcart%3Fitems%3D42&session=9f86d081884c7d659a2feaa0c55ad015";
+
+  std::string Cookie()
+  {
+    std::string cookie;
+    while (cookie.size() < 600)
+      cookie += "_ga=GA1.2.1234567890.1700000000; session_id=a3f9c2e1b7d84f6e; ";
+    return cookie + "\r\n";
+  }
+
+  std::string Head(const std::string &cookie)
+  {
+    return std::string("Host: www.example.com\r\n")
+      + "User-Agent: " + kUserAgent
+      + "Accept: " + kAccept
+      + "Accept-Language: en-US,en;q=0.9\r\n"
+      + "Accept-Encoding: gzip, deflate, br\r\n"
+      + "Referer: https://www.example.com" + kPath + "\r\n"
+      + "Cookie: " + cookie
+      + "Connection: keep-alive\r\n"
+      + "\r\n";
+  }
+
+  struct FieldValues
+  {
+    std::string cookie;
+    size_t      bytes;
+
+    FieldValues() : cookie(Cookie()), bytes(sizeof(kUserAgent) + sizeof(kAccept) - 2 + cookie.size()) {}
+
+    void  run()
+    {
+      http_parser::ParseFieldValue(http_parser::StringSlice(kUserAgent, sizeof(kUserAgent) - 1));
+      http_parser::ParseFieldValue(http_parser::StringSlice(kAccept, sizeof(kAccept) - 1));
+      http_parser::ParseFieldValue(http_parser::StringSlice(cookie.data(), cookie.size()));
+      temporary::arena.clear();
+    }
+  };
+
+  struct UriParts
+  {
+    size_t  bytes;
+
+    UriParts() : bytes(sizeof(kPath) + sizeof(kQuery) - 2) {}
+
+    void  run()
+    {
+      http_parser::ScanSegments(http_parser::StringSlice(kPath, sizeof(kPath) - 1));
+      http_parser::ParseUriQuery(http_parser::StringSlice(kQuery, sizeof(kQuery) - 1));
+      temporary::arena.clear();
+    }
+  };
+
+  struct Fields
+  {
+    std::string head;
+    size_t      bytes;
+
+    Fields() : head(Head(Cookie())), bytes(head.size()) {}
+
+    void  run()
+    {
+      http_parser::FindEmptyLine(head.data(), head.size());
+      http_parser::ParseFields(http_parser::StringSlice(head.data(), head.size()));
+      temporary::arena.clear();
+    }
+  };
+
+  template <class Case>
+  void  Measure(const char *name, long iterations)
+  {
+    Case  benchmark_case;
+    double nanoseconds = RunBenchmark(name, benchmark_case, iterations);
+    std::printf("%-40s %10.2f GB/s\n", "    throughput", benchmark_case.bytes / nanoseconds);
+  }
+}
+
+int main()
+{
+  const http_parser::ScanKernel kernels[] = {
+    http_parser::kKernelScalar, http_parser::kKernelSse2, http_parser::kKernelAvx2
+  };
+
+  for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++)
+  {
+    if (!http_parser::UseKernel(kernels[i]))
+      continue;
+    std::printf("%s\n", http_parser::KernelName());
+    Measure<FieldValues>("  field values", 200000);
+    Measure<UriParts>("  uri path and query", 200000);
+    Measure<Fields>("  header fields", 100000);
+  }
+  return 0;
+}
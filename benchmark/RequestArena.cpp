@@ -0,0 +1,88 @@
+#include "Benchmark.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "Client.hpp"
+#include "Http/Parser.hpp"
+
+// Heap allocations of the request cycle of a keep-alive connection: the request
+// line and the headers are parsed into the request, the basic and content headers
+// of the response are built, then both messages are reset for the next request.
+
+static long allocations = 0;
+
+void  *operator new(std::size_t size) throw(std::bad_alloc)
+{
+  allocations++;
+  void  *memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == NULL)
+    throw std::bad_alloc();
+  return memory;
+}
+
+void  operator delete(void *memory) throw()
+{
+  std::free(memory);
+}
+
+namespace
+{
+  const char  kRequest[] =
+    "GET /images/2024/holiday/beach.jpg?size=large HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0\r\n"
+    "Accept: image/avif,image/webp,*/*\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+  struct RequestCycle
+  {
+    Client  clt;
+
+    void  run()
+    {
+      http_parser::StringSlice  request(kRequest, sizeof(kRequest) - 1);
+      size_t  request_line_length = std::strstr(kRequest, "\r\n") - kRequest;
+
+      temporary::arena.clear();
+      http_parser::ParseOutput  parsed_request_line = http_parser::ParseRequestLine(http_parser::StringSlice(kRequest, request_line_length + 2));
+      RequestLine request_line;
+      clt.req.swapRequestLine(request_line);
+      AnalysisRequestLine(static_cast<http_parser::PTNodeRequestLine *>(parsed_request_line.result), &request_line);
+      clt.req.swapRequestLine(request_line);
+
+      temporary::arena.clear();
+      http_parser::ParseOutput  parsed_headers = http_parser::ParseFields(http_parser::StringSlice(request.bytes + request_line_length + 2, request.length - request_line_length - 2));
+      AnalysisRequestHeaders(static_cast<http_parser::PTNodeFields *>(parsed_headers.result), &clt.req);
+      temporary::arena.clear();
+
+      std::string response;
+      res_builder::BuildStatusLine(k200, response);
+      res_builder::BuildBasicHeaders(&clt, response);
+      res_builder::BuildContentHeaders(&clt, response, "image/jpeg", "", 48213);
+      clt.res.appendHeaders(response);
+
+      clt.req.reset();
+      clt.res.reset();
+    }
+  };
+}
+
+int main()
+{
+  const long  iterations = 200000;
+  RequestCycle  request_cycle;
+
+  RunBenchmark("request cycle", request_cycle, iterations);
+  long  before = allocations;
+  for (long i = 0; i < iterations; i++)
+    request_cycle.run();
+  std::printf("%-40s %10.2f\n", "heap allocations per request", static_cast<double>(allocations - before) / iterations);
+  return 0;
+}
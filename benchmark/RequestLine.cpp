@@ -0,0 +1,54 @@
+#include "Benchmark.hpp"
+
+#include <cstring>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+
+// Request line of a browser: the full grammar (parse tree in the temporary
+// arena, then analysis) against the single pass origin-form parser.
+
+namespace
+{
+  const char  kRequestLine[] =
+    "GET /static/assets/2024/components/navigation/sprite-sheet.v3.min.svg"
+    "?utm_source=newsletter&utm_campaign=black-friday-2024 HTTP/1.1\r\n";
+  const size_t  kLength = sizeof(kRequestLine) - 3;
+
+  struct FullGrammar
+  {
+    RequestLine request_line;
+
+    void  run()
+    {
+      http_parser::ParseOutput  parsed = http_parser::ParseRequestLine(http_parser::StringSlice(kRequestLine, kLength + 2));
+      AnalysisRequestLine(static_cast<http_parser::PTNodeRequestLine *>(parsed.result), &request_line);
+      temporary::arena.clear();
+    }
+  };
+
+  struct OriginForm
+  {
+    RequestLine request_line;
+
+    void  run()
+    {
+      enum ParseError error;
+      AnalysisOriginFormRequestLine(kRequestLine, kLength, &request_line, &error);
+    }
+  };
+}
+
+int main()
+{
+  const long  iterations = 1000000;
+  FullGrammar full_grammar;
+  OriginForm  origin_form;
+
+  double general = RunBenchmark("request line, full grammar", full_grammar, iterations);
+  std::printf("%-40s %10.2f GB/s\n", "    throughput", (kLength + 2) / general);
+  double fast = RunBenchmark("request line, origin-form fast path", origin_form, iterations);
+  std::printf("%-40s %10.2f GB/s\n", "    throughput", (kLength + 2) / fast);
+  std::printf("%-40s %10.1f x\n", "speedup", general / fast);
+  return 0;
+}
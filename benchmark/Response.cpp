@@ -0,0 +1,92 @@
+#include "Benchmark.hpp"
+
+#include "Client.hpp"
+
+// Head of the responses of a connection: the status line alone, the Date and
+// Last-Modified headers of 16 files, then the whole head of a file and of an
+// error page (status line, basic and content headers, and a header kept in the
+// message), written into a new buffer like the response builders do.
+
+namespace
+{
+  const StatusCode  kCodes[] = {k200, k201, k204, k301, k400, k404, k405, k413, k500, k505};
+  const size_t      kCodeCount = sizeof(kCodes) / sizeof(kCodes[0]);
+
+  struct StatusLines
+  {
+    size_t  bytes;
+
+    StatusLines() : bytes(0) {}
+
+    void  run()
+    {
+      for (size_t i = 0; i < kCodeCount; i++)
+      {
+        std::string response;
+        res_builder::BuildStatusLine(kCodes[i], response);
+        bytes += response.size();
+      }
+    }
+  };
+
+  struct Dates
+  {
+    size_t  bytes;
+
+    Dates() : bytes(0) {}
+
+    void  run()
+    {
+      std::string response;
+      for (time_t i = 0; i < 16; i++)
+      {
+        res_builder::AppendDateHeader(response);
+        res_builder::AppendLastModifiedHeader(response, 1721586261 + i * 3600);
+      }
+      bytes += response.size();
+    }
+  };
+
+  struct Head
+  {
+    Client      clt;
+    StatusCode  code;
+    const char  *type;
+    size_t      length;
+    size_t      bytes;
+
+    Head(StatusCode code, const char *type, size_t length)
+    : code(code), type(type), length(length), bytes(0)
+    {
+      clt.keepAlive = (code == k200);
+    }
+
+    void  run()
+    {
+      std::string response;
+      res_builder::BuildStatusLine(code, response);
+      res_builder::BuildBasicHeaders(&clt, response);
+      res_builder::BuildContentHeaders(&clt, response, type, "", length);
+      clt.res.addNewPair<HeaderString>(kHeaderLocation, "/images/2024/holiday/beach.jpg");
+      clt.res.appendHeaders(response);
+      bytes += response.size();
+      clt.res.reset();
+    }
+  };
+}
+
+int main()
+{
+  StatusLines status_lines;
+  Dates       dates;
+  Head        file(k200, "image/jpeg", 48213);
+  Head        error(k404, "text/html", 152);
+
+  double nanoseconds = RunBenchmark("10 status lines", status_lines, 1000000);
+  std::printf("%-40s %10.1f ns\n", "    per line", nanoseconds / kCodeCount);
+  nanoseconds = RunBenchmark("Date and Last-Modified of 16 files", dates, 200000);
+  std::printf("%-40s %10.1f ns\n", "    per file", nanoseconds / 16);
+  RunBenchmark("head of a file response", file, 500000);
+  RunBenchmark("head of an error page, connection close", error, 500000);
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <cstring>
+
+#include "Arena/Arena.hpp"
+
+TEST(Arena, grows_past_its_block_size)
+{
+  Arena arena(64);
+  char* first = static_cast<char*>(arena.allocate(48));
+  char* second = static_cast<char*>(arena.allocate(48));
+  char* large = static_cast<char*>(arena.allocate(1000));
+  std::memset(large, 'x', 1000);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(second) % DEFAULT_ALIGNMENT, 0u);
+  EXPECT_NE(first, second);
+  ArenaStatistics statistics = arena.statistics();
+  EXPECT_EQ(statistics.block_allocations, 3u);
+  EXPECT_EQ(statistics.chain_high_water, 3u);
+  EXPECT_GE(statistics.high_water, 48u + 48u + 1000u);
+}
+
+TEST(Arena, rollback_across_blocks_reuses_the_free_blocks)
+{
+  Arena arena(64);
+  arena.allocate(32);
+  ArenaSnapshot snapshot = arena.snapshot();
+  void* after_snapshot = arena.allocate(16);
+  for (int i = 0; i < 10; i++)
+    arena.allocate(48);
+  size_t allocated = arena.statistics().block_allocations;
+  arena.rollback(snapshot);
+  EXPECT_EQ(arena.allocate(16), after_snapshot);
+  for (int i = 0; i < 10; i++)
+    arena.allocate(48);
+  EXPECT_EQ(arena.statistics().block_allocations, allocated);
+  arena.clear();
+  EXPECT_EQ(arena.statistics().blocks, allocated);
+}
+
+TEST(Arena, constructs_the_objects_it_allocates)
+{
+  Arena arena(64);
+  int* numbers = arena.allocate<int>(40);
+  for (int i = 0; i < 40; i++)
+    EXPECT_EQ(numbers[i], 0);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "Arena/RequestArena.hpp"
+#include "Response.hpp"
+
+TEST(RequestArena, reset_reuses_the_same_memory)
+{
+  RequestArena arena(256);
+  void* first = arena.allocate(24);
+  void* second = arena.allocate(24);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(second) % DEFAULT_ALIGNMENT, 0u);
+  EXPECT_NE(first, second);
+  arena.reset();
+  EXPECT_EQ(arena.allocate(24), first);
+  EXPECT_EQ(arena.blocks(), 1u);
+}
+
+TEST(RequestArena, grows_by_blocks_kept_after_reset)
+{
+  RequestArena arena(256);
+  for (int i = 0; i < 40; i++)
+    arena.allocate(32);
+  arena.allocate(1000);
+  size_t blocks = arena.blocks();
+  EXPECT_GT(blocks, 1u);
+  arena.reset();
+  for (int i = 0; i < 40; i++)
+    arena.allocate(32);
+  arena.allocate(1000);
+  EXPECT_EQ(arena.blocks(), blocks);
+}
+
+TEST(RequestArena, copied_message_owns_its_headers)
+{
+  Response original;
+  original.addNewPair<HeaderString>("Server", "Webserv");
+  original.addNewPair<HeaderString>("Server", "ignored");
+  original.addNewPair<HeaderInt>("Content-Length", 42);
+  Response copy(original);
+  original.reset();
+  EXPECT_EQ(original.returnValueAsPointer("Server"), static_cast<HeaderValue*>(NULL));
+  ASSERT_NE(copy.returnValueAsPointer("Server"), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(static_cast<HeaderString*>(copy.returnValueAsPointer("Server"))->content(), "Webserv");
+  EXPECT_EQ(static_cast<HeaderInt*>(copy.returnValueAsPointer("Content-Length"))->content(), 42);
+}
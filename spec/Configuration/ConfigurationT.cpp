@@ -18,7 +18,7 @@
 
 TEST(TestConfiguration0, all_server_sockets)
 {
-  Configuration config(8);
+  Configuration config;
   EXPECT_DEATH({
     std::vector<const uri::Authority *> sockets = config.all_server_sockets();
   }, "Assertion.*");
@@ -26,7 +26,7 @@ TEST(TestConfiguration0, all_server_sockets)
 
 TEST(TestConfiguration0, query_no_main_block)
 {
-  Configuration config(8);
+  Configuration config;
 
   ConfigurationQueryResult result = config.query(3, "hi.com", "/omg/what.html");
   ASSERT_TRUE(result.is_empty());
@@ -34,7 +34,7 @@ TEST(TestConfiguration0, query_no_main_block)
 
 TEST(TestConfiguration0, query_empty)
 {
-  Configuration config(8);
+  Configuration config;
 
   config.set_main_block(new directive::MainBlock());
   ConfigurationQueryResult result = config.query(3, "hi.com", "/omg/what.html");
@@ -122,6 +122,8 @@ TEST_F(TestConfiguration1, query_correct_location_property2)
   ASSERT_EQ(result.query->match_path, "/omg/");
   ASSERT_EQ(result.query->allowed_methods, constants::kDefaultAllowedMethods);
   ASSERT_EQ(result.query->client_max_body_size, constants::kDefaultClientMaxBodySize); // 1M
+  ASSERT_EQ(result.query->client_header_buffer_size, constants::kDefaultClientHeaderBufferSize);
+  ASSERT_EQ(result.query->client_body_buffer_size, constants::kDefaultClientBodyBufferSize);
   ASSERT_TRUE(result.query->redirect == NULL);
   {
     std::vector<const directive::Cgi*>*  cgis = &result.query->cgis;
@@ -140,9 +142,12 @@ TEST_F(TestConfiguration1, query_correct_location_property2)
   ASSERT_EQ(result.query->root, "/var/www/omg");
   ASSERT_EQ(result.query->autoindex, constants::kDefaultAutoindex);
   ASSERT_EQ(result.query->mime_types, &constants::kDefaultMimeTypes);
+  ASSERT_EQ(result.query->default_type, constants::kDefaultMimeType);
   ASSERT_EQ(result.query->error_pages.size(), static_cast<size_t>(0));
   ASSERT_EQ(result.query->access_log, "/var/logs/access.log");
   ASSERT_EQ(result.query->error_log, "/var/logs/error.log");
+  ASSERT_EQ(result.query->tcp_nodelay, constants::kDefaultTcpNodelay);
+  ASSERT_EQ(result.query->tcp_nopush, constants::kDefaultTcpNopush);
 }
 
 ///////////////////////////////////////////////
@@ -15,7 +15,7 @@ class TestConfiguration1 : public ::testing::Test
 {
 public:
   TestConfiguration1()
-    : main_block_(NULL), config_(8) {}
+    : main_block_(NULL), config_() {}
   ~TestConfiguration1() {}
 protected:
   directive::MainBlock* main_block_;
@@ -45,7 +45,7 @@ class TestConfiguration2 : public ::testing::Test
 {
 public:
   TestConfiguration2()
-    : main_block_(NULL), config_(8) {}
+    : main_block_(NULL), config_() {}
   ~TestConfiguration2() {}
 protected:
   directive::MainBlock* main_block_;
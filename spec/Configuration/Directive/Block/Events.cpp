@@ -72,3 +72,82 @@ TEST_F(TestDirectiveEvents, worker_connections)
   ASSERT_EQ(test_target_.worker_connections().is_ok(), true);
   ASSERT_EQ(test_target_.worker_connections().value(), static_cast<size_t>(1000));
 }
+
+TEST_F(TestDirectiveEvents, shutdown_timeout_empty)
+{
+  ASSERT_EQ(test_target_.shutdown_timeout().is_ok(), false);
+}
+
+TEST_F(TestDirectiveEvents, shutdown_timeout)
+{
+  directive::ShutdownTimeout*  shutdown_timeout = new directive::ShutdownTimeout();
+  shutdown_timeout->set(5);
+  test_target_.add_directive(shutdown_timeout);
+  ASSERT_EQ(test_target_.shutdown_timeout().is_ok(), true);
+  ASSERT_EQ(test_target_.shutdown_timeout().value(), static_cast<size_t>(5));
+}
+
+TEST_F(TestDirectiveEvents, multi_accept_empty)
+{
+  ASSERT_EQ(test_target_.multi_accept().is_ok(), false);
+}
+
+TEST_F(TestDirectiveEvents, multi_accept)
+{
+  directive::MultiAccept*  multi_accept = new directive::MultiAccept();
+  multi_accept->set(16);
+  test_target_.add_directive(multi_accept);
+  ASSERT_EQ(test_target_.multi_accept().is_ok(), true);
+  ASSERT_EQ(test_target_.multi_accept().value(), static_cast<size_t>(16));
+}
+
+TEST_F(TestDirectiveEvents, use_empty)
+{
+  ASSERT_EQ(test_target_.use().is_ok(), false);
+}
+
+TEST_F(TestDirectiveEvents, use)
+{
+  directive::Use*  use = new directive::Use();
+  use->set("poll");
+  test_target_.add_directive(use);
+  ASSERT_EQ(test_target_.use().is_ok(), true);
+  ASSERT_EQ(test_target_.use().value(), "poll");
+}
+
+TEST_F(TestDirectiveEvents, worker_threads_empty)
+{
+  ASSERT_EQ(test_target_.worker_threads().is_ok(), false);
+}
+
+TEST_F(TestDirectiveEvents, worker_threads)
+{
+  directive::WorkerThreads*  worker_threads = new directive::WorkerThreads();
+  worker_threads->set(4);
+  test_target_.add_directive(worker_threads);
+  ASSERT_EQ(test_target_.worker_threads().is_ok(), true);
+  ASSERT_EQ(test_target_.worker_threads().value(), static_cast<size_t>(4));
+}
+
+TEST_F(TestDirectiveEvents, aio_threads_empty)
+{
+  ASSERT_EQ(test_target_.aio_threads().is_ok(), false);
+}
+
+TEST_F(TestDirectiveEvents, aio_threads)
+{
+  directive::AioThreads*  aio_threads = new directive::AioThreads();
+  aio_threads->set(0);
+  test_target_.add_directive(aio_threads);
+  ASSERT_EQ(test_target_.aio_threads().is_ok(), true);
+  ASSERT_EQ(test_target_.aio_threads().value(), static_cast<size_t>(0));
+}
+
+TEST_F(TestDirectiveEvents, cpu_threads)
+{
+  directive::CpuThreads*  cpu_threads = new directive::CpuThreads();
+  cpu_threads->set(2);
+  test_target_.add_directive(cpu_threads);
+  ASSERT_EQ(test_target_.cpu_threads().is_ok(), true);
+  ASSERT_EQ(test_target_.cpu_threads().value(), static_cast<size_t>(2));
+}
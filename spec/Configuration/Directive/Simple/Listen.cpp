@@ -1,4 +1,5 @@
 #include "./Simple.hpp"
+#include "constants.hpp"
 
 #include <gtest/gtest.h>
 
@@ -38,6 +39,23 @@ TEST(TestDirectiveListen, set_context)
   ASSERT_EQ(directive.index(), 2);
 }
 
+TEST(TestDirectiveListen, options)
+{
+  directive::Listen directive;
+  ASSERT_EQ(directive.options().backlog, constants::kDefaultListenBacklog);
+  ASSERT_EQ(directive.options().defer_accept, 0);
+  ASSERT_EQ(directive.options().fastopen, 0);
+  ASSERT_EQ(directive.options().rcvbuf, 0);
+  ASSERT_EQ(directive.options().sndbuf, 0);
+  directive::ListenOptions options;
+  options.backlog = 1024;
+  options.sndbuf = 65536;
+  directive.set_options(options);
+  directive::Listen directive2(directive);
+  ASSERT_EQ(directive2.options().backlog, 1024);
+  ASSERT_EQ(directive2.options().sndbuf, 65536);
+}
+
 TEST_P(TestDirectiveListen, add)
 {
   using Sockets = std::vector<uri::Authority>;
@@ -149,6 +149,46 @@ TEST_F(TestFilledDirectiveMimeTypes, query_incorrect_key)
   ASSERT_EQ(test_target_.query("wrong").is_ok(), false);
 }
 
+TEST_F(TestFilledDirectiveMimeTypes, find_type_without_case)
+{
+  ASSERT_NE(test_target_.find_type("HTML"), (const std::string*)NULL);
+  ASSERT_EQ(*test_target_.find_type("HTML"), "text/html");
+  ASSERT_EQ(*test_target_.find_type("Png"), "image/png");
+  ASSERT_EQ(*test_target_.find_type("gif"), "image/gif");
+  ASSERT_EQ(test_target_.find_type("wrong"), (const std::string*)NULL);
+  ASSERT_EQ(test_target_.find_type(""), (const std::string*)NULL);
+}
+
+TEST_F(TestFilledDirectiveMimeTypes, find_canonical_extension)
+{
+  ASSERT_EQ(*test_target_.find_extension("text/html"), "html");
+  ASSERT_EQ(*test_target_.find_extension("IMAGE/JPEG"), "jpg");
+  ASSERT_EQ(*test_target_.find_extension("text/xml"), "rss");
+  // gif was listed with another type first
+  ASSERT_EQ(*test_target_.find_extension("image/gif"), "gif");
+  ASSERT_EQ(test_target_.find_extension("wrongg"), (const std::string*)NULL);
+}
+
+TEST_F(TestFilledDirectiveMimeTypes, types_listed_once)
+{
+  const std::vector<std::string>  expected = {
+    "text/html", "image/gif", "text/css", "image/jpeg",
+    "application/x-javascript", "text/xml", "image/png"
+  };
+  ASSERT_EQ(test_target_.types(), expected);
+}
+
+TEST_F(TestFilledDirectiveMimeTypes, copy_has_its_own_index)
+{
+  directive::MimeTypes* copy = new directive::MimeTypes(test_target_);
+  directive::MimeTypes  assigned;
+
+  assigned = *copy;
+  delete copy;
+  ASSERT_EQ(*assigned.find_type("css"), "text/css");
+  ASSERT_EQ(*assigned.find_extension("image/png"), "png");
+}
+
 INSTANTIATE_TEST_SUITE_P(mime_types, TestDirectiveMimeTypes, testing::Values(
   MimeTypeVector(),
 	MimeTypeVector{
@@ -80,6 +80,7 @@ protected:
     test_target_.add("xml", "text/xml");
     test_target_.add("shtml", "text/html");
     test_target_.add("png", "image/png");
+    test_target_.build_indexes();
   }
 };
 
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "Configuration.hpp"
+#include "Configuration/Cache/PathCache.hpp"
+
+static cache::ResolvedPath  Resolved(const std::string& path)
+{
+  cache::ResolvedPath resolved;
+
+  resolved.normalized_path = path;
+  resolved.path = "/var/www" + path;
+  return resolved;
+}
+
+TEST(PathCache, finds_by_socket_host_and_raw_path)
+{
+  Configuration     config;
+  cache::PathCache  cache;
+
+  EXPECT_EQ(cache.find(&config, 3, "hi.com", "/a"), (const cache::ResolvedPath*)NULL);
+  cache.insert(&config, 3, "hi.com", "/a", Resolved("/a"));
+  const cache::ResolvedPath* found = cache.find(&config, 3, "hi.com", "/a");
+  ASSERT_NE(found, (const cache::ResolvedPath*)NULL);
+  EXPECT_EQ(found->path, "/var/www/a");
+  EXPECT_EQ(cache.find(&config, 4, "hi.com", "/a"), (const cache::ResolvedPath*)NULL);
+  EXPECT_EQ(cache.find(&config, 3, "wtf.fr", "/a"), (const cache::ResolvedPath*)NULL);
+  EXPECT_EQ(cache.find(&config, 3, "hi.com", "/a/"), (const cache::ResolvedPath*)NULL);
+}
+
+TEST(PathCache, evicts_the_least_recently_used_path)
+{
+  Configuration     config;
+  cache::PathCache  cache;
+
+  for (size_t i = 0; i < cache::PathCache::kCapacity; i++)
+  {
+    std::ostringstream path;
+    path << "/" << i;
+    cache.insert(&config, 3, "", path.str(), Resolved(path.str()));
+  }
+  EXPECT_EQ(cache.size(), cache::PathCache::kCapacity);
+  // "/0" becomes the most recently used, "/1" the least
+  ASSERT_NE(cache.find(&config, 3, "", "/0"), (const cache::ResolvedPath*)NULL);
+  cache.insert(&config, 3, "", "/new", Resolved("/new"));
+  EXPECT_EQ(cache.size(), cache::PathCache::kCapacity);
+  EXPECT_NE(cache.find(&config, 3, "", "/0"), (const cache::ResolvedPath*)NULL);
+  EXPECT_EQ(cache.find(&config, 3, "", "/1"), (const cache::ResolvedPath*)NULL);
+  EXPECT_NE(cache.find(&config, 3, "", "/new"), (const cache::ResolvedPath*)NULL);
+}
+
+TEST(PathCache, is_emptied_by_another_configuration)
+{
+  Configuration     config;
+  Configuration     reloaded;
+  cache::PathCache  cache;
+
+  EXPECT_NE(config.generation(), reloaded.generation());
+  cache.insert(&config, 3, "", "/a", Resolved("/a"));
+  EXPECT_EQ(cache.find(&reloaded, 3, "", "/a"), (const cache::ResolvedPath*)NULL);
+  EXPECT_EQ(cache.size(), 0u);
+}
@@ -17,5 +17,7 @@ TEST(Constants, kDefaultMimeTypes)
   ASSERT_EQ(constants::kDefaultMimeTypes.query("gif").value(), "image/gif");
   ASSERT_EQ(constants::kDefaultMimeTypes.query("jpg").is_ok(), true);
   ASSERT_EQ(constants::kDefaultMimeTypes.query("jpg").value(), "image/jpeg");
-  ASSERT_EQ(constants::kDefaultMimeTypes.get().size(), static_cast<size_t>(3));
+  ASSERT_EQ(constants::kDefaultMimeTypes.query("css").value(), "text/css");
+  ASSERT_EQ(constants::kDefaultMimeTypes.query("png").value(), "image/png");
+  ASSERT_EQ(constants::kDefaultMimeTypes.get().size(), static_cast<size_t>(10));
 }
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+
+#include "Client.hpp"
+
+// a root directory with a file, a link inside the root and a link out of it
+class FileBeneath : public testing::Test
+{
+  protected:
+    std::string           root_;
+    cache::LocationQuery  location_;
+
+    void  SetUp()
+    {
+      char  directory[] = "/tmp/webserv_beneath_XXXXXX";
+      ASSERT_NE(mkdtemp(directory), (char*)NULL);
+      root_ = directory;
+      int fd = open((root_ + "/index.html").c_str(), O_CREAT | O_WRONLY, 0644);
+      ASSERT_NE(fd, -1);
+      close(fd);
+      ASSERT_EQ(symlink("index.html", (root_ + "/inside").c_str()), 0);
+      ASSERT_EQ(symlink("/etc", (root_ + "/outside").c_str()), 0);
+      location_.root = root_;
+      location_.root_fd = open(root_.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+      ASSERT_NE(location_.root_fd, -1);
+    }
+
+    void  TearDown()
+    {
+      close(location_.root_fd);
+      unlink((root_ + "/outside").c_str());
+      unlink((root_ + "/inside").c_str());
+      unlink((root_ + "/index.html").c_str());
+      rmdir(root_.c_str());
+    }
+};
+
+TEST_F(FileBeneath, resolves_from_the_root)
+{
+  struct stat buff;
+
+  EXPECT_EQ(process::file::StatBeneath(&location_, root_ + "/index.html", &buff), 0);
+  EXPECT_TRUE(S_ISREG(buff.st_mode));
+  EXPECT_EQ(process::file::StatBeneath(&location_, root_ + "/", &buff), 0);
+  EXPECT_TRUE(S_ISDIR(buff.st_mode));
+  EXPECT_EQ(process::file::AccessBeneath(&location_, root_ + "/index.html", R_OK), 0);
+
+  int fd = process::file::OpenBeneath(&location_, root_ + "/inside", O_RDONLY);
+  EXPECT_NE(fd, -1);
+  close(fd);
+  DIR*  dir_stream = process::file::OpenDirBeneath(&location_, root_);
+  ASSERT_NE(dir_stream, (DIR*)NULL);
+  closedir(dir_stream);
+}
+
+TEST_F(FileBeneath, does_not_leave_the_root)
+{
+  struct stat buff;
+
+  EXPECT_EQ(process::file::StatBeneath(&location_, root_ + "/missing", &buff), -1);
+  EXPECT_EQ(errno, ENOENT);
+  // without openat2 the link is followed, the normalized paths of requests
+  // then only leave the root through the links created in it
+  int fd = process::file::OpenBeneath(&location_, root_ + "/outside/hostname", O_RDONLY);
+#ifdef SYS_openat2
+  EXPECT_EQ(fd, -1);
+  EXPECT_EQ(errno, EXDEV);
+#endif
+  if (fd != -1)
+    close(fd);
+}
+
+TEST_F(FileBeneath, writes_and_deletes_from_a_parent_beneath_the_root)
+{
+  struct Client clt;
+  clt.config.query = &location_;
+
+  EXPECT_TRUE(process::file::CreateDirsBeneath(&location_, root_ + "/upload/files/new.txt"));
+  clt.path = root_ + "/upload/files/new.txt";
+  EXPECT_TRUE(process::file::ModifyFile(&clt));
+  EXPECT_EQ(process::file::AccessBeneath(&location_, clt.path, W_OK), 0);
+  EXPECT_TRUE(process::file::DeleteFile(&clt));
+  EXPECT_EQ(process::file::AccessBeneath(&location_, clt.path, F_OK), -1);
+  EXPECT_EQ(rmdir((root_ + "/upload/files").c_str()), 0);
+  EXPECT_EQ(rmdir((root_ + "/upload").c_str()), 0);
+#ifdef SYS_openat2
+  EXPECT_EQ(process::file::AccessBeneath(&location_, root_ + "/outside/hostname", R_OK), -1);
+  EXPECT_FALSE(process::file::CreateDirsBeneath(&location_, root_ + "/outside/webserv/new.txt"));
+  clt.path = root_ + "/outside/hostname";
+  EXPECT_FALSE(process::file::DeleteFile(&clt));
+  EXPECT_EQ(errno, EXDEV);
+#endif
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cctype>
+
+#include "Request.hpp"
+#include "Response.hpp"
+
+TEST(HTTPMessage, interns_known_names_case_insensitively)
+{
+  EXPECT_EQ(header::Intern("content-length"), kHeaderContentLength);
+  EXPECT_EQ(header::Intern("HOST"), kHeaderHost);
+  EXPECT_EQ(header::Intern("Transfer-Encoding"), kHeaderTransferEncoding);
+  EXPECT_EQ(header::Intern("Content-Lengt"), kHeaderUnknown);
+  EXPECT_EQ(header::Intern("X-Forwarded-For"), kHeaderUnknown);
+  EXPECT_EQ(header::Name(kHeaderLastModified), "Last-Modified");
+}
+
+TEST(HTTPMessage, interns_every_known_name_and_no_near_miss)
+{
+  for (int id = 0; id < kHeaderUnknown; id++)
+  {
+    std::string name = header::Name(static_cast<HeaderId>(id));
+    EXPECT_EQ(header::Intern(name), id) << name;
+    for (size_t i = 0; i < name.size(); i++)
+      name[i] = std::toupper(name[i]);
+    EXPECT_EQ(header::Intern(name), id) << name;
+  }
+  const char* browser_names[] = {
+    "Accept-Language", "Accept-Encoding", "Cache-Control", "Cookie", "Origin",
+    "Sec-Fetch-Dest", "Upgrade-Insecure-Requests", "Secret", "Accent", "User-Agant", ""
+  };
+  for (size_t i = 0; i < sizeof(browser_names) / sizeof(browser_names[0]); i++)
+    EXPECT_EQ(header::Intern(browser_names[i]), kHeaderUnknown) << browser_names[i];
+}
+
+TEST(HTTPMessage, finds_headers_by_id_and_by_name)
+{
+  Response response;
+  response.addNewPair<HeaderInt>(kHeaderContentLength, 12);
+  response.addNewPair<HeaderString>("x-request-id", "abc");
+  response.addNewPair<HeaderString>("X-Request-Id", "ignored");
+  ASSERT_NE(response.returnValueAsPointer("CONTENT-LENGTH"), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(response.returnValueAsPointer("content-length"), response.returnValueAsPointer(kHeaderContentLength));
+  ASSERT_NE(response.returnValueAsPointer("X-REQUEST-ID"), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(static_cast<HeaderString*>(response.returnValueAsPointer("X-REQUEST-ID"))->content(), "abc");
+  EXPECT_EQ(response.returnValueAsPointer(kHeaderHost), static_cast<HeaderValue*>(NULL));
+}
+
+TEST(HTTPMessage, writes_known_headers_in_id_order_then_the_others)
+{
+  Response response;
+  response.addNewPair<HeaderString>(kHeaderServer, "Webserv");
+  response.addNewPair<HeaderString>("X-Frame-Options", "DENY");
+  response.addNewPair<HeaderInt>(kHeaderContentLength, 0);
+  EXPECT_EQ(response.returnMapAsString(), "Content-Length: 0\r\nServer: Webserv\r\nX-Frame-Options: DENY\r\n\r\n");
+  response.reset();
+  EXPECT_EQ(response.returnMapAsString(), "\r\n");
+}
+
+TEST(HTTPMessage, appends_the_headers_after_the_status_line)
+{
+  Response response;
+  StringVector methods;
+  methods.push_back("GET");
+  methods.push_back("POST");
+  response.addNewPair<HeaderStringVector>(kHeaderAllow, methods);
+  response.addNewPair<HeaderInt>("X-Offset", -120);
+  std::string head = "HTTP/1.1 405 Method Not Allowed\r\n";
+  response.appendHeaders(head);
+  EXPECT_EQ(head, "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, POST\r\nX-Offset: -120\r\n\r\n");
+}
+
+TEST(HTTPMessage, analyses_raw_values_on_first_access)
+{
+  Request request;
+  std::string content_type("text/html; charset=utf-8");
+  request.addRawValue(kHeaderContentType, content_type.data(), content_type.size());
+  request.addRawValue(kHeaderContentType, "text/plain", 10);
+  request.addRawValue(kHeaderConnection, "close", 5);
+  request.addRawValue(kHeaderReferer, "http://localhost/", 17);
+  content_type.assign(content_type.size(), 'x'); // the raw value is a copy
+
+  HeaderString* value = static_cast<HeaderString*>(request.returnValueAsPointer("content-type"));
+  ASSERT_NE(value, static_cast<HeaderString*>(NULL));
+  EXPECT_EQ(value->content(), "text/html");
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderContentType), value);
+  ASSERT_NE(request.returnValueAsPointer(kHeaderConnection), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderConnection)->to_string(), "close");
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderReferer)->to_string(), "http://localhost/");
+
+  Request copy(request);
+  request.cleanHeaderMap();
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderReferer), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(copy.returnValueAsPointer(kHeaderReferer)->to_string(), "http://localhost/");
+}
+
+TEST(HTTPMessage, drops_an_invalid_raw_value)
+{
+  Request request;
+  request.addRawValue(kHeaderContentType, "not a media type", 16);
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderContentType), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderContentType), static_cast<HeaderValue*>(NULL));
+}
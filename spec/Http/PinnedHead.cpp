@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+#include "Http/Scanner.hpp"
+#include "Request.hpp"
+
+// Parses the head pinned in the request like the event loop does, and returns its length.
+static size_t  ParsePinnedHead(Request* request)
+{
+  const std::string& head = request->getPinnedHead();
+  size_t line_end = http_parser::FindNewLine(head.data(), head.size());
+  RequestLine request_line;
+  enum ParseError error = kNone;
+  EXPECT_EQ(AnalysisOriginFormRequestLine(head.data(), line_end, &request_line, &error), line_end);
+  request->swapRequestLine(request_line);
+  size_t fields_start = line_end + 2;
+  size_t fields_end = http_parser::FindEmptyLine(head.data() + fields_start, head.size() - fields_start);
+  temporary::arena.clear();
+  http_parser::ParseOutput parsed = http_parser::ParseFields(http_parser::StringSlice(head.data() + fields_start, fields_end + 4));
+  EXPECT_EQ(AnalysisRequestHeaders(static_cast<http_parser::PTNodeFields*>(parsed.result), request), kNone);
+  temporary::arena.clear();
+  return fields_start + parsed.length + 2;
+}
+
+TEST(PinnedHead, refers_to_the_received_bytes)
+{
+  std::string received = "POST /upload/a%20b?x=1 HTTP/1.1\r\nHost: localhost\r\nReferer: http://localhost/\r\nContent-Length: 5\r\n\r\nhelloGET / HTTP/1.1\r\n";
+  Request request;
+  request.pinHead(received);
+  EXPECT_TRUE(received.empty());
+  size_t head_length = ParsePinnedHead(&request);
+  request.unpinRest(received, head_length, 5);
+
+  const std::string& head = request.getPinnedHead();
+  EXPECT_EQ(request.getRequestTarget().path, StringView("/upload/a%20b"));
+  EXPECT_EQ(request.getRequestTarget().query, StringView("x=1"));
+  EXPECT_EQ(request.getRequestTarget().path.bytes, head.data() + 5);
+  EXPECT_TRUE(request.hasPinnedBody());
+  EXPECT_EQ(request.getRequestBody(), StringView("hello"));
+  EXPECT_EQ(request.getRequestBody().bytes, head.data() + head_length);
+  // the next request goes back to the receive buffer
+  EXPECT_EQ(received, "GET / HTTP/1.1\r\n");
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderReferer)->to_string(), "http://localhost/");
+}
+
+TEST(PinnedHead, is_copied_with_the_request)
+{
+  std::string received = "POST /a?b HTTP/1.1\r\nHost: localhost\r\nReferer: http://localhost/\r\nContent-Length: 3\r\n\r\nabc";
+  Request* request = new Request();
+  request->pinHead(received);
+  request->unpinRest(received, ParsePinnedHead(request), 3);
+
+  Request copy(*request);
+  delete request;
+  EXPECT_EQ(copy.getRequestTarget().path, StringView("/a"));
+  EXPECT_EQ(copy.getRequestTarget().path.bytes, copy.getPinnedHead().data() + 5);
+  EXPECT_EQ(copy.getRequestTarget().query, StringView("b"));
+  EXPECT_EQ(copy.getRequestBody(), StringView("abc"));
+  EXPECT_EQ(copy.returnValueAsPointer(kHeaderReferer)->to_string(), "http://localhost/");
+
+  copy.reset();
+  EXPECT_TRUE(copy.getPinnedHead().empty());
+  EXPECT_FALSE(copy.hasPinnedBody());
+  EXPECT_TRUE(copy.getRequestTarget().path.empty());
+}
+
+TEST(PinnedHead, keeps_a_body_read_later_in_the_request)
+{
+  std::string received = "POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\n\r\na";
+  Request request;
+  request.pinHead(received);
+  request.unpinRest(received, ParsePinnedHead(&request), 0);
+  EXPECT_FALSE(request.hasPinnedBody());
+  EXPECT_EQ(received, "a");
+  request.requestBody_ = "abc";
+  EXPECT_EQ(request.getRequestBody(), StringView("abc"));
+}
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+#include "Request.hpp"
+
+static enum ParseError AnalyseFields(const std::string& fields, Request* request)
+{
+  http_parser::ParseOutput parsed = http_parser::ParseFields(http_parser::StringSlice(fields.data(), fields.size()));
+  enum ParseError error = AnalysisRequestHeaders(static_cast<http_parser::PTNodeFields*>(parsed.result), request);
+  temporary::arena.clear();
+  return error;
+}
+
+TEST(RequestHeaders, rejects_an_invalid_connection_or_content_type_at_once)
+{
+  Request request;
+  EXPECT_EQ(AnalyseFields("Host: localhost\r\nContent-Type: not a media type\r\n\r\n", &request), kWrongHeader);
+  request.cleanHeaderMap();
+  EXPECT_EQ(AnalyseFields("Host: localhost\r\nConnection: keep alive\r\n\r\n", &request), kWrongHeader);
+  request.cleanHeaderMap();
+  // the raw value of User-Agent refers to the fields
+  std::string fields = "Host: localhost\r\nConnection: close\r\nContent-Type: text/html; charset=utf-8\r\nUser-Agent: spec\r\n\r\n";
+  EXPECT_EQ(AnalyseFields(fields, &request), kNone);
+  ASSERT_NE(request.returnValueAsPointer(kHeaderConnection), static_cast<HeaderValue*>(NULL));
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderContentType)->to_string(), "text/html");
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderUserAgent)->to_string(), "spec");
+}
+
+TEST(RequestHeaders, reads_every_connection_option)
+{
+  Request request;
+  EXPECT_EQ(AnalyseFields("Host: localhost\r\nConnection: Upgrade, HTTP2-Settings,, close\r\n\r\n", &request), kNone);
+  ASSERT_NE(request.returnValueAsPointer(kHeaderConnection), static_cast<HeaderValue*>(NULL));
+  request.cleanHeaderMap();
+  EXPECT_EQ(AnalyseFields("Host: localhost\r\nConnection: keep-alive,\r\n\r\n", &request), kNone);
+  EXPECT_EQ(request.returnValueAsPointer(kHeaderConnection), static_cast<HeaderValue*>(NULL));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+
+// the target of the output refers to with_newline
+static enum ParseError  GeneralAnalysis(const std::string& line, const std::string& with_newline, RequestLine* output, size_t* length)
+{
+  temporary::arena.clear();
+  http_parser::ParseOutput parsed = http_parser::ParseRequestLine(
+      http_parser::StringSlice(with_newline.data(), with_newline.size()));
+  EXPECT_TRUE(parsed.is_valid()) << line;
+  enum ParseError error = AnalysisRequestLine(static_cast<http_parser::PTNodeRequestLine *>(parsed.result), output);
+  *length = parsed.length;
+  temporary::arena.clear();
+  return error;
+}
+
+TEST(OriginFormRequestLine, agrees_with_the_full_grammar)
+{
+  const char* lines[] = {
+    "GET / HTTP/1.1",
+    "GET /index.html HTTP/1.0",
+    "POST /upload/a/b/ HTTP/1.1",
+    "DELETE /a%20b//c?x=1&y=%2F/?z HTTP/1.1",
+    "GET /search? HTTP/1.1",
+    "PUT /file HTTP/1.1",
+    "get /lowercase HTTP/1.1",
+    "GET /x HTTP/3.0",
+  };
+  for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++)
+  {
+    RequestLine expected;
+    size_t expected_length = 0;
+    std::string with_newline = std::string(lines[i]) + "\r\n";
+    enum ParseError expected_error = GeneralAnalysis(lines[i], with_newline, &expected, &expected_length);
+
+    RequestLine fast;
+    enum ParseError error = kNone;
+    EXPECT_EQ(AnalysisOriginFormRequestLine(lines[i], std::strlen(lines[i]), &fast, &error), expected_length) << lines[i];
+    EXPECT_EQ(error, expected_error) << lines[i];
+    EXPECT_EQ(fast.method, expected.method) << lines[i];
+    EXPECT_EQ(fast.version, expected.version) << lines[i];
+    EXPECT_EQ(fast.request_target.path, expected.request_target.path) << lines[i];
+    EXPECT_EQ(fast.request_target.query, expected.request_target.query) << lines[i];
+  }
+}
+
+TEST(OriginFormRequestLine, leaves_other_forms_to_the_full_grammar)
+{
+  const char* lines[] = {
+    "GET http://localhost/index.html HTTP/1.1",
+    "CONNECT localhost:8080 HTTP/1.1",
+    "OPTIONS * HTTP/1.1",
+    "GET //network/path HTTP/1.1",
+    "GET  /two-spaces HTTP/1.1",
+    "GET /tab\tHTTP/1.1",
+    "GET /bad%zz HTTP/1.1",
+    "GET /trailing HTTP/1.1 ",
+    "GET /short HTTP/1",
+  };
+  for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++)
+  {
+    RequestLine output;
+    enum ParseError error = kNone;
+    EXPECT_EQ(AnalysisOriginFormRequestLine(lines[i], std::strlen(lines[i]), &output, &error), 0u) << lines[i];
+  }
+}
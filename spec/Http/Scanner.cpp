@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Http/Scanner.hpp"
+
+using namespace http_parser;
+
+static bool IsPathChar(int c)
+{
+  return (std::isalnum(c) || std::strchr("-._~!$&'()*+,;=:@%", c)) && c != 0 && c < 128;
+}
+
+TEST(Scanner, table_matches_the_rfc_classes)
+{
+  for (int c = 0; c < 256; c++)
+  {
+    char character = static_cast<char>(c);
+    bool ascii = (c > 0 && c < 128);
+    EXPECT_EQ(IsOfClass(character, kClassDigit), c >= '0' && c <= '9') << c;
+    EXPECT_EQ(IsOfClass(character, kClassTokenText),
+              ascii && (std::isalnum(c) || std::strchr("!#$%&'*+-.^_`|~", c))) << c;
+    EXPECT_EQ(IsOfClass(character, kClassSubDelims), ascii && std::strchr("!$&'()*+,;=", c)) << c;
+    EXPECT_EQ(IsOfClass(character, kClassGenDelims), ascii && std::strchr(":/?#[]", c)) << c;
+    EXPECT_EQ(IsOfClass(character, kClassFieldValue), (c >= 21 && c <= 126) || c >= 128) << c;
+    EXPECT_EQ(IsOfClass(character, kClassPathChar), IsPathChar(c)) << c;
+    EXPECT_EQ(IsOfClass(character, kClassQueryChar), IsPathChar(c) || c == '/' || c == '?') << c;
+  }
+}
+
+TEST(Scanner, kernels_agree_with_the_table)
+{
+  const CharacterSet* sets[] = {&kFieldValueSet, &kPathCharSet, &kQueryCharSet};
+  const ScanKernel  kernels[] = {kKernelSse2, kKernelAvx2};
+  std::srand(42);
+  for (int round = 0; round < 2000; round++)
+  {
+    // long runs of members with a stray byte somewhere
+    std::string bytes(std::rand() % 200, 'a');
+    for (size_t i = 0; i < bytes.size(); i++)
+      if (std::rand() % 64 == 0)
+        bytes[i] = static_cast<char>(std::rand() % 256);
+    for (size_t s = 0; s < 3; s++)
+    {
+      ASSERT_TRUE(UseKernel(kKernelScalar));
+      size_t expected = Span(bytes.data(), bytes.size(), *sets[s]);
+      for (size_t k = 0; k < 2; k++)
+      {
+        if (!UseKernel(kernels[k]))
+          continue;
+        EXPECT_EQ(Span(bytes.data(), bytes.size(), *sets[s]), expected) << KernelName();
+      }
+    }
+  }
+  UseKernel(kKernelBest);
+}
+
+TEST(Scanner, percent_encoding_cuts_the_span)
+{
+  const char* path = "/a%2Fb%zz/c";
+  EXPECT_EQ(SpanPercentEncoded(path + 1, std::strlen(path + 1), kPathCharSet), 5u);
+  const char* query = "q=a%20b/c?d%2";
+  EXPECT_EQ(SpanPercentEncoded(query, std::strlen(query), kQueryCharSet), 11u);
+}
+
+TEST(Scanner, finds_the_end_of_lines)
+{
+  std::string head("GET / HTTP/1.1\r\nHost: a\r\r\n\r\n");
+  EXPECT_EQ(FindNewLine(head.data(), head.size()), 14u);
+  EXPECT_EQ(FindEmptyLine(head.data(), head.size()), 24u);
+  EXPECT_EQ(FindEmptyLine(head.data(), head.size() - 1), head.size() - 1);
+}
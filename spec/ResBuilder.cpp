@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "Client.hpp"
+
+TEST(ResBuilder, serializes_the_status_lines)
+{
+  EXPECT_EQ(res_builder::StatusLine(k200), "HTTP/1.1 200 OK\r\n");
+  EXPECT_EQ(res_builder::StatusLine(k413), "HTTP/1.1 413 Request Entity Too Large\r\n");
+  EXPECT_EQ(res_builder::StatusLine(k505), "HTTP/1.1 505 HTTP Version Not Supported\r\n");
+  EXPECT_EQ(res_builder::StatusCodeAsString(k404), "404 Not Found");
+  EXPECT_EQ(res_builder::StatusLine(kError), "HTTP/1.1 \r\n");
+  EXPECT_EQ(res_builder::StatusCodeAsString(k000), "");
+
+  std::string response = "previous response";
+  res_builder::BuildStatusLine(k201, response);
+  EXPECT_EQ(response, "HTTP/1.1 201 Created\r\n");
+}
+
+TEST(ResBuilder, appends_header_lines)
+{
+  std::string response;
+  res_builder::AppendHeader(response, kHeaderContentLength, static_cast<size_t>(0));
+  res_builder::AppendHeader(response, kHeaderContentLength, static_cast<size_t>(18446744073709551615UL));
+  res_builder::AppendHeader(response, kHeaderContentType, "image/jpeg");
+  EXPECT_EQ(response, "Content-Length: 0\r\nContent-Length: 18446744073709551615\r\nContent-Type: image/jpeg\r\n");
+}
+
+TEST(ResBuilder, formats_last_modified_dates_keyed_by_mtime)
+{
+  std::string response;
+  res_builder::AppendLastModifiedHeader(response, 784111777);
+  res_builder::AppendLastModifiedHeader(response, 784111777);
+  res_builder::AppendLastModifiedHeader(response, 784111777 + 64); // same slot
+  res_builder::AppendLastModifiedHeader(response, 0);
+  EXPECT_EQ(response,
+    "Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+    "Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+    "Last-Modified: Sun, 06 Nov 1994 08:50:41 GMT\r\n"
+    "Last-Modified: Thu, 01 Jan 1970 00:00:00 GMT\r\n");
+}
+
+TEST(ResBuilder, formats_the_current_date)
+{
+  char expected[2][64];
+  time_t now = time(NULL);
+  for (int i = 0; i < 2; i++)
+  {
+    time_t second = now + i;
+    struct tm time_info;
+    gmtime_r(&second, &time_info);
+    strftime(expected[i], sizeof(expected[i]), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &time_info);
+  }
+  std::string response;
+  res_builder::AppendDateHeader(response);
+  EXPECT_TRUE(response == expected[0] || response == expected[1]) << response;
+}
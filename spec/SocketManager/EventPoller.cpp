@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+
+#include "socket_manager/EventPoller.hpp"
+
+namespace
+{
+  // one end of a socket pair in a pollfd vector, like the main loop keeps a client
+  struct Connection
+  {
+    int fds[2];
+    std::vector<struct pollfd> pfds;
+
+    explicit Connection(EventPoller& poller)
+    {
+      EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+      struct pollfd pfd;
+      pfd.fd = fds[0];
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      pfds.push_back(pfd);
+      poller.watch(pfds, 0, EventPoller::kConnection);
+    }
+
+    ~Connection() { close(fds[1]); }
+  };
+
+  // the kernel may need more than one wait for the operations of a chain
+  short WaitFor(EventPoller& poller, std::vector<struct pollfd>& pfds, size_t i)
+  {
+    for (int tries = 0; tries < 10 && pfds[i].revents == 0; tries++)
+      poller.wait(pfds, 100);
+    return pfds[i].revents;
+  }
+}
+
+TEST(EventPoller, epoll_follows_the_interest_changes)
+{
+  EventPoller poller;
+  if (poller.open("epoll") != EventPoller::kEpoll)
+    GTEST_SKIP() << "epoll is not available";
+  Connection connection(poller);
+  std::vector<struct pollfd>& pfds = connection.pfds;
+
+  EXPECT_EQ(poller.wait(pfds, 0), 0);
+  ASSERT_EQ(write(connection.fds[1], "a", 1), 1);
+  EXPECT_EQ(WaitFor(poller, pfds, 0), POLLIN);
+  poller.modify(pfds[0], POLLOUT);
+  EXPECT_EQ(pfds[0].events, POLLOUT);
+  poller.wait(pfds, 100);
+  EXPECT_EQ(pfds[0].revents, POLLOUT);
+  poller.modify(pfds[0], 0);
+  EXPECT_EQ(poller.wait(pfds, 0), 0);
+  EXPECT_EQ(pfds[0].revents, 0);
+  poller.close(connection.fds[0]);
+}
+
+TEST(EventPoller, io_uring_receives_into_provided_buffers)
+{
+  EventPoller poller;
+  if (poller.open("io_uring") != EventPoller::kIoUring)
+    GTEST_SKIP() << "io_uring is not available";
+  ASSERT_TRUE(poller.completes_io());
+  Connection connection(poller);
+  std::vector<struct pollfd>& pfds = connection.pfds;
+  std::string received("GET");
+
+  ASSERT_EQ(write(connection.fds[1], " /index.html", 12), 12);
+  EXPECT_EQ(WaitFor(poller, pfds, 0), POLLIN);
+  EXPECT_EQ(poller.receive(connection.fds[0], received), 12);
+  EXPECT_EQ(received, "GET /index.html");
+  errno = 0;
+  EXPECT_EQ(poller.receive(connection.fds[0], received), -1);
+  EXPECT_EQ(errno, EAGAIN);
+  close(connection.fds[1]);
+  connection.fds[1] = -1;
+  pfds[0].revents = 0;
+  EXPECT_EQ(WaitFor(poller, pfds, 0), POLLIN);
+  EXPECT_EQ(poller.receive(connection.fds[0], received), 0);
+  poller.close(connection.fds[0]);
+}
+
+TEST(EventPoller, io_uring_sends_the_output_queue_with_its_files)
+{
+  EventPoller poller;
+  if (poller.open("io_uring") != EventPoller::kIoUring)
+    GTEST_SKIP() << "io_uring is not available";
+  Connection connection(poller);
+  std::vector<struct pollfd>& pfds = connection.pfds;
+  char path[] = "/tmp/event_poller_XXXXXX";
+  int file = mkstemp(path);
+  ASSERT_NE(file, -1);
+  unlink(path);
+  ASSERT_EQ(write(file, "0123456789", 10), 10);
+  OutputQueue output;
+  std::string head("head ");
+  std::string tail(" tail");
+  output.push(head);
+  output.push_file(file, 2, 5);
+  output.push(tail);
+
+  poller.modify(pfds[0], POLLOUT);
+  EXPECT_EQ(poller.send(connection.fds[0], output, false), 1);
+  EXPECT_TRUE(output.empty());
+  EXPECT_EQ(WaitFor(poller, pfds, 0), POLLOUT);
+  EXPECT_EQ(poller.send(connection.fds[0], output, false), 0);
+  char buffer[64];
+  ssize_t length = read(connection.fds[1], buffer, sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, length > 0 ? length : 0), "head 23456 tail");
+  EXPECT_EQ(close(file), -1); // closed by the queue once sent
+  poller.close(connection.fds[0]);
+}
+
+TEST(EventPoller, io_uring_sends_more_than_the_socket_buffer_on_a_non_blocking_socket)
+{
+  EventPoller poller;
+  if (poller.open("io_uring") != EventPoller::kIoUring)
+    GTEST_SKIP() << "io_uring is not available";
+  Connection connection(poller);
+  std::vector<struct pollfd>& pfds = connection.pfds;
+  ASSERT_EQ(fcntl(connection.fds[0], F_SETFL, O_NONBLOCK), 0);
+  ASSERT_EQ(fcntl(connection.fds[1], F_SETFL, O_NONBLOCK), 0); // the next chains start in wait()
+  char path[] = "/tmp/event_poller_XXXXXX";
+  int file = mkstemp(path);
+  ASSERT_NE(file, -1);
+  unlink(path);
+  std::string content(1 << 20, 'f');
+  ASSERT_EQ(write(file, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+  OutputQueue output;
+  std::string head(1 << 16, 'h');
+  std::string expected = head + content;
+  output.push(head);
+  output.push_file(file, 0, content.size());
+
+  poller.modify(pfds[0], POLLOUT);
+  EXPECT_EQ(poller.send(connection.fds[0], output, false), 1);
+  std::string received;
+  char buffer[1 << 16];
+  for (int tries = 0; tries < 1000 && received.size() < expected.size(); tries++)
+  {
+    ssize_t length = read(connection.fds[1], buffer, sizeof(buffer));
+    if (length > 0)
+      received.append(buffer, length);
+    poller.wait(pfds, 10);
+  }
+  EXPECT_EQ(received.size(), expected.size());
+  EXPECT_TRUE(received == expected);
+  EXPECT_EQ(WaitFor(poller, pfds, 0), POLLOUT);
+  EXPECT_EQ(poller.send(connection.fds[0], output, false), 0);
+  poller.close(connection.fds[0]);
+}
+
+TEST(EventPoller, io_uring_accepts_with_a_multishot_accept)
+{
+  EventPoller poller;
+  if (poller.open("io_uring") != EventPoller::kIoUring)
+    GTEST_SKIP() << "io_uring is not available";
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in address;
+  socklen_t address_length = sizeof(address);
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(server, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)), 0);
+  ASSERT_EQ(listen(server, 8), 0);
+  ASSERT_EQ(getsockname(server, reinterpret_cast<struct sockaddr*>(&address), &address_length), 0);
+  std::vector<struct pollfd> pfds(1);
+  pfds[0].fd = server;
+  pfds[0].events = POLLIN;
+  poller.watch(pfds, 0, EventPoller::kListen);
+
+  int clients[3];
+  for (int i = 0; i < 3; i++)
+  {
+    clients[i] = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(clients[i], reinterpret_cast<struct sockaddr*>(&address), sizeof(address)), 0);
+  }
+  std::vector<int> accepted;
+  std::vector<int> all;
+  for (int tries = 0; tries < 10 && all.size() < 3; tries++)
+  {
+    poller.wait(pfds, 100);
+    if (pfds[0].revents & POLLIN)
+    {
+      // at most two at once, the third one waits for the next call
+      poller.accept(server, 2, accepted);
+      EXPECT_LE(accepted.size(), 2u);
+      all.insert(all.end(), accepted.begin(), accepted.end());
+    }
+  }
+  EXPECT_EQ(all.size(), 3u);
+  for (size_t i = 0; i < all.size(); i++)
+    close(all[i]);
+  for (int i = 0; i < 3; i++)
+    close(clients[i]);
+  poller.remove(server);
+  close(server);
+}
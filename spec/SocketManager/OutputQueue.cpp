@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "socket_manager/OutputQueue.hpp"
+
+TEST(OutputQueue, push_takes_the_string)
+{
+  OutputQueue queue;
+  std::string head("HTTP/1.1 200 OK\r\n\r\n");
+  std::string body("hello");
+
+  queue.push(head);
+  queue.push(body);
+  EXPECT_TRUE(head.empty());
+  EXPECT_TRUE(body.empty());
+  EXPECT_EQ(queue.size(), 24u);
+}
+
+TEST(OutputQueue, consume_moves_the_offset)
+{
+  OutputQueue queue;
+  std::string head("abc");
+  std::string body("defgh");
+  struct iovec iov[4];
+
+  queue.push(head);
+  queue.push(body);
+  queue.consume(2);
+  ASSERT_EQ(queue.to_iovec(iov, 4), 2);
+  EXPECT_EQ(std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "c");
+  EXPECT_EQ(std::string(static_cast<char *>(iov[1].iov_base), iov[1].iov_len), "defgh");
+  queue.consume(4);
+  ASSERT_EQ(queue.to_iovec(iov, 4), 1);
+  EXPECT_EQ(std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "gh");
+  queue.consume(2);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(OutputQueue, file_segment_stops_the_iovec)
+{
+  OutputQueue queue;
+  std::string head("abc");
+  std::string tail("xyz");
+  struct iovec iov[4];
+  off_t offset;
+  size_t length;
+  int fds[2];
+
+  ASSERT_EQ(pipe(fds), 0);
+  close(fds[1]);
+  queue.push(head);
+  queue.push_file(fds[0], 10, 100);
+  queue.push(tail);
+  EXPECT_EQ(queue.size(), 106u);
+  EXPECT_EQ(queue.to_iovec(iov, 4), 1);
+  queue.consume(3);
+  ASSERT_TRUE(queue.front_is_file());
+  queue.consume(40);
+  EXPECT_EQ(queue.front_file(&offset, &length), fds[0]);
+  EXPECT_EQ(offset, 50);
+  EXPECT_EQ(length, 60u);
+  queue.consume(60);
+  EXPECT_FALSE(queue.front_is_file());
+  EXPECT_EQ(close(fds[0]), -1); // closed by the queue
+  queue.clear();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(OutputQueue, parts_describe_memory_and_files)
+{
+  OutputQueue queue;
+  std::string head("abc");
+  std::string tail("xyz");
+  OutputQueue::Part parts[4];
+  int fds[2];
+
+  ASSERT_EQ(pipe(fds), 0);
+  close(fds[1]);
+  queue.push(head);
+  queue.push_file(fds[0], 10, 100);
+  queue.push(tail);
+  queue.consume(1);
+  ASSERT_EQ(queue.parts(parts, 4), 3u);
+  EXPECT_EQ(std::string(parts[0].data, parts[0].length), "bc");
+  EXPECT_TRUE(parts[1].data == NULL);
+  EXPECT_EQ(parts[1].fd, fds[0]);
+  EXPECT_EQ(parts[1].file_offset, 10);
+  EXPECT_EQ(parts[1].length, 100u);
+  EXPECT_EQ(std::string(parts[2].data, parts[2].length), "xyz");
+  queue.consume(2 + 30);
+  ASSERT_EQ(queue.parts(parts, 1), 1u);
+  EXPECT_EQ(parts[0].file_offset, 40);
+  EXPECT_EQ(parts[0].length, 70u);
+  queue.clear();
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+
+#include "ThreadPool/ThreadPool.hpp"
+#include "ThreadPool/WorkStealingPool.hpp"
+
+#include <unistd.h>
+
+namespace
+{
+  class CountTask : public Task
+  {
+    public:
+      CountTask() : ran(false) {}
+      void run() { ran = true; }
+
+      bool  ran;
+  };
+
+  class SlowTask : public CountTask
+  {
+    public:
+      void run() { usleep(200000); ran = true; }
+  };
+
+  int WaitForTasks(CompletionQueue& queue, int count)
+  {
+    int completed = 0;
+    while (completed < count)
+    {
+      struct pollfd pfd = {queue.fd(), POLLIN, 0};
+      if (poll(&pfd, 1, 5000) != 1)
+        break;
+      for (Task* task = queue.pop_all(); task != NULL; task = task->next_completed)
+      {
+        if (static_cast<CountTask*>(task)->ran)
+          completed++;
+      }
+    }
+    return completed;
+  }
+}
+
+TEST(CompletionQueue, pop_all_in_push_order)
+{
+  CompletionQueue queue;
+  ASSERT_TRUE(queue.open());
+  CountTask first;
+  CountTask second;
+
+  queue.push(&first);
+  queue.push(&second);
+  Task* tasks = queue.pop_all();
+  ASSERT_EQ(tasks, &first);
+  ASSERT_EQ(tasks->next_completed, &second);
+  EXPECT_EQ(tasks->next_completed->next_completed, static_cast<Task*>(NULL));
+  EXPECT_EQ(queue.pop_all(), static_cast<Task*>(NULL));
+  queue.close();
+}
+
+TEST(ThreadPool, tasks_come_back_to_their_queue)
+{
+  ThreadPool pool;
+  CompletionQueue queue;
+  ASSERT_TRUE(queue.open());
+  ASSERT_TRUE(pool.start(3));
+  CountTask tasks[16];
+  for (int i = 0; i < 16; i++)
+    pool.submit(&tasks[i], &queue);
+
+  EXPECT_EQ(WaitForTasks(queue, 16), 16);
+  pool.stop();
+  EXPECT_FALSE(pool.running());
+  queue.close();
+}
+
+TEST(WorkStealingPool, idle_threads_steal_from_a_busy_one)
+{
+  WorkStealingPool pool;
+  CompletionQueue queue;
+  ASSERT_TRUE(queue.open());
+  ASSERT_TRUE(pool.start(2));
+  // round robin: the slow tasks all go to the queue of the first thread
+  SlowTask slow[4];
+  CountTask fast[4];
+  for (int i = 0; i < 4; i++)
+  {
+    pool.submit(&slow[i], &queue);
+    pool.submit(&fast[i], &queue);
+  }
+  EXPECT_EQ(WaitForTasks(queue, 8), 8);
+  EXPECT_GT(pool.stolen(), 0ul);
+  pool.stop();
+  queue.close();
+}
+
+TEST(WorkStealingPool, wakes_a_sleeping_thread_for_every_task)
+{
+  WorkStealingPool pool;
+  CompletionQueue queue;
+  ASSERT_TRUE(queue.open());
+  ASSERT_TRUE(pool.start(4));
+  // the threads go back to sleep between the tasks, a lost wake up stalls one of them
+  CountTask tasks[500];
+  int completed = 0;
+  for (int i = 0; i < 500; i++)
+  {
+    pool.submit(&tasks[i], &queue);
+    if (i % 5 == 4)
+      completed += WaitForTasks(queue, 5);
+  }
+  EXPECT_EQ(completed, 500);
+  pool.stop();
+  queue.close();
+}
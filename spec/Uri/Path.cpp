@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "Uri/Path.hpp"
+
+static std::string Normalize(const std::string& path)
+{
+  std::string normalized = "not normalized";
+
+  EXPECT_TRUE(uri::NormalizePath(path, normalized)) << path;
+  return normalized;
+}
+
+TEST(UriPath, keeps_canonical_paths)
+{
+  EXPECT_EQ(Normalize("/"), "/");
+  EXPECT_EQ(Normalize(""), "/");
+  EXPECT_EQ(Normalize("/index.html"), "/index.html");
+  EXPECT_EQ(Normalize("/dir/"), "/dir/");
+  EXPECT_EQ(Normalize("/a/.hidden/..."), "/a/.hidden/...");
+}
+
+TEST(UriPath, decodes_percent_encoding)
+{
+  EXPECT_EQ(Normalize("/hello%20world"), "/hello world");
+  EXPECT_EQ(Normalize("/%7euser/%7Euser"), "/~user/~user");
+  EXPECT_EQ(Normalize("/100%"), "/100%");
+  EXPECT_EQ(Normalize("/%zz"), "/%zz");
+  EXPECT_EQ(Normalize("/a%2Fb"), "/a/b");
+
+  std::string normalized;
+  EXPECT_FALSE(uri::NormalizePath("/file%00.html", normalized));
+}
+
+TEST(UriPath, collapses_slashes_and_dot_segments)
+{
+  EXPECT_EQ(Normalize("//a///b//"), "/a/b/");
+  EXPECT_EQ(Normalize("/a/./b/."), "/a/b/");
+  EXPECT_EQ(Normalize("/a/b/../c"), "/a/c");
+  EXPECT_EQ(Normalize("/a/b/.."), "/a/");
+  EXPECT_EQ(Normalize("/a/%2e%2E/b"), "/b");
+}
+
+TEST(UriPath, stays_below_the_root)
+{
+  EXPECT_EQ(Normalize("/.."), "/");
+  EXPECT_EQ(Normalize("/../../etc/passwd"), "/etc/passwd");
+  EXPECT_EQ(Normalize("/a/../../b"), "/b");
+  EXPECT_EQ(Normalize("/%2e%2e/%2E%2E/secret"), "/secret");
+  EXPECT_EQ(Normalize("/a/..%2f..%2fb"), "/b");
+}
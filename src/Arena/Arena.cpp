@@ -1,29 +1,190 @@
 #include "Arena.hpp"
 
+#include <sys/mman.h>
+
 #include <cstddef>
 
-Arena::Arena(size_t size)
-  : memory_(::new unsigned char[size]), size_(size)
+Arena::Arena(size_t size, bool huge_pages)
+  : size_(size), huge_pages_(huge_pages), high_water_(0), chain_high_water_(0),
+    blocks_(0), block_allocations_(0), huge_block_allocations_(0)
 {
-  fill_ = memory_;
+  int error = pthread_key_create(&key_, &Arena::delete_thread);
+  assert(error == 0 && "Arena: no thread specific key left");
+  (void)error;
 }
 
 Arena::~Arena() {
-  delete[] memory_;
+  // the blocks of the other threads are deleted when they exit
+  delete_thread(pthread_getspecific(key_));
+  pthread_key_delete(key_);
+}
+
+void *Arena::allocate(size_t size) {
+  Thread *current_thread = thread();
+  ArenaBlock *current = current_thread->current;
+  unsigned char *result = reinterpret_cast<unsigned char *>(
+    align(reinterpret_cast<uintptr_t>(current->fill), DEFAULT_ALIGNMENT));
+  if (result + size > current->memory + current->size)
+  {
+    current = grow(current_thread, size);
+    result = current->memory;
+  }
+  current->fill = result + size;
+  record_maximum(&high_water_, current->used_before + (current->fill - current->memory));
+  return result;
 }
 
+// keeps the oldest block of the chain
 void Arena::clear() {
-  fill_ = memory_;
+  Thread *current_thread = thread();
+  ArenaBlock *oldest = current_thread->current;
+  while (oldest->previous != NULL)
+    oldest = oldest->previous;
+  release_until(current_thread, oldest);
+  oldest->fill = oldest->memory;
 }
 
 ArenaSnapshot Arena::snapshot() {
-  return fill_;
+  ArenaSnapshot snapshot;
+  snapshot.block = thread()->current;
+  snapshot.fill = snapshot.block->fill;
+  return snapshot;
 }
 
 void Arena::rollback(ArenaSnapshot snapshot) {
-  fill_ = snapshot;
+  release_until(thread(), snapshot.block);
+  snapshot.block->fill = snapshot.fill;
+}
+
+ArenaStatistics Arena::statistics() const {
+  ArenaStatistics statistics;
+  statistics.high_water = __sync_add_and_fetch(const_cast<size_t *>(&high_water_), 0);
+  statistics.chain_high_water = __sync_add_and_fetch(const_cast<size_t *>(&chain_high_water_), 0);
+  statistics.blocks = __sync_add_and_fetch(const_cast<size_t *>(&blocks_), 0);
+  statistics.block_allocations = __sync_add_and_fetch(const_cast<size_t *>(&block_allocations_), 0);
+  statistics.huge_block_allocations = __sync_add_and_fetch(const_cast<size_t *>(&huge_block_allocations_), 0);
+  return statistics;
+}
+
+Arena::Thread *Arena::thread() {
+  Thread *current_thread = static_cast<Thread *>(pthread_getspecific(key_));
+  if (current_thread == NULL)
+  {
+    current_thread = new Thread;
+    current_thread->arena = this;
+    current_thread->free = NULL;
+    current_thread->current = new_block(size_);
+    current_thread->current->previous = NULL;
+    current_thread->current->used_before = 0;
+    current_thread->current->index = 1;
+    record_maximum(&chain_high_water_, 1);
+    pthread_setspecific(key_, current_thread);
+  }
+  return current_thread;
+}
+
+// chains a free block that is large enough, or a new one
+ArenaBlock *Arena::grow(Thread *thread, size_t size) {
+  ArenaBlock **free = &thread->free;
+  while (*free != NULL && (*free)->size < size)
+    free = &(*free)->previous;
+  ArenaBlock *block = *free;
+  if (block != NULL)
+    *free = block->previous;
+  else
+    block = new_block(size > size_ ? size : size_);
+  ArenaBlock *current = thread->current;
+  block->previous = current;
+  block->fill = block->memory;
+  block->used_before = current->used_before + (current->fill - current->memory);
+  block->index = current->index + 1;
+  record_maximum(&chain_high_water_, block->index);
+  thread->current = block;
+  return block;
+}
+
+ArenaBlock *Arena::new_block(size_t size) {
+  ArenaBlock *block = new ArenaBlock;
+  block->memory = NULL;
+  block->huge = false;
+  if (huge_pages_ && size >= ARENA_HUGE_PAGE_SIZE)
+  {
+    size = align(size, ARENA_HUGE_PAGE_SIZE);
+    void *memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    // without reserved huge pages, transparent huge pages are asked for
+    if (memory == MAP_FAILED)
+    {
+      memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if (memory != MAP_FAILED)
+        madvise(memory, size, MADV_HUGEPAGE);
+#endif
+    }
+    if (memory != MAP_FAILED)
+    {
+      block->memory = static_cast<unsigned char *>(memory);
+      block->huge = true;
+      __sync_add_and_fetch(&huge_block_allocations_, 1);
+    }
+  }
+  if (block->memory == NULL)
+    block->memory = ::new unsigned char[size];
+  block->fill = block->memory;
+  block->size = size;
+  __sync_add_and_fetch(&blocks_, 1);
+  __sync_add_and_fetch(&block_allocations_, 1);
+  return block;
+}
+
+void Arena::delete_block(ArenaBlock *block) {
+  if (block->huge)
+    munmap(block->memory, block->size);
+  else
+    delete[] block->memory;
+  __sync_sub_and_fetch(&blocks_, 1);
+  delete block;
+}
+
+// moves the blocks newer than block to the free list
+void Arena::release_until(Thread *thread, ArenaBlock *block) {
+  while (thread->current != block)
+  {
+    ArenaBlock *released = thread->current;
+    thread->current = released->previous;
+    released->previous = thread->free;
+    thread->free = released;
+  }
+}
+
+void Arena::record_maximum(size_t *maximum, size_t value) {
+  size_t current = *maximum;
+  while (value > current)
+  {
+    size_t previous = __sync_val_compare_and_swap(maximum, current, value);
+    if (previous == current)
+      break;
+    current = previous;
+  }
+}
+
+void Arena::delete_thread(void *thread) {
+  Thread *current_thread = static_cast<Thread *>(thread);
+  if (current_thread == NULL)
+    return ;
+  Arena *arena = current_thread->arena;
+  arena->release_until(current_thread, NULL);
+  while (current_thread->free != NULL)
+  {
+    ArenaBlock *block = current_thread->free;
+    current_thread->free = block->previous;
+    arena->delete_block(block);
+  }
+  delete current_thread;
 }
 
-uintptr_t Arena::align(uintptr_t ptr, size_t alignment) {
-  return (ptr + alignment - 1) & ~(alignment - 1);
+size_t Arena::align(size_t size, size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
 }
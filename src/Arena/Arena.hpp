@@ -1,8 +1,10 @@
 #pragma once
 
 #include <stdint.h>
+#include <pthread.h>
 #include <cassert>
 #include <cstddef>
+#include <new>
 
 #include <limits>
 
@@ -14,38 +16,93 @@
 ////////////      Arena      ////////////
 /////////////////////////////////////////
 
-typedef unsigned char*  ArenaSnapshot;
+#ifndef ARENA_HUGE_PAGE_SIZE
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+struct ArenaBlock
+{
+  ArenaBlock *previous; // the blocks of a thread are chained from the newest
+  unsigned char *memory;
+  unsigned char *fill;
+  size_t size;
+  size_t used_before; // bytes used in the previous blocks of the chain
+  size_t index; // position in the chain, starting at 1
+  bool huge; // mapped with huge pages instead of allocated on the heap
+};
 
+struct ArenaSnapshot
+{
+  ArenaBlock *block;
+  unsigned char *fill;
+};
+
+// Collected from all threads, to size the blocks of an arena from real traffic.
+struct ArenaStatistics
+{
+  size_t high_water; // most bytes in use by one thread at once
+  size_t chain_high_water; // most blocks chained by one thread at once
+  size_t blocks; // blocks owned by the threads, used or free
+  size_t block_allocations; // blocks allocated since the arena was created
+  size_t huge_block_allocations; // the ones of them mapped with huge pages
+};
+
+// Every thread allocates from its own chain of memory blocks of the arena, created on its
+// first allocation, so the worker threads can share the global arenas without locking.
+// The chain grows by a block when the current one is full. The blocks released by clear()
+// and rollback() are kept in a free list of the thread and reused before allocating new ones.
+// With huge_pages, blocks of at least ARENA_HUGE_PAGE_SIZE are mapped with huge pages.
 class Arena
 {
 public:
-  Arena(size_t size);
+  Arena(size_t size, bool huge_pages = false);
   ~Arena();
 
   template <typename T>
   T *allocate(size_t count = 1);
+  void *allocate(size_t size);
   void clear();
   ArenaSnapshot snapshot();
   void rollback(ArenaSnapshot snapshot);
+  ArenaStatistics statistics() const;
 
 private:
-  unsigned char *memory_;
-  unsigned char *fill_;
+  struct Thread
+  {
+    Arena *arena;
+    ArenaBlock *current;
+    ArenaBlock *free;
+  };
+
   size_t size_;
+  bool huge_pages_;
+  pthread_key_t key_; // Thread of the calling thread, delete_thread() frees its blocks at thread exit
+  // updated with atomic operations by all threads
+  size_t high_water_;
+  size_t chain_high_water_;
+  size_t blocks_;
+  size_t block_allocations_;
+  size_t huge_block_allocations_;
 
   Arena();
   Arena(const Arena &other);
   Arena &operator=(const Arena &other);
 
-  uintptr_t align(uintptr_t ptr, size_t alignment);
+  Thread *thread();
+  ArenaBlock *grow(Thread *thread, size_t size);
+  ArenaBlock *new_block(size_t size);
+  void delete_block(ArenaBlock *block);
+  void release_until(Thread *thread, ArenaBlock *block);
+  static void record_maximum(size_t *maximum, size_t value);
+  static void delete_thread(void *thread);
+  static size_t align(size_t size, size_t alignment);
 };
 
 template <typename T>
 T* Arena::allocate(size_t count) {
-    const size_t size = sizeof(T) * count;
-    assert((fill_ + size < (memory_ + size_)) && "Arena out of memory");
-    T* result = ::new (fill_) T[count];
-    fill_ += size;
+    T* result = static_cast<T*>(allocate(sizeof(T) * count));
+    for (size_t i = 0; i < count; i++)
+      ::new (result + i) T();
     return result;
 }
 
@@ -79,7 +136,7 @@ public:
     pointer
     allocate(size_type n, typename ArenaAllocator<void, arena>::const_pointer = 0)
     {
-        return static_cast<pointer>(arena->allocate<T>(n));
+        return static_cast<pointer>(arena->allocate(sizeof(T) * n));
     }
 
     void
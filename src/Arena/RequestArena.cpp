@@ -0,0 +1,61 @@
+#include "RequestArena.hpp"
+
+RequestArena::RequestArena(size_t block_size)
+  : block_size_(block_size), first_(NULL), current_(NULL), blocks_(0) {}
+
+RequestArena::~RequestArena() {
+  while (first_ != NULL)
+  {
+    Block *next = first_->next;
+    ::operator delete(first_);
+    first_ = next;
+  }
+}
+
+void *RequestArena::allocate(size_t size) {
+  size = align(size);
+  if (current_ == NULL || current_->fill + size > current_->size)
+    current_ = next_block(size);
+  unsigned char *memory = reinterpret_cast<unsigned char *>(current_) + align(sizeof(Block));
+  void *result = memory + current_->fill;
+  current_->fill += size;
+  return result;
+}
+
+void RequestArena::reset() {
+  for (Block *block = first_; block != NULL; block = block->next)
+    block->fill = 0;
+  current_ = first_;
+}
+
+size_t RequestArena::blocks() const {
+  return blocks_;
+}
+
+// the blocks after the current one are empty, a new block is only added when none of them fits
+RequestArena::Block *RequestArena::next_block(size_t size) {
+  Block *previous = current_;
+  Block *block = (current_ == NULL) ? first_ : current_->next;
+  while (block != NULL && block->size < size)
+  {
+    previous = block;
+    block = block->next;
+  }
+  if (block != NULL)
+    return block;
+  size_t block_size = (size > block_size_) ? size : block_size_;
+  block = static_cast<Block *>(::operator new(align(sizeof(Block)) + block_size));
+  block->next = NULL;
+  block->size = block_size;
+  block->fill = 0;
+  if (previous == NULL)
+    first_ = block;
+  else
+    previous->next = block;
+  blocks_++;
+  return block;
+}
+
+size_t RequestArena::align(size_t size) {
+  return (size + DEFAULT_ALIGNMENT - 1) & ~(DEFAULT_ALIGNMENT - 1);
+}
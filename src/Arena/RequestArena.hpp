@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#include "Arena/Arena.hpp"
+
+#ifndef REQUEST_ARENA_BLOCK_SIZE
+#define REQUEST_ARENA_BLOCK_SIZE 2048
+#endif
+
+////////////////////////////////////////////////
+////////////      RequestArena      ////////////
+////////////////////////////////////////////////
+
+// Memory of the objects of one HTTP message, like its header values and the nodes
+// of its header map. Nothing is freed on its own: reset() releases everything at
+// the end of a request, and keeps the blocks for the next request of the connection.
+class RequestArena
+{
+public:
+  RequestArena(size_t block_size = REQUEST_ARENA_BLOCK_SIZE);
+  ~RequestArena();
+
+  void *allocate(size_t size);
+  template <typename T>
+  T *create();
+  template <typename T, typename Argument>
+  T *create(const Argument &argument);
+  void reset();
+  size_t blocks() const;
+
+private:
+  struct Block
+  {
+    Block *next;
+    size_t size;
+    size_t fill;
+  };
+
+  size_t block_size_;
+  Block *first_;
+  Block *current_;
+  size_t blocks_;
+
+  RequestArena(const RequestArena &other);
+  RequestArena &operator=(const RequestArena &other);
+
+  Block *next_block(size_t size);
+  static size_t align(size_t size);
+};
+
+template <typename T>
+T *RequestArena::create()
+{
+  return ::new (allocate(sizeof(T))) T();
+}
+
+template <typename T, typename Argument>
+T *RequestArena::create(const Argument &argument)
+{
+  return ::new (allocate(sizeof(T))) T(argument);
+}
+
+/////////////////////////////////////////////////////////
+////////////      RequestArenaAllocator      ////////////
+/////////////////////////////////////////////////////////
+
+// Unlike ArenaAllocator, the arena is chosen when the container is constructed,
+// so every message can keep its containers in its own arena.
+
+template <class T>
+class RequestArenaAllocator
+{
+public:
+    typedef T                 value_type;
+    typedef value_type&       reference;
+    typedef value_type const& const_reference;
+    typedef value_type*       pointer;
+    typedef value_type const* const_pointer;
+    typedef std::size_t       size_type;
+    typedef std::ptrdiff_t    difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef RequestArenaAllocator<U> other;
+    };
+
+    explicit RequestArenaAllocator(RequestArena *arena) throw() : arena_(arena) {}
+    template <class U> RequestArenaAllocator(RequestArenaAllocator<U> const& other) throw() : arena_(other.arena()) {}
+
+    pointer
+    allocate(size_type n, const void * = 0)
+    {
+        return static_cast<pointer>(arena_->allocate(sizeof(T) * n));
+    }
+
+    void
+    deallocate(pointer, size_type) {}
+
+    void
+    construct(pointer p, value_type const& val)
+    {
+        ::new(p) value_type(val);
+    }
+
+    void
+    destroy(pointer p)
+    {
+        p->~value_type();
+    }
+
+    size_type
+    max_size() const throw()
+    {
+        return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    }
+
+    pointer
+    address(reference x) const
+    {
+        return &x;
+    }
+
+    const_pointer
+    address(const_reference x) const
+    {
+        return &x;
+    }
+
+    RequestArena *
+    arena() const
+    {
+        return arena_;
+    }
+
+private:
+    RequestArena *arena_;
+};
+
+template <class T, class U>
+bool
+operator==(RequestArenaAllocator<T> const& x, RequestArenaAllocator<U> const& y)
+{
+    return x.arena() == y.arena();
+}
+
+template <class T, class U>
+bool
+operator!=(RequestArenaAllocator<T> const& x, RequestArenaAllocator<U> const& y)
+{
+    return !(x == y);
+}
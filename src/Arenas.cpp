@@ -1,5 +1,5 @@
 #include "Arenas.hpp"
 
 Arena permanent::arena(1024);
-Arena temporary::arena(10240);
-
+// a block for a very large request is mapped with huge pages
+Arena temporary::arena(10240, true);
@@ -17,6 +17,14 @@ void	cgi::ProcessGetRequestCgi(struct Client *clt)
 		clt->status_code = k500;
 		return (res_builder::GenerateErrorResponse(clt));
 	}
+	assert(!clt->cgi_argv.empty() && "ProcessGetRequestCgi: clt->cgi_argv is NULL");
+	// the arguments are built before fork(), with worker threads the child must not allocate
+	// nor run the destructors of the globals, so it leaves through _exit()
+	SetCgiEnv(clt);
+	std::vector<char *> cstrings_argv;
+	std::vector<char *> cstrings_env;
+	char** cgi_argv = StringVecToTwoDimArray(cstrings_argv, clt->cgi_argv);
+	char** cgi_env = StringVecToTwoDimArray(cstrings_env, clt->cgi_env);
 	int pid = fork();
 	if (pid < 0)
 	{
@@ -28,31 +36,25 @@ void	cgi::ProcessGetRequestCgi(struct Client *clt)
 	if (pid == 0)
 	{
 		//child process
+		RestoreCgiSignals();
 		close(cgi_output[kRead]);
 		dup2(cgi_output[kWrite], STDOUT_FILENO);
-		assert(!clt->cgi_argv.empty() && "ProcessGetRequestCgi: clt->cgi_argv is NULL");
 		if (access(clt->cgi_argv[0].c_str(), F_OK) != 0 || \
 		access(clt->cgi_argv[0].c_str(), X_OK) != 0 || \
 		access(clt->cgi_argv[1].c_str(), F_OK) != 0 || \
 		access(clt->cgi_argv[1].c_str(), R_OK) != 0)
 		{
 			close(cgi_output[kWrite]);
-			exit(2);
+			_exit(2);
 		}
-		SetCgiEnv(clt);
-		std::vector<char *> cstrings_argv;
-		std::vector<char *> cstrings_env;
-		char** cgi_argv = StringVecToTwoDimArray(cstrings_argv, clt->cgi_argv);
-		char** cgi_env = StringVecToTwoDimArray(cstrings_env, clt->cgi_env);
 		if (cgi_argv == NULL || cgi_env == NULL)
 		{
 			close(cgi_output[kWrite]);
-			exit(3);
+			_exit(3);
 		}
 		execve(cgi_argv[0], cgi_argv, cgi_env);
-		std::cerr << "Error: execve" << std::endl;
 		close(cgi_output[kWrite]);
-		exit(4);
+		_exit(4);
 	}
 	//parent process48
 	std::string response_tmp;
@@ -128,6 +130,11 @@ void	cgi::ProcessPostRequestCgi(struct Client *clt)
 		clt->status_code = k500;
 		return (res_builder::GenerateErrorResponse(clt));
 	}
+	SetCgiEnv(clt);
+	std::vector<char *> cstrings_argv;
+	std::vector<char *> cstrings_env;
+	char** cgi_argv = StringVecToTwoDimArray(cstrings_argv, clt->cgi_argv);
+	char** cgi_env = StringVecToTwoDimArray(cstrings_env, clt->cgi_env);
 	int pid = fork();
 	if (pid < 0)
 	{
@@ -141,6 +148,7 @@ void	cgi::ProcessPostRequestCgi(struct Client *clt)
 	if (pid == 0)
 	{
 		//child process
+		RestoreCgiSignals();
 		close(cgi_output[kRead]);
 		dup2(cgi_output[kWrite], STDOUT_FILENO);
 		close(cgi_input[kWrite]);
@@ -152,30 +160,25 @@ void	cgi::ProcessPostRequestCgi(struct Client *clt)
 		{
 			close(cgi_input[kRead]);
 			close(cgi_output[kWrite]);
-			exit(2);
+			_exit(2);
 		}
-		SetCgiEnv(clt);
-		std::vector<char *> cstrings_argv;
-		std::vector<char *> cstrings_env;
-		char** cgi_argv = StringVecToTwoDimArray(cstrings_argv, clt->cgi_argv);
-		char** cgi_env = StringVecToTwoDimArray(cstrings_env, clt->cgi_env);
 		if (cgi_argv == NULL || cgi_env == NULL)
 		{
 			close(cgi_input[kRead]);
 			close(cgi_output[kWrite]);
-			exit(3);
+			_exit(3);
 		}
 		execve(cgi_argv[0], cgi_argv, cgi_env);
-		std::cerr << "Error: execve" << std::endl;
 		close(cgi_input[kRead]);
 		close(cgi_output[kWrite]);
-		exit(4);
+		_exit(4);
 	}
 	//parent process
 	//write to child process
 	close(cgi_input[kRead]);
-	int content_size = clt->req.getRequestBody().size();
-	char *content_str = const_cast<char *>(clt->req.getRequestBody().c_str());
+	StringView body = clt->req.getRequestBody();
+	int content_size = body.length;
+	char *content_str = const_cast<char *>(body.bytes);
 	int write_byte = WriteAll(cgi_input[kWrite], content_str, content_size);
 	if (write_byte <= 0 && write_byte != content_size)
 	{
@@ -291,10 +294,10 @@ void	cgi::SetCgiEnv(struct Client *clt)
 	// clt->cgi_env.push_back("REQUEST_METHOD=" + clt->req.getMethod());
 
 	//construct query_string
-	clt->cgi_env.push_back("QUERY_STRING=" + clt->req.getRequestTarget().query);
+	clt->cgi_env.push_back("QUERY_STRING=" + clt->req.getRequestTarget().query.str());
 
 	//construct content_length
-	HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer("Content-Length"));
+	HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer(kHeaderContentLength));
 	if (content_length)
 	{
 		std::string content_length_str = content_length->to_string();
@@ -304,14 +307,14 @@ void	cgi::SetCgiEnv(struct Client *clt)
 		clt->cgi_env.push_back("CONTENT_LENGTH=");
 
 	//construct content_type
-	HeaderString *content_type = static_cast<HeaderString *>(clt->req.returnValueAsPointer("Content-Type"));
+	HeaderString *content_type = static_cast<HeaderString *>(clt->req.returnValueAsPointer(kHeaderContentType));
 	if (content_type)
 		clt->cgi_env.push_back("CONTENT_TYPE=" + content_type->content());
 	else
 		clt->cgi_env.push_back("CONTENT_TYPE=");
 
 	//construct request_uri
-	clt->cgi_env.push_back("REQUEST_URI=" + clt->req.getRequestTarget().path);
+	clt->cgi_env.push_back("REQUEST_URI=" + clt->req.getRequestTarget().path.str());
 
 	//construct document_uri // ? what is this? Probably for POST request with Location header ?
 
@@ -438,6 +441,17 @@ bool	cgi::ParseCgiOutput(struct CgiOutput &cgi_content, std::string &response_tm
 
 //helper functions
 
+// The server ignores SIGPIPE and the worker threads block the other signals, the script
+// gets the default behaviour. Only async-signal-safe calls, it runs between fork() and execve().
+void	cgi::RestoreCgiSignals()
+{
+	sigset_t	none;
+
+	signal(SIGPIPE, SIG_DFL);
+	sigemptyset(&none);
+	sigprocmask(SIG_SETMASK, &none, NULL);
+}
+
 char**	cgi::StringVecToTwoDimArray(std::vector<char *> &cstrings, const std::vector<std::string> &strings)
 {
 	size_t vector_size = strings.size();
@@ -31,11 +31,14 @@ enum ResponseError
 	kFileStreamError
 };
 
+class RequestTask;
+
 struct Client
 {
 	StatusCode	status_code;
 	struct ClientSocket	*client_socket;
 	struct ConfigurationQueryResult	config;
+	Configuration	*database; // configuration that answered the query, retained until the client is reset
 	struct stat	stat_buff;
 	std::string path;
 	std::vector<std::string> cgi_argv; //path to cgi executable and path to cgi script
@@ -55,6 +58,7 @@ struct Client
 	//END: request status before processing
 	Request	req;
 	Response	res;
+	RequestTask	*task; // the response is being built in a pool thread, NULL otherwise
 };
 
 namespace client_lifespan
@@ -62,6 +66,7 @@ namespace client_lifespan
 	void	InitClient(struct Client &client, struct ClientSocket *client_socket);
   int   DeleteClientFromVector(std::vector<struct Client> &clients, int client_fd);
 	void	ResetClient(struct Client &client);
+	void	ReleaseConfiguration(struct Client &client);
 
 	//update functions
 	// void	UpdateStatusCode(struct Client &clt, StatusCode statuscode);
@@ -78,9 +83,11 @@ namespace process
 	void	ProcessGetRequest(struct Client *clt);
 	void	ProcessPostRequest(struct Client *clt);
 	void	ProcessDeleteRequest(struct Client *clt);
+	bool	IsDiskRequest(struct Client *clt);
+	bool	IsCpuRequest(struct Client *clt);
 
 	//file and path and content-type related functions
-	std::string GetExactPath(const std::string root, std::string match_path, const struct Uri uri);
+	std::string GetExactPath(const std::string &root, const std::string &match_path, const std::string &path);
 	bool		IsCgi(std::vector<std::string> &cgi_executable, std::string path, cache::LocationQuery *location);
 	std::string	GetReqExtension(std::string path);
 	// bool		IsAcceptable(std::string content_type, HeaderValue *accept, cache::LocationQuery *location);
@@ -94,11 +101,19 @@ namespace process
 		bool	UploadFile(struct Client *clt);
 		bool	DeleteFile(struct Client *clt);
 
+		// The path starts with the root of the location. The rest of it is looked
+		// up from the root directory opened by the configuration, with openat2
+		// RESOLVE_BENEATH where the kernel has it, so it cannot leave the root.
+		int		OpenBeneath(const cache::LocationQuery *location, const std::string &path, int flags, mode_t mode = 0);
+		int		StatBeneath(const cache::LocationQuery *location, const std::string &path, struct stat *buff);
+		int		AccessBeneath(const cache::LocationQuery *location, const std::string &path, int mode);
+		DIR		*OpenDirBeneath(const cache::LocationQuery *location, const std::string &path);
+
 		//helper functions
 		std::string	GenerateFileName(std::string path); //base on timestamp
 		std::string GenerateFileExtension(std::string content_type, const directive::MimeTypes* mime_types);
-		bool CreateDir(std::string dir);
-		bool CreateDirRecurs(std::string path);
+		bool CreateDirBeneath(const cache::LocationQuery *location, const std::string &dir);
+		bool CreateDirsBeneath(const cache::LocationQuery *location, const std::string &path);
 	}
 }
 
@@ -126,6 +141,7 @@ namespace cgi
 
 	//helper functions
 	char**	StringVecToTwoDimArray(std::vector<char *> &cstrings, const std::vector<std::string> &strings);
+	void	RestoreCgiSignals();
 }
 
 namespace res_builder
@@ -143,7 +159,7 @@ namespace res_builder
 	void	BuildRedirectResponseBody(struct Client *clt);
 
 	// autoindex related helper functions
-	std::string BuildAutoindexHTML(DSet files, std::string path);
+	std::string BuildAutoindexHTML(const DSet &files, std::string path);
 
 	// success related helper functions
 	void	BuildPostResponseBody(struct Client *clt);
@@ -152,16 +168,22 @@ namespace res_builder
 	void	AddLocationHeader(struct Client *clt);
 	void	AddAllowHeader(struct Client *clt);
 	void	AddAcceptHeader(struct Client *clt);
-	void	BuildContentHeadersCGI(struct Client *clt);
-	void	BuildContentHeaders(struct Client *clt, std::string extension, std::string path);
+	void	BuildContentHeadersCGI(struct Client *clt, std::string &response);
+	void	BuildContentHeaders(struct Client *clt, std::string &response, const std::string &type, const std::string &path);
+	void	BuildContentHeaders(struct Client *clt, std::string &response, const std::string &type, const std::string &path, size_t content_length);
+	void	AppendHeader(std::string &response, HeaderId id, const std::string &value);
+	void	AppendHeader(std::string &response, HeaderId id, size_t value);
+	void	AppendDateHeader(std::string &response); // the current date, formatted once per second
+	void	AppendLastModifiedHeader(std::string &response, time_t modified);
 
 	// general utility functions
 	std::string MethodToString(enum directive::Method method);
 	void	ServerError500(struct Client *clt);
-	std::string	GetTimeGMT();
-	std::string GetTimeGMT(time_t raw_time);
-	void	BuildBasicHeaders(Response *res);
+	void	BuildBasicHeaders(struct Client *clt, std::string &response);
 	void	BuildStatusLine(StatusCode status_code, std::string &response);
+	const std::string	&StatusLine(StatusCode code);
 	enum ResponseError	ReadFileToBody(const std::string &path, Response *res);
-	std::string	StatusCodeAsString(StatusCode code);
+	enum ResponseError	OpenFileForBody(const cache::LocationQuery *location, const std::string &path, int *fd, size_t *size);
+	void	QueueResponse(struct Client *clt, std::string &response);
+	const std::string	&StatusCodeAsString(StatusCode code);
 }
@@ -1,5 +1,7 @@
 #include "Client.hpp"
 #include "Protocol.hpp"
+#include "Configuration/Cache/PathCache.hpp"
+#include "Uri/Path.hpp"
 
 #include <cstring>
 #include <cassert>
@@ -13,6 +15,8 @@ void	client_lifespan::InitClient(struct Client &client, struct ClientSocket *cli
 	client.client_socket = client_socket;
 	client.config.location_block = NULL;
 	client.config.query = NULL;
+	client.database = NULL;
+	client.task = NULL;
 	//???? do I need to set stat_buff to 0???
 	memset(&client.stat_buff, 0, sizeof(struct stat));
 	client.keepAlive = true;
@@ -28,9 +32,14 @@ void	client_lifespan::InitClient(struct Client &client, struct ClientSocket *cli
 void	client_lifespan::ResetClient(struct Client &client)
 {
 	client.status_code = k000;
-	client.client_socket->res_buf.clear();
-	client.config.location_block = NULL;
-	client.config.query = NULL;
+	client.client_socket->output.clear();
+	// the next request on this connection is read with the header buffer size of this server
+	if (client.config.query)
+		client.client_socket->read_size = client.config.query->client_header_buffer_size;
+	// an idle connection does not keep the capacity of a large request
+	if (client.client_socket->req_buf.empty())
+		std::string().swap(client.client_socket->req_buf);
+	ReleaseConfiguration(client);
 	memset(&client.stat_buff, 0, sizeof(struct stat));
 	client.path.clear();
 	client.cgi_argv.clear();
@@ -59,6 +68,7 @@ int	client_lifespan::DeleteClientFromVector(std::vector<struct Client> &clients,
 		if (it->client_socket->socket == client_fd)
 		{
       index = it - clients.begin();
+			ReleaseConfiguration(*it);
 			clients.erase(it);
 			break;
 		}
@@ -66,6 +76,17 @@ int	client_lifespan::DeleteClientFromVector(std::vector<struct Client> &clients,
   return index;
 }
 
+// the configuration may have been replaced by a reload in the meantime,
+// in which case this can be the last reference to it
+void	client_lifespan::ReleaseConfiguration(struct Client &client)
+{
+	client.config.location_block = NULL;
+	client.config.query = NULL;
+	if (client.database)
+		client.database->release();
+	client.database = NULL;
+}
+
 //update functions
 // void client_lifespan::UpdateStatusCode(struct Client clt, StatusCode statuscode)
 // {
@@ -81,7 +102,7 @@ bool client_lifespan::IsClientAlive(struct Client *clt)
 void	client_lifespan::CheckHeaderBeforeProcess(struct Client *clt)
 {
 	// check if is_chunked
-	HeaderString	*transfer_encoding = static_cast<HeaderString *> (clt->req.returnValueAsPointer("Transfer-Encoding"));
+	HeaderString	*transfer_encoding = static_cast<HeaderString *> (clt->req.returnValueAsPointer(kHeaderTransferEncoding));
 	if (transfer_encoding && transfer_encoding->content() == "chunked")
 	{
 		clt->is_chunked = true;
@@ -90,7 +111,7 @@ void	client_lifespan::CheckHeaderBeforeProcess(struct Client *clt)
 	std::string requestline_host = clt->req.request_target_.authority.host.value;
 	if (requestline_host == "")
 	{
-		HeaderString	*header_host = static_cast<HeaderString *> (clt->req.returnValueAsPointer("Host"));
+		HeaderString	*header_host = static_cast<HeaderString *> (clt->req.returnValueAsPointer(kHeaderHost));
 		// assert(header_host && "Host header is missing");
 		// requestline_host = header_host->content();
 		// assert((requestline_host != "") && "Host header is empty");
@@ -101,9 +122,39 @@ void	client_lifespan::CheckHeaderBeforeProcess(struct Client *clt)
 			return ;
 		}
 	}
-	// query configuration
-	clt->config = ws_database.query(clt->client_socket->server.socket, \
-		requestline_host, clt->req.getRequestTarget().path);
+	// query configuration, the request keeps using it even if a reload happens
+	clt->database = AcquireConfiguration();
+	// the listening socket may have been removed from the configuration by a reload
+	if (!clt->database->query_server_blocks(clt->client_socket->server.socket).is_ok())
+	{
+		clt->status_code = k503;
+		clt->consume_body = false;
+		clt->keepAlive = false;
+		return ;
+	}
+	// the same raw paths are requested again and again, their normalization
+	// and routing are cached by the thread
+	int	server_socket = clt->client_socket->server.socket;
+	const StringView	&raw_path = clt->req.getRequestTarget().path;
+	cache::PathCache	&path_cache = cache::PathCache::thread_cache();
+	const cache::ResolvedPath	*resolved = path_cache.find(clt->database, server_socket, requestline_host, raw_path);
+	cache::ResolvedPath	computed;
+	if (resolved == NULL)
+	{
+		if (!uri::NormalizePath(raw_path, computed.normalized_path))
+		{
+			clt->status_code = k400;
+			clt->consume_body = false;
+			return ;
+		}
+		computed.config = clt->database->query(server_socket, requestline_host, computed.normalized_path);
+		assert(computed.config.query && "No configuration found for this request");
+		computed.path = process::GetExactPath(computed.config.query->root, computed.config.query->match_path, computed.normalized_path);
+		resolved = path_cache.insert(clt->database, server_socket, requestline_host, raw_path, computed);
+		if (resolved == NULL)
+			resolved = &computed;
+	}
+	clt->config = resolved->config;
 
 	assert(clt->config.query && "No configuration found for this request");
 
@@ -111,6 +162,7 @@ void	client_lifespan::CheckHeaderBeforeProcess(struct Client *clt)
 	cache::LocationQuery	*location= clt->config.query;
 
 	clt->max_body_size = location->client_max_body_size;
+	clt->client_socket->read_size = location->client_body_buffer_size;
 
 	if (!(location->allowed_methods & (int) clt->req.getMethod()))
 	{
@@ -123,25 +175,23 @@ void	client_lifespan::CheckHeaderBeforeProcess(struct Client *clt)
 	}
 
 	// check if the path exists (for get and delete)
-	std::string path = process::GetExactPath(location->root, location->match_path, clt->req.getRequestTarget());
+	const std::string &path = resolved->path;
 	clt->path = path;
 	if (clt->req.getMethod() == kGet || clt->req.getMethod() == kDelete)
 	{
-		if (access(path.c_str(), F_OK) != 0)
-		{
-			if (clt->status_code == k000)
-			{
-				clt->status_code = k404;
-				clt->consume_body = false;
-				return ;
-			}
-		}
-		if (stat(path.c_str(), &clt->stat_buff) != 0)
+		if (process::file::StatBeneath(location, path, &clt->stat_buff) != 0)
 		{
 			if (clt->status_code == k000)
 			{
-				std::cerr << "stat error" << std::endl;
-				clt->status_code = k500;
+				// EXDEV: a symbolic link leads out of the root
+				if (errno == ENOENT || errno == ENOTDIR || errno == EACCES ||
+					errno == ELOOP || errno == EXDEV || errno == ENAMETOOLONG)
+					clt->status_code = k404;
+				else
+				{
+					std::cerr << "stat error" << std::endl;
+					clt->status_code = k500;
+				}
 				clt->consume_body = false;
 				return ;
 			}
@@ -149,7 +199,7 @@ void	client_lifespan::CheckHeaderBeforeProcess(struct Client *clt)
 	}
 
 	//For POST with Content-Length (normal request, without chunks)
-	HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer("Content-Length"));
+	HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer(kHeaderContentLength));
 	if ((clt->req.getMethod() == kPost) && !content_length && !clt->is_chunked)
 	{
 		clt->status_code = k411;
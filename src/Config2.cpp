@@ -129,6 +129,7 @@ void  Config2(directive::MainBlock& main)
 		directive::MimeTypes* mime_types = new directive::MimeTypes();
 		mime_types->add("txt", "text/plain");
 		mime_types->add("html", "text/html");
+		mime_types->build_indexes();
 		location->add_directive(mime_types);
 	  }
 
@@ -161,6 +162,7 @@ void  Config2(directive::MainBlock& main)
 		mime_types->add("txt", "text/plain");
 		mime_types->add("html", "text/html");
 		mime_types->add("json", "application/json");
+		mime_types->build_indexes();
 		location->add_directive(mime_types);
 	  }
 
@@ -1,5 +1,8 @@
 #include "Configuration.hpp"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <cassert>
 
 #include "misc/Maybe.hpp"
@@ -34,28 +37,43 @@ bool  ConfigurationQueryResult::is_empty() const
 ////////////   Configuration   /////////////
 ////////////////////////////////////////////
 
-Configuration ws_database(16);
+Configuration* ws_database = NULL;
 
-Configuration::Configuration()
-  : server_cache_(),
-    location_cache_(),
-    location_insertion_index_(0),
-    main_block_(NULL)
+static pthread_mutex_t  ws_database_lock = PTHREAD_MUTEX_INITIALIZER;
+
+Configuration* AcquireConfiguration()
 {
-  location_cache_.reserve(32);
+  pthread_mutex_lock(&ws_database_lock);
+  Configuration* database = ws_database;
+  database->retain();
+  pthread_mutex_unlock(&ws_database_lock);
+  return database;
 }
 
-Configuration::Configuration(int cache_size)
-  : server_cache_(),
-    location_cache_(),
-    location_insertion_index_(0),
-    main_block_(NULL)
+void  ReplaceConfiguration(Configuration* database)
 {
-  location_cache_.reserve(cache_size);
+  pthread_mutex_lock(&ws_database_lock);
+  Configuration* previous = ws_database;
+  ws_database = database;
+  pthread_mutex_unlock(&ws_database_lock);
+  if (previous != NULL)
+    previous->release();
 }
 
+static unsigned long  configuration_generation = 0;
+
+Configuration::Configuration()
+  : server_cache_(),
+    location_cache_(),
+    location_index_(),
+    root_fds_(),
+    main_block_(NULL),
+    references_(1),
+    generation_(__sync_add_and_fetch(&configuration_generation, 1)) {}
+
 Configuration::~Configuration()
 {
+  close_root_directories();
   if (main_block_ != NULL)
     delete main_block_;
 }
@@ -77,20 +95,46 @@ void  Configuration::register_server_socket(int server_socket_fd, const uri::Aut
   }
 }
 
-void  Configuration::set_location_cache_size(int size)
+const directive::ListenOptions& Configuration::listen_options(const uri::Authority& socket)
 {
-  location_cache_.reserve(size);
+  if (server_cache_.empty())
+    generate_server_cache();
+  for (std::vector<cache::ServerQuery>::const_iterator it = server_cache_.begin(); it != server_cache_.end(); ++it)
+  {
+    if (*it->socket == socket)
+      return *it->options;
+  }
+  return constants::kDefaultListenOptions;
 }
 
 void  Configuration::set_main_block(directive::MainBlock* main_block)
 {
   main_block_ = main_block;
+  generate_location_cache();
+}
+
+void  Configuration::retain()
+{
+  __sync_add_and_fetch(&references_, 1);
+}
+
+void  Configuration::release()
+{
+  int references = __sync_sub_and_fetch(&references_, 1);
+  assert(references >= 0);
+  if (references == 0)
+    delete this;
 }
 
 /////////////////////////////////////
 ////////////   getters   ////////////
 /////////////////////////////////////
 
+unsigned long Configuration::generation() const
+{
+  return generation_;
+}
+
 size_t Configuration::worker_connections() const
 {
   assert(main_block_ != NULL);
@@ -103,6 +147,78 @@ size_t Configuration::worker_connections() const
   return worker_connections.value();
 }
 
+size_t Configuration::shutdown_timeout() const
+{
+  assert(main_block_ != NULL);
+  directive::EventsBlock* events = main_block_->events();
+  if (events == NULL)
+    return constants::kDefaultShutdownTimeout;
+  const Maybe<size_t> shutdown_timeout = events->shutdown_timeout();
+  if (!shutdown_timeout.is_ok())
+    return constants::kDefaultShutdownTimeout;
+  return shutdown_timeout.value();
+}
+
+size_t Configuration::multi_accept() const
+{
+  assert(main_block_ != NULL);
+  directive::EventsBlock* events = main_block_->events();
+  if (events == NULL)
+    return constants::kDefaultMultiAccept;
+  const Maybe<size_t> multi_accept = events->multi_accept();
+  if (!multi_accept.is_ok())
+    return constants::kDefaultMultiAccept;
+  return multi_accept.value();
+}
+
+std::string Configuration::use() const
+{
+  assert(main_block_ != NULL);
+  directive::EventsBlock* events = main_block_->events();
+  if (events == NULL)
+    return constants::kDefaultUse;
+  const Maybe<std::string> use = events->use();
+  if (!use.is_ok())
+    return constants::kDefaultUse;
+  return use.value();
+}
+
+size_t Configuration::worker_threads() const
+{
+  assert(main_block_ != NULL);
+  directive::EventsBlock* events = main_block_->events();
+  if (events == NULL)
+    return constants::kDefaultWorkerThreads;
+  const Maybe<size_t> worker_threads = events->worker_threads();
+  if (!worker_threads.is_ok())
+    return constants::kDefaultWorkerThreads;
+  return worker_threads.value();
+}
+
+size_t Configuration::aio_threads() const
+{
+  assert(main_block_ != NULL);
+  directive::EventsBlock* events = main_block_->events();
+  if (events == NULL)
+    return constants::kDefaultAioThreads;
+  const Maybe<size_t> aio_threads = events->aio_threads();
+  if (!aio_threads.is_ok())
+    return constants::kDefaultAioThreads;
+  return aio_threads.value();
+}
+
+size_t Configuration::cpu_threads() const
+{
+  assert(main_block_ != NULL);
+  directive::EventsBlock* events = main_block_->events();
+  if (events == NULL)
+    return constants::kDefaultCpuThreads;
+  const Maybe<size_t> cpu_threads = events->cpu_threads();
+  if (!cpu_threads.is_ok())
+    return constants::kDefaultCpuThreads;
+  return cpu_threads.value();
+}
+
 std::vector<const uri::Authority*> Configuration::all_server_sockets()
 {
   if (server_cache_.empty())
@@ -129,30 +245,13 @@ const ConfigurationQueryResult  Configuration::query(int server_socket_fd,
   const directive::ServerBlock* server_block = query_server_block(server_socket_fd, server_name);
   assert(server_block != NULL);
   const directive::LocationBlock* location_block = query_location_block(server_block, path);
-  if (location_block != NULL)
-  {
-    // find the location property in the location cache
-    for (std::vector<cache::LocationQuery>::iterator it = location_cache_.begin(); it != location_cache_.end(); ++it)
-    {
-      if (it->match_path == location_block->match() && it->server_block == server_block)
-      {
-        return ConfigurationQueryResult(location_block, &(*it));
-      }
-    }
-  }
-  cache::LocationQuery* query = NULL;
-  // if the location property is not found, then create a new location property
-  if (location_cache_.size() == location_cache_.capacity())
-    query = &location_cache_[location_insertion_index_];
-  else
-  {
-    location_cache_.push_back(cache::LocationQuery());
-    query = &location_cache_.back();
-  }
-  location_insertion_index_ = (location_insertion_index_ + 1) % location_cache_.size();
-  // construct the configuration query result
-  query->construct(server_block, location_block);
-  return ConfigurationQueryResult(location_block, query);
+  // the location properties are computed by set_main_block()
+  const directive::DirectiveBlock* target_block = location_block;
+  if (target_block == NULL)
+    target_block = server_block;
+  std::map<const directive::DirectiveBlock*, size_t>::const_iterator it = location_index_.find(target_block);
+  assert(it != location_index_.end());
+  return ConfigurationQueryResult(location_block, &location_cache_[it->second]);
 }
 
 const directive::LocationBlock*  Configuration::query_location_block(const directive::ServerBlock* server_block,
@@ -247,7 +346,7 @@ void  Configuration::generate_server_cache()
     // Use default Authority if no listen directive is specified
     if (!directive::DirectiveRangeIsValid(listen_directives))
     {
-      add_unique_server_cache(&constants::kDefaultAuthority, server_block);
+      add_unique_server_cache(&constants::kDefaultAuthority, &constants::kDefaultListenOptions, server_block);
     }
     else
     {
@@ -262,13 +361,84 @@ void  Configuration::generate_server_cache()
 
         // iterate over all sockets in a listen directive
         for (std::vector<uri::Authority>::const_iterator socket_it = sockets.begin(); socket_it != sockets.end(); ++socket_it)
-          add_unique_server_cache(&*socket_it, server_block);
+          add_unique_server_cache(&*socket_it, &listen->options(), server_block);
       }
     }
   }
 }
 
-void  Configuration::add_unique_server_cache(const uri::Authority* socket, const directive::ServerBlock* server_block)
+void  Configuration::generate_location_cache()
+{
+  location_cache_.clear();
+  location_index_.clear();
+  if (main_block_ == NULL || main_block_->http() == NULL)
+    return;
+  std::vector<LocationTarget> targets;
+  directive::Servers servers = main_block_->http()->servers();
+  for (directive::Servers::first_type it = servers.first; it != servers.second; ++it)
+  {
+    const directive::ServerBlock* server_block = static_cast<const directive::ServerBlock*>(it->second);
+    targets.push_back(LocationTarget(server_block, NULL));
+    add_location_targets(server_block, server_block->locations(), targets);
+  }
+  location_cache_.resize(targets.size());
+  for (size_t i = 0; i < targets.size(); i++)
+  {
+    location_cache_[i].construct(targets[i].first, targets[i].second);
+    if (targets[i].second != NULL)
+      location_index_[targets[i].second] = i;
+    else
+      location_index_[targets[i].first] = i;
+  }
+  open_root_directories();
+}
+
+// O_PATH only resolves the directory, it works without the read permission.
+// Without O_PATH (Darwin) the directory is opened for reading.
+void  Configuration::open_root_directories()
+{
+  close_root_directories();
+  for (std::vector<cache::LocationQuery>::iterator it = location_cache_.begin(); it != location_cache_.end(); ++it)
+  {
+    std::map<std::string, int>::iterator root_it = root_fds_.find(it->root);
+    if (root_it == root_fds_.end())
+    {
+#ifdef O_PATH
+      int fd = open(it->root.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+#else
+      int fd = open(it->root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#endif
+      root_it = root_fds_.insert(std::make_pair(it->root, fd)).first;
+    }
+    it->root_fd = root_it->second;
+  }
+}
+
+void  Configuration::close_root_directories()
+{
+  for (std::map<std::string, int>::iterator it = root_fds_.begin(); it != root_fds_.end(); ++it)
+  {
+    if (it->second != -1)
+      close(it->second);
+  }
+  root_fds_.clear();
+}
+
+void  Configuration::add_location_targets(const directive::ServerBlock* server_block,
+                                          directive::Locations locations,
+                                          std::vector<LocationTarget>& targets)
+{
+  for (directive::Locations::first_type it = locations.first; it != locations.second; ++it)
+  {
+    const directive::LocationBlock* location_block = static_cast<const directive::LocationBlock*>(it->second);
+    targets.push_back(LocationTarget(server_block, location_block));
+    add_location_targets(server_block, location_block->locations(), targets);
+  }
+}
+
+void  Configuration::add_unique_server_cache(const uri::Authority* socket,
+                                             const directive::ListenOptions* options,
+                                             const directive::ServerBlock* server_block)
 {
   // if the server cache that has the same socket, then add the server block to the server cache
   bool  found = false;
@@ -285,5 +455,5 @@ void  Configuration::add_unique_server_cache(const uri::Authority* socket, const
   }
   // otherwise, create a new server cache and add the server block to the server cache
   if (!found)
-    server_cache_.push_back(cache::ServerQuery(socket, server_block));
+    server_cache_.push_back(cache::ServerQuery(socket, options, server_block));
 }
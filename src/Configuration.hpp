@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -12,7 +13,15 @@
 #include "Configuration/Directive/Block/Location.hpp"
 
 class Configuration;
-extern Configuration ws_database;
+// The configuration used for new requests. It is replaced on a reload, the
+// previous one stays alive as long as requests still reference it.
+// The worker threads read it through AcquireConfiguration() only.
+extern Configuration* ws_database;
+
+// ws_database with a reference taken for the caller, safe against a reload in another thread
+Configuration* AcquireConfiguration();
+// Make database the configuration for new requests, and drop the reference to the previous one
+void           ReplaceConfiguration(Configuration* database);
 
 struct ConfigurationQueryResult
 {
@@ -32,19 +41,28 @@ class Configuration
     typedef Maybe<const std::vector<const directive::ServerBlock*>*>  ServerBlocksQueryResult;
 
     Configuration();
-    Configuration(int cache_size);
     ~Configuration();
 
     ///////////////////////////////////////////////
     ////////////   setup this object   ////////////
     ///////////////////////////////////////////////
 
-    // Set the size of the location cache.
-    void  set_location_cache_size(int size);
-
-    // Set the main block of the configuration.
+    // Set the main block of the configuration. The properties of every server and
+    // location block are computed here, after that query() does not modify this object
+    // and can be called from all worker threads.
     void  set_main_block(directive::MainBlock* main_block);
 
+    // A configuration is reference counted, the creator holds the first reference.
+    // Every request that queried this configuration has to retain it until the
+    // response is generated, release() deletes the object after the last reference.
+    // The counter is atomic, requests of all worker threads share the configuration.
+    void  retain();
+    void  release();
+
+    // Unique to every configuration object of the process, even when a new
+    // one is allocated at the address of a deleted one.
+    unsigned long                         generation() const;
+
     // Get all the server sockets.
     std::vector<const uri::Authority*>    all_server_sockets();
 
@@ -53,11 +71,20 @@ class Configuration
     void                                  register_server_socket(int server_socket_fd,
                                                                  const uri::Authority& socket);
 
+    // The parameters (backlog, ...) of the listen directive that configured the socket.
+    const directive::ListenOptions&       listen_options(const uri::Authority& socket);
+
     /////////////////////////////////////
     ////////////   getters   ////////////
     /////////////////////////////////////
 
     size_t                                worker_connections() const;
+    size_t                                shutdown_timeout() const;
+    size_t                                multi_accept() const;
+    std::string                           use() const;
+    size_t                                worker_threads() const;
+    size_t                                aio_threads() const;
+    size_t                                cpu_threads() const;
 
     ///////////////////////////////////////////
     ////////////   query methods   ////////////
@@ -76,11 +103,26 @@ class Configuration
   private:
     std::vector<cache::ServerQuery>       server_cache_;
     std::vector<cache::LocationQuery>     location_cache_;
-    int                                   location_insertion_index_;
+    // index in location_cache_ of a location block, or of a server block for the
+    // requests that match no location
+    std::map<const directive::DirectiveBlock*, size_t>  location_index_;
+    // every distinct root of the location cache opened once, the files of the
+    // requests are looked up relative to it
+    std::map<std::string, int>            root_fds_;
     directive::MainBlock*                 main_block_;
+    int                                   references_;
+    unsigned long                         generation_;
 
     void                                  generate_server_cache();
+    void                                  generate_location_cache();
+    void                                  open_root_directories();
+    void                                  close_root_directories();
+    typedef std::pair<const directive::ServerBlock*, const directive::LocationBlock*> LocationTarget;
+    void                                  add_location_targets(const directive::ServerBlock* server_block,
+                                                               directive::Locations locations,
+                                                               std::vector<LocationTarget>& targets);
     void                                  add_unique_server_cache(const uri::Authority* socket,
+                                                                  const directive::ListenOptions* options,
                                                                   const directive::ServerBlock* server_block);
 
     Configuration(const Configuration &other);
@@ -29,15 +29,21 @@ namespace cache
       match_path(),
       allowed_methods(),
       client_max_body_size(0),
+      client_header_buffer_size(0),
+      client_body_buffer_size(0),
       redirect(NULL),
       cgis(),
       root(),
+      root_fd(-1),
       indexes(),
       autoindex(false),
       mime_types(),
+      default_type(),
       error_pages(),
       access_log(),
-      error_log() {}
+      error_log(),
+      tcp_nodelay(true),
+      tcp_nopush(false) {}
 
   void  LocationQuery::construct(const directive::ServerBlock* server_block_, const directive::LocationBlock* location_block)
   {
@@ -50,6 +56,7 @@ namespace cache
       target_block = server_block;
     construct_allowed_methods(target_block);
     construct_client_max_body_size(target_block);
+    construct_client_buffer_sizes(target_block);
     construct_return(target_block);
     construct_cgis(target_block);
     construct_root(target_block);
@@ -59,6 +66,7 @@ namespace cache
     construct_error_pages(target_block);
     construct_access_log(target_block);
     construct_error_log(target_block);
+    construct_tcp_options(target_block);
   }
 
   void  LocationQuery::construct_match_path(const directive::LocationBlock* location_block)
@@ -128,11 +136,36 @@ namespace cache
     autoindex = directive ? directive->get() : constants::kDefaultAutoindex;
   }
 
+  void  LocationQuery::construct_client_buffer_sizes(const directive::DirectiveBlock* target_block)
+  {
+    const directive::ClientHeaderBufferSize* header_buffer_size = 
+      static_cast<const directive::ClientHeaderBufferSize*>(closest_directive(target_block, Directive::kDirectiveClientHeaderBufferSize));
+    const directive::ClientBodyBufferSize* body_buffer_size = 
+      static_cast<const directive::ClientBodyBufferSize*>(closest_directive(target_block, Directive::kDirectiveClientBodyBufferSize));
+
+    client_header_buffer_size = header_buffer_size ? header_buffer_size->get() : constants::kDefaultClientHeaderBufferSize;
+    client_body_buffer_size = body_buffer_size ? body_buffer_size->get() : constants::kDefaultClientBodyBufferSize;
+  }
+
+  void  LocationQuery::construct_tcp_options(const directive::DirectiveBlock* target_block)
+  {
+    const directive::TcpNodelay* nodelay = 
+      static_cast<const directive::TcpNodelay*>(closest_directive(target_block, Directive::kDirectiveTcpNodelay));
+    const directive::TcpNopush* nopush = 
+      static_cast<const directive::TcpNopush*>(closest_directive(target_block, Directive::kDirectiveTcpNopush));
+
+    tcp_nodelay = nodelay ? nodelay->get() : constants::kDefaultTcpNodelay;
+    tcp_nopush = nopush ? nopush->get() : constants::kDefaultTcpNopush;
+  }
+
   void  LocationQuery::construct_mime_types(const directive::DirectiveBlock* target_block)
   {
     mime_types = static_cast<const directive::MimeTypes*>(closest_directive(target_block, Directive::kDirectiveMimeTypes));
     if (!mime_types)
       mime_types = &constants::kDefaultMimeTypes;
+    const directive::DefaultType* directive = 
+      static_cast<const directive::DefaultType*>(closest_directive(target_block, Directive::kDirectiveDefaultType));
+    default_type = directive ? directive->get() : constants::kDefaultMimeType;
   }
 
   void  LocationQuery::construct_error_pages(const directive::DirectiveBlock* target_block)
@@ -33,18 +33,28 @@ namespace cache
     // direvtives to decide if the request is allowed
     directive::Methods                        allowed_methods;
     size_t                                    client_max_body_size;
+    // bytes asked from the socket per read, while reading the headers and the body
+    size_t                                    client_header_buffer_size;
+    size_t                                    client_body_buffer_size;
     // If return is not null, the request should be generated from this directive
     const directive::Return*                  redirect;
     // If cgi is not null, the request should be handled by a cgi script
     std::vector<const directive::Cgi*>        cgis;
     // directives to find the full path of the requested resource
     std::string                               root;
+    // the root directory opened by the configuration, -1 when it could not be opened
+    int                                       root_fd;
     std::vector<const directive::Index*>      indexes;
     bool                                      autoindex;
     const directive::MimeTypes*               mime_types;
+    // the type of the files whose extension is not in mime_types
+    std::string                               default_type;
     std::vector<const directive::ErrorPage*>  error_pages;
     std::string                               access_log;
     std::string                               error_log;
+    // socket options while sending the response
+    bool                                      tcp_nodelay;
+    bool                                      tcp_nopush;
 
     LocationQuery();
 
@@ -53,6 +63,7 @@ namespace cache
     void  construct_match_path(const directive::LocationBlock* location_block);
     void  construct_allowed_methods(const directive::DirectiveBlock* target_block);
     void  construct_client_max_body_size(const directive::DirectiveBlock* target_block);
+    void  construct_client_buffer_sizes(const directive::DirectiveBlock* target_block);
     void  construct_return(const directive::DirectiveBlock* target_block);
     void  construct_cgis(const directive::DirectiveBlock* target_block);
     void  construct_root(const directive::DirectiveBlock* target_block);
@@ -62,6 +73,7 @@ namespace cache
     void  construct_error_pages(const directive::DirectiveBlock* target_block);
     void  construct_access_log(const directive::DirectiveBlock* target_block);
     void  construct_error_log(const directive::DirectiveBlock* target_block);
+    void  construct_tcp_options(const directive::DirectiveBlock* target_block);
 
     const Directive*                closest_directive(const directive::DirectiveBlock* location_block, Directive::Type type);
     std::vector<const Directive*>   collect_directives(const directive::DirectiveBlock* location_block, Directive::Type type, DuplicateChecker is_duplicated);
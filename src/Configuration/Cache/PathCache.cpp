@@ -0,0 +1,112 @@
+#include "PathCache.hpp"
+
+#include <pthread.h>
+#include <cassert>
+
+namespace cache
+{
+  // a key rather than __thread, which would leak the cache of an exiting thread
+  static pthread_key_t  thread_cache_key;
+  static pthread_once_t thread_cache_once = PTHREAD_ONCE_INIT;
+
+  static void DeleteThreadCache(void* cache)
+  {
+    delete static_cast<PathCache*>(cache);
+  }
+
+  static void CreateThreadCacheKey()
+  {
+    int error = pthread_key_create(&thread_cache_key, &DeleteThreadCache);
+    assert(error == 0 && "PathCache: no thread specific key left");
+    (void)error;
+  }
+
+  const size_t  PathCache::kCapacity;
+  const size_t  PathCache::kMaxPathLength;
+
+  PathCache::PathCache()
+    : entries_(),
+      index_(),
+      generation_(0),
+      key_() {}
+
+  PathCache&  PathCache::thread_cache()
+  {
+    pthread_once(&thread_cache_once, &CreateThreadCacheKey);
+    PathCache*  cache = static_cast<PathCache*>(pthread_getspecific(thread_cache_key));
+    if (cache == NULL)
+    {
+      cache = new PathCache();
+      pthread_setspecific(thread_cache_key, cache);
+    }
+    return *cache;
+  }
+
+  const ResolvedPath* PathCache::find(const Configuration* database,
+                                      int server_socket_fd,
+                                      const std::string& host,
+                                      const StringView& raw_path)
+  {
+    use_configuration(database);
+    if (entries_.empty())
+      return NULL;
+    make_key(server_socket_fd, host, raw_path);
+    std::map<std::string, Entries::iterator>::iterator it = index_.find(key_);
+    if (it == index_.end())
+      return NULL;
+    // move the entry to the front, its iterator stays valid
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  const ResolvedPath* PathCache::insert(const Configuration* database,
+                                        int server_socket_fd,
+                                        const std::string& host,
+                                        const StringView& raw_path,
+                                        const ResolvedPath& resolved)
+  {
+    use_configuration(database);
+    if (raw_path.length > kMaxPathLength)
+      return NULL;
+    make_key(server_socket_fd, host, raw_path);
+    std::map<std::string, Entries::iterator>::iterator it = index_.find(key_);
+    if (it != index_.end())
+    {
+      it->second->second = resolved;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return &it->second->second;
+    }
+    if (entries_.size() == kCapacity)
+    {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.push_front(std::make_pair(key_, resolved));
+    index_.insert(std::make_pair(key_, entries_.begin()));
+    return &entries_.front().second;
+  }
+
+  size_t  PathCache::size() const
+  {
+    return entries_.size();
+  }
+
+  // the bytes of the socket, then the host and the path separated by a NUL byte
+  void  PathCache::make_key(int server_socket_fd, const std::string& host, const StringView& raw_path)
+  {
+    key_.assign(reinterpret_cast<const char*>(&server_socket_fd), sizeof(server_socket_fd));
+    key_ += '\0';
+    key_ += host;
+    key_ += '\0';
+    raw_path.append_to(key_);
+  }
+
+  void  PathCache::use_configuration(const Configuration* database)
+  {
+    if (database->generation() == generation_)
+      return;
+    entries_.clear();
+    index_.clear();
+    generation_ = database->generation();
+  }
+} // namespace cache
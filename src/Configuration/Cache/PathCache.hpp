@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "Configuration.hpp"
+#include "misc/StringView.hpp"
+
+namespace cache
+{
+  /**
+   * @brief What the routing found for the raw path of a request
+  */
+  struct ResolvedPath
+  {
+    ConfigurationQueryResult  config;
+    std::string               normalized_path; // uri::NormalizePath of the raw path
+    std::string               path;            // root of the location and normalized path
+  };
+
+  /**
+   * @brief The most recently resolved request paths of the calling thread
+   *
+   * A request is routed by its server socket, the host of its request line and
+   * the raw path of its target. The results refer to the location cache of one
+   * configuration, the cache is emptied when a request queries another one.
+   * Every thread has its own cache, so no lock is taken.
+  */
+  class PathCache
+  {
+    public:
+      static const size_t kCapacity = 128;
+      // longer paths are not cached
+      static const size_t kMaxPathLength = 1024;
+
+      PathCache();
+
+      static PathCache&   thread_cache();
+
+      // NULL when the path is not cached
+      const ResolvedPath* find(const Configuration* database,
+                               int server_socket_fd,
+                               const std::string& host,
+                               const StringView& raw_path);
+      // evicts the least recently used path when the cache is full
+      const ResolvedPath* insert(const Configuration* database,
+                                 int server_socket_fd,
+                                 const std::string& host,
+                                 const StringView& raw_path,
+                                 const ResolvedPath& resolved);
+      size_t              size() const;
+
+    private:
+      typedef std::list<std::pair<std::string, ResolvedPath> >  Entries;
+
+      Entries                                       entries_; // most recently used first
+      std::map<std::string, Entries::iterator>      index_;
+      unsigned long                                 generation_;
+      std::string                                   key_;
+
+      void  make_key(int server_socket_fd, const std::string& host, const StringView& raw_path);
+      void  use_configuration(const Configuration* database);
+
+      PathCache(const PathCache& other);
+      PathCache& operator=(const PathCache& other);
+  };
+} // namespace cache
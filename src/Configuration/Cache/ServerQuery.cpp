@@ -5,12 +5,15 @@ namespace cache
   ServerQuery::ServerQuery()
     : server_socket_fd(-1),
       socket(NULL),
+      options(NULL),
       server_blocks() {}
 
   ServerQuery::ServerQuery(const uri::Authority* socket,
+                           const directive::ListenOptions* options,
                            const directive::ServerBlock* server_block)
     : server_socket_fd(-1),
       socket(socket),
+      options(options),
       server_blocks()
   {
     server_blocks.push_back(server_block);
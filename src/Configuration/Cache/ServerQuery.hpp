@@ -4,6 +4,7 @@
 
 #include "Uri/Authority.hpp"
 #include "Configuration/Directive/Block/Server.hpp"
+#include "Configuration/Directive/Simple/Listen.hpp"
 
 namespace cache
 {
@@ -11,9 +12,12 @@ namespace cache
   {
     int                                         server_socket_fd;
     const uri::Authority*                       socket;
+    const directive::ListenOptions*             options; // from the first listen directive of the socket
     std::vector<const directive::ServerBlock*>  server_blocks;
 
     ServerQuery();
-    ServerQuery(const uri::Authority* socket, const directive::ServerBlock* server_block);
+    ServerQuery(const uri::Authority* socket,
+                const directive::ListenOptions* options,
+                const directive::ServerBlock* server_block);
   };
 } // namespace cache
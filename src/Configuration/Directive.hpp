@@ -31,18 +31,30 @@ class Directive
       kDirectiveRoot,
       kDirectiveIndex,
       kDirectiveMimeTypes,
+      kDirectiveDefaultType,
       kDirectiveErrorPage,
       // for HTTP request generation (generating content)
       kDirectiveClientMaxBodySize,
+      kDirectiveClientHeaderBufferSize,
+      kDirectiveClientBodyBufferSize,
       kDirectiveReturn,
       kDirectiveAutoindex,
       kDirectiveCgi,
+      // for sending the response
+      kDirectiveTcpNodelay,
+      kDirectiveTcpNopush,
       // misc
       kDirectiveAccessLog,
       kDirectiveErrorLog,
       kDirectiveInclude,
       // only in events block
-      kDirectiveWorkerConnections
+      kDirectiveWorkerConnections,
+      kDirectiveShutdownTimeout,
+      kDirectiveMultiAccept,
+      kDirectiveUse,
+      kDirectiveWorkerThreads,
+      kDirectiveAioThreads,
+      kDirectiveCpuThreads
     };
     Directive();
     explicit Directive(const Context& context);
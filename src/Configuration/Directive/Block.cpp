@@ -61,15 +61,26 @@ namespace directive
 	  case kDirectiveRoot: name = "root"; break;
 	  case kDirectiveIndex: name = "index"; break;
 	  case kDirectiveMimeTypes: name = "mime_type"; break;
+	  case kDirectiveDefaultType: name = "default_type"; break;
 	  case kDirectiveErrorPage: name = "error_pages"; break;
 	  case kDirectiveClientMaxBodySize: name = "client_max_body_size"; break;
+	  case kDirectiveClientHeaderBufferSize: name = "client_header_buffer_size"; break;
+	  case kDirectiveClientBodyBufferSize: name = "client_body_buffer_size"; break;
 	  case kDirectiveReturn: name = "return"; break;
 	  case kDirectiveAutoindex: name = "autoindex"; break;
 	  case kDirectiveCgi: name = "cgi"; break;
+	  case kDirectiveTcpNodelay: name = "tcp_nodelay"; break;
+	  case kDirectiveTcpNopush: name = "tcp_nopush"; break;
 	  case kDirectiveAccessLog: name = "access_log"; break;
 	  case kDirectiveErrorLog: name = "error_log"; break;
 	  case kDirectiveInclude: name = "include"; break;
 	  case kDirectiveWorkerConnections: name = "worker_connections"; break;
+	  case kDirectiveShutdownTimeout: name = "shutdown_timeout"; break;
+	  case kDirectiveMultiAccept: name = "multi_accept"; break;
+	  case kDirectiveUse: name = "use"; break;
+	  case kDirectiveWorkerThreads: name = "worker_threads"; break;
+	  case kDirectiveAioThreads: name = "aio_threads"; break;
+	  case kDirectiveCpuThreads: name = "cpu_threads"; break;
       }
 	  std::cout << name << ": ";
 	  if ((it->first == kDirectiveMain) ||
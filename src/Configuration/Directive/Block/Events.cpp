@@ -35,4 +35,52 @@ namespace directive
       return Nothing();
     return static_cast<WorkerConnections*>(query_result.first->second)->get();
   }
+
+  Maybe<size_t> EventsBlock::shutdown_timeout() const
+  {
+    DirectivesRange query_result = query_directive(Directive::kDirectiveShutdownTimeout);
+    if (query_result.first == query_result.second)
+      return Nothing();
+    return static_cast<ShutdownTimeout*>(query_result.first->second)->get();
+  }
+
+  Maybe<size_t> EventsBlock::multi_accept() const
+  {
+    DirectivesRange query_result = query_directive(Directive::kDirectiveMultiAccept);
+    if (query_result.first == query_result.second)
+      return Nothing();
+    return static_cast<MultiAccept*>(query_result.first->second)->get();
+  }
+
+  Maybe<std::string> EventsBlock::use() const
+  {
+    DirectivesRange query_result = query_directive(Directive::kDirectiveUse);
+    if (query_result.first == query_result.second)
+      return Nothing();
+    return static_cast<Use*>(query_result.first->second)->get();
+  }
+
+  Maybe<size_t> EventsBlock::worker_threads() const
+  {
+    DirectivesRange query_result = query_directive(Directive::kDirectiveWorkerThreads);
+    if (query_result.first == query_result.second)
+      return Nothing();
+    return static_cast<WorkerThreads*>(query_result.first->second)->get();
+  }
+
+  Maybe<size_t> EventsBlock::aio_threads() const
+  {
+    DirectivesRange query_result = query_directive(Directive::kDirectiveAioThreads);
+    if (query_result.first == query_result.second)
+      return Nothing();
+    return static_cast<AioThreads*>(query_result.first->second)->get();
+  }
+
+  Maybe<size_t> EventsBlock::cpu_threads() const
+  {
+    DirectivesRange query_result = query_directive(Directive::kDirectiveCpuThreads);
+    if (query_result.first == query_result.second)
+      return Nothing();
+    return static_cast<CpuThreads*>(query_result.first->second)->get();
+  }
 } // namespace configuration
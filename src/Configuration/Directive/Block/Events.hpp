@@ -19,5 +19,11 @@ namespace directive
       virtual Type  type() const;
 
       Maybe<size_t> worker_connections() const;
+      Maybe<size_t> shutdown_timeout() const;
+      Maybe<size_t> multi_accept() const;
+      Maybe<std::string> use() const;
+      Maybe<size_t> worker_threads() const;
+      Maybe<size_t> aio_threads() const;
+      Maybe<size_t> cpu_threads() const;
   };
 } // namespace configuration
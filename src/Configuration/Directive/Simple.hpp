@@ -33,11 +33,22 @@ namespace directive
 
   typedef DirectiveSimple<std::string, Directive::kDirectiveRoot> Root;
   typedef DirectiveSimple<std::string, Directive::kDirectiveIndex> Index;
+  typedef DirectiveSimple<std::string, Directive::kDirectiveDefaultType> DefaultType;
   typedef DirectiveSimple<size_t, Directive::kDirectiveClientMaxBodySize> ClientMaxBodySize;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveClientHeaderBufferSize> ClientHeaderBufferSize;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveClientBodyBufferSize> ClientBodyBufferSize;
   typedef DirectiveSimple<bool, Directive::kDirectiveAutoindex> Autoindex;
+  typedef DirectiveSimple<bool, Directive::kDirectiveTcpNodelay> TcpNodelay;
+  typedef DirectiveSimple<bool, Directive::kDirectiveTcpNopush> TcpNopush;
   typedef DirectiveSimple<std::string, Directive::kDirectiveAccessLog> AccessLog;
   typedef DirectiveSimple<std::string, Directive::kDirectiveErrorLog> ErrorLog;
   typedef DirectiveSimple<size_t, Directive::kDirectiveWorkerConnections> WorkerConnections;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveShutdownTimeout> ShutdownTimeout;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveMultiAccept> MultiAccept;
+  typedef DirectiveSimple<std::string, Directive::kDirectiveUse> Use;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveWorkerThreads> WorkerThreads;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveAioThreads> AioThreads;
+  typedef DirectiveSimple<size_t, Directive::kDirectiveCpuThreads> CpuThreads;
 
   //////////////////////////////////////////////////////
   ////////////   Template implementation   /////////////
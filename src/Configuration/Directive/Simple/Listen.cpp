@@ -5,17 +5,25 @@
 
 #include "Uri/Authority.hpp"
 #include "Configuration/Directive.hpp"
+#include "constants.hpp"
 
 namespace directive
 {
+  ListenOptions::ListenOptions()
+    : backlog(constants::kDefaultListenBacklog),
+      defer_accept(0),
+      fastopen(0),
+      rcvbuf(0),
+      sndbuf(0) {}
+
   Listen::Listen()
-    : Directive(), sockets_() {}
+    : Directive(), sockets_(), options_() {}
 
   Listen::Listen(const Context& context)
-    : Directive(context), sockets_() {}
+    : Directive(context), sockets_(), options_() {}
   
   Listen::Listen(const Listen& other)
-    : Directive(other), sockets_(other.sockets_) {}
+    : Directive(other), sockets_(other.sockets_), options_(other.options_) {}
   
   Listen& Listen::operator=(const Listen& other)
   {
@@ -23,6 +31,7 @@ namespace directive
     {
       Directive::operator=(other);
       sockets_ = other.sockets_;
+      options_ = other.options_;
     }
     return *this;
   }
@@ -51,6 +60,16 @@ namespace directive
 		it->print();
 	  }
 	}
+	if (options_.backlog != constants::kDefaultListenBacklog)
+	  std::cout << " backlog=" << options_.backlog;
+	if (options_.defer_accept)
+	  std::cout << " defer_accept=" << options_.defer_accept;
+	if (options_.fastopen)
+	  std::cout << " fastopen=" << options_.fastopen;
+	if (options_.rcvbuf)
+	  std::cout << " rcvbuf=" << options_.rcvbuf;
+	if (options_.sndbuf)
+	  std::cout << " sndbuf=" << options_.sndbuf;
   }
 
   void Listen::add(const uri::Authority& socket)
@@ -62,4 +81,14 @@ namespace directive
   {
     return sockets_;
   }
+
+  void Listen::set_options(const ListenOptions& options)
+  {
+    options_ = options;
+  }
+
+  const ListenOptions& Listen::options() const
+  {
+    return options_;
+  }
 } // namespace configuration
@@ -7,6 +7,18 @@
 
 namespace directive
 {
+  // parameters after the addresses of a listen directive, they apply to all of its addresses
+  struct ListenOptions
+  {
+    int backlog; // backlog=number
+    int defer_accept; // defer_accept=seconds, wake up the server only when the request arrives, 0 is off
+    int fastopen; // fastopen=number, queue length of TCP Fast Open connections, 0 is off
+    int rcvbuf; // rcvbuf=size, 0 keeps the system default
+    int sndbuf; // sndbuf=size, 0 keeps the system default
+
+    ListenOptions();
+  };
+
   class Listen : public Directive
   {
     public:
@@ -22,8 +34,11 @@ namespace directive
 
       void                        add(const uri::Authority& socket);
       const std::vector<uri::Authority>&  get() const;
+      void                        set_options(const ListenOptions& options);
+      const ListenOptions&        options() const;
 
     private:
       std::vector<uri::Authority> sockets_;
+      ListenOptions               options_;
   };
 } // namespace configuration
@@ -1,7 +1,10 @@
 #include "MimeTypes.hpp"
 
+#include <strings.h>
+
 #include <string>
 #include <map>
+#include <vector>
 #include <iostream>
 
 #include "misc/Maybe.hpp"
@@ -11,21 +14,35 @@
 namespace directive
 {
   MimeTypes::MimeTypes()
-    : Directive(), mime_types_() {}
+    : Directive(), mime_types_(), extensions_(), types_(), by_extension_(), by_type_() {}
   
+  // the types of the locations without a types block
   MimeTypes::MimeTypes(Nothing)
-    : Directive(), mime_types_()
+    : Directive(), mime_types_(), extensions_(), types_(), by_extension_(), by_type_()
   {
-    mime_types_["html"] = "text/html";
-    mime_types_["gif"] = "image/gif";
-    mime_types_["jpg"] = "image/jpeg";
+    add("html", "text/html");
+    add("htm", "text/html");
+    add("txt", "text/plain");
+    add("css", "text/css");
+    add("js", "text/javascript");
+    add("json", "application/json");
+    add("gif", "image/gif");
+    add("jpg", "image/jpeg");
+    add("jpeg", "image/jpeg");
+    add("png", "image/png");
+    build_indexes();
   }
 
   MimeTypes::MimeTypes(const Context& context)
-    : Directive(context), mime_types_() {}
+    : Directive(context), mime_types_(), extensions_(), types_(), by_extension_(), by_type_() {}
 
+  // the indexes point into the containers of their own object
   MimeTypes::MimeTypes(const MimeTypes& other)
-    : Directive(other), mime_types_(other.mime_types_) {}
+    : Directive(other), mime_types_(other.mime_types_), extensions_(other.extensions_),
+      types_(), by_extension_(), by_type_()
+  {
+    build_indexes();
+  }
 
   MimeTypes& MimeTypes::operator=(const MimeTypes& other)
   {
@@ -33,6 +50,8 @@ namespace directive
     {
       Directive::operator=(other);
       mime_types_ = other.mime_types_;
+      extensions_ = other.extensions_;
+      build_indexes();
     }
     return *this;
   }
@@ -61,8 +80,11 @@ namespace directive
     std::cout << '}';
   }
 
+  // a repeated extension takes the last type, the lookups see it after build_indexes()
   void MimeTypes::add(const MimeTypes::Extension& extension, const MimeTypes::MimeType& mime_type)
   {
+    if (mime_types_.find(extension) == mime_types_.end())
+      extensions_.push_back(extension);
     mime_types_[extension] = mime_type;
   }
 
@@ -73,9 +95,95 @@ namespace directive
 
   Maybe<MimeTypes::MimeType> MimeTypes::query(const MimeTypes::Extension& extension) const
   {
-    std::map<std::string, std::string>::const_iterator it = mime_types_.find(extension);
-    if (it != mime_types_.end())
-      return it->second;
+    const MimeType* mime_type = find_type(extension);
+    if (mime_type)
+      return *mime_type;
     return Nothing();
   }
+
+  const MimeTypes::MimeType* MimeTypes::find_type(const char* extension, size_t length) const
+  {
+    const Slot* slot = lookup(by_extension_, extension, length);
+    return slot ? slot->value : NULL;
+  }
+
+  const MimeTypes::MimeType* MimeTypes::find_type(const MimeTypes::Extension& extension) const
+  {
+    return find_type(extension.data(), extension.size());
+  }
+
+  const MimeTypes::Extension* MimeTypes::find_extension(const MimeTypes::MimeType& mime_type) const
+  {
+    const Slot* slot = lookup(by_type_, mime_type.data(), mime_type.size());
+    return slot ? slot->value : NULL;
+  }
+
+  const std::vector<MimeTypes::MimeType>& MimeTypes::types() const
+  {
+    return types_;
+  }
+
+  // Open addressing with linear probing, the capacity is a power of two at
+  // least twice the number of keys, so a probe ends on an empty slot.
+  void MimeTypes::build_indexes()
+  {
+    size_t  capacity = 8;
+    while (capacity < extensions_.size() * 2)
+      capacity *= 2;
+    by_extension_.assign(capacity, Slot());
+    by_type_.assign(capacity, Slot());
+    types_.clear();
+    // types_ does not reallocate, the type index points to its strings
+    types_.reserve(extensions_.size());
+    for (std::vector<Extension>::const_iterator it = extensions_.begin(); it != extensions_.end(); ++it)
+    {
+      std::map<Extension, MimeType>::const_iterator entry = mime_types_.find(*it);
+      insert(by_extension_, &entry->first, &entry->second);
+      if (lookup(by_type_, entry->second.data(), entry->second.size()) == NULL)
+      {
+        types_.push_back(entry->second);
+        insert(by_type_, &types_.back(), &entry->first);
+      }
+    }
+  }
+
+  void MimeTypes::insert(Index& index, const std::string* key, const std::string* value)
+  {
+    size_t  mask = index.size() - 1;
+    size_t  i = hash(key->data(), key->size()) & mask;
+    while (index[i].key != NULL)
+      i = (i + 1) & mask;
+    index[i].key = key;
+    index[i].value = value;
+  }
+
+  const MimeTypes::Slot* MimeTypes::lookup(const Index& index, const char* key, size_t length)
+  {
+    if (index.empty())
+      return NULL;
+    size_t  mask = index.size() - 1;
+    size_t  i = hash(key, length) & mask;
+    while (index[i].key != NULL)
+    {
+      const std::string&  candidate = *index[i].key;
+      if (candidate.size() == length && strncasecmp(candidate.data(), key, length) == 0)
+        return &index[i];
+      i = (i + 1) & mask;
+    }
+    return NULL;
+  }
+
+  // FNV-1a of the lowercase bytes
+  size_t MimeTypes::hash(const char* key, size_t length)
+  {
+    size_t  value = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+      unsigned char character = key[i];
+      if (character >= 'A' && character <= 'Z')
+        character += 'a' - 'A';
+      value = (value ^ character) * 16777619u;
+    }
+    return value;
+  }
 } // namespace configuration
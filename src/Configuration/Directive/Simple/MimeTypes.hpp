@@ -1,13 +1,23 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "misc/Maybe.hpp"
 #include "Configuration/Directive.hpp"
 
 namespace directive
 {
+  /**
+   * @brief The types block. Besides the map, build_indexes() builds two hash
+   * indexes, from an extension to its type and from a type to its canonical
+   * extension (the first one listed for it), once the block is filled. The
+   * block is only modified while the configuration is loaded, the lookups of
+   * the requests do not allocate. Extensions and types are compared without
+   * case.
+  */
   class MimeTypes : public Directive
   {
     public:
@@ -25,10 +35,33 @@ namespace directive
 	  virtual void					print(int indentation) const;
 
       void                          add(const Extension& extension, const MimeType& mime_type);
+      void                          build_indexes(); // after the last add()
       const std::map<Extension, MimeType>& get() const;
       Maybe<MimeType>               query(const Extension& extension) const;
 
+      // NULL when the extension or the type is not in the block
+      const MimeType*               find_type(const char* extension, size_t length) const;
+      const MimeType*               find_type(const Extension& extension) const;
+      const Extension*              find_extension(const MimeType& mime_type) const;
+      // every type once, in the order they are listed
+      const std::vector<MimeType>&  types() const;
+
     private:
+      struct Slot
+      {
+        const std::string*  key;   // NULL for an empty slot
+        const std::string*  value;
+      };
+      typedef std::vector<Slot>     Index;
+
       std::map<Extension, MimeType> mime_types_;
+      std::vector<Extension>        extensions_; // in the order they are listed
+      std::vector<MimeType>         types_;
+      Index                         by_extension_;
+      Index                         by_type_;
+
+      static void                   insert(Index& index, const std::string* key, const std::string* value);
+      static const Slot*            lookup(const Index& index, const char* key, size_t length);
+      static size_t                 hash(const char* key, size_t length);
   };
 } // namespace configuration
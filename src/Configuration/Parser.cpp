@@ -148,7 +148,8 @@ namespace directive_parser
           output.length = input.bytes - input_start;
           return output;
         }
-        else if (http_parser::ConsumeByCString(&input_temp, "worker_connection") == 17)
+        else if ((http_parser::ConsumeByCString(&input_temp, "worker_connections") == 18) ||
+                 (http_parser::ConsumeByCString(&input_temp, "worker_connection") == 17))
         {
           http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
           ParseOutput parsed_worker_connection = http_parser::ConsumeByParserFunction(&input_temp, &ParseWorkerConnections);
@@ -165,6 +166,113 @@ namespace directive_parser
             break;
           }
         }
+        else if (http_parser::ConsumeByCString(&input_temp, "shutdown_timeout") == 16)
+        {
+          http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+          ParseOutput parsed_shutdown_timeout = http_parser::ConsumeByParserFunction(&input_temp, &ParseShutdownTimeout);
+          if (parsed_shutdown_timeout.is_valid())
+          {
+            http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+            http_parser::ConsumeByCString(&input_temp, ";");
+            input = input_temp;
+            event_block->add_directive(static_cast<Directive*>(parsed_shutdown_timeout.result));
+          }
+          else
+          {
+            delete event_block;
+            break;
+          }
+        }
+        else if (http_parser::ConsumeByCString(&input_temp, "multi_accept") == 12)
+        {
+          http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+          ParseOutput parsed_multi_accept = http_parser::ConsumeByParserFunction(&input_temp, &ParseMultiAccept);
+          if (parsed_multi_accept.is_valid())
+          {
+            http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+            http_parser::ConsumeByCString(&input_temp, ";");
+            input = input_temp;
+            event_block->add_directive(static_cast<Directive*>(parsed_multi_accept.result));
+          }
+          else
+          {
+            delete event_block;
+            break;
+          }
+        }
+        else if (http_parser::ConsumeByCString(&input_temp, "use") == 3)
+        {
+          http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+          ParseOutput parsed_use = http_parser::ConsumeByParserFunction(&input_temp, &ParseUse);
+          if (parsed_use.is_valid())
+          {
+            http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+            http_parser::ConsumeByCString(&input_temp, ";");
+            input = input_temp;
+            event_block->add_directive(static_cast<Directive*>(parsed_use.result));
+          }
+          else
+          {
+            delete event_block;
+            break;
+          }
+        }
+        else if (http_parser::ConsumeByCString(&input_temp, "worker_threads") == 14)
+        {
+          http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+          ParseOutput parsed_worker_threads = http_parser::ConsumeByParserFunction(&input_temp, &ParseWorkerThreads);
+          if (parsed_worker_threads.is_valid())
+          {
+            http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+            http_parser::ConsumeByCString(&input_temp, ";");
+            input = input_temp;
+            event_block->add_directive(static_cast<Directive*>(parsed_worker_threads.result));
+          }
+          else
+          {
+            delete event_block;
+            break;
+          }
+        }
+        else if (http_parser::ConsumeByCString(&input_temp, "aio_threads") == 11)
+        {
+          http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+          ParseOutput parsed_aio_threads = http_parser::ConsumeByParserFunction(&input_temp, &ParseAioThreads);
+          if (parsed_aio_threads.is_valid())
+          {
+            http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+            http_parser::ConsumeByCString(&input_temp, ";");
+            input = input_temp;
+            event_block->add_directive(static_cast<Directive*>(parsed_aio_threads.result));
+          }
+          else
+          {
+            delete event_block;
+            break;
+          }
+        }
+        else if (http_parser::ConsumeByCString(&input_temp, "cpu_threads") == 11)
+        {
+          http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+          ParseOutput parsed_cpu_threads = http_parser::ConsumeByParserFunction(&input_temp, &ParseCpuThreads);
+          if (parsed_cpu_threads.is_valid())
+          {
+            http_parser::ConsumeByScanFunction(&input_temp, &ScanOptionalWhitespace);
+            http_parser::ConsumeByCString(&input_temp, ";");
+            input = input_temp;
+            event_block->add_directive(static_cast<Directive*>(parsed_cpu_threads.result));
+          }
+          else
+          {
+            delete event_block;
+            break;
+          }
+        }
+        else
+        {
+          delete event_block;
+          break;
+        }
       }
     }
     return output;
@@ -212,6 +320,15 @@ namespace directive_parser
         directive = static_cast<Directive*>(parsed_directive.result);
       }
     }
+    else if (http_parser::ConsumeByCString(&input, "default_type") == 12)
+    {
+      http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
+      ParseOutput parsed_directive = http_parser::ConsumeByParserFunction(&input, &ParseDefaultType);
+      if (parsed_directive.is_valid())
+      {
+        directive = static_cast<Directive*>(parsed_directive.result);
+      }
+    }
     else if (http_parser::ConsumeByCString(&input, "error_pages") == 11)
     {
       http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
@@ -230,6 +347,24 @@ namespace directive_parser
         directive = static_cast<Directive*>(parsed_directive.result);
       }
     }
+    else if (http_parser::ConsumeByCString(&input, "client_header_buffer_size") == 25)
+    {
+      http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
+      ParseOutput parsed_directive = http_parser::ConsumeByParserFunction(&input, &ParseClientHeaderBufferSize);
+      if (parsed_directive.is_valid())
+      {
+        directive = static_cast<Directive*>(parsed_directive.result);
+      }
+    }
+    else if (http_parser::ConsumeByCString(&input, "client_body_buffer_size") == 23)
+    {
+      http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
+      ParseOutput parsed_directive = http_parser::ConsumeByParserFunction(&input, &ParseClientBodyBufferSize);
+      if (parsed_directive.is_valid())
+      {
+        directive = static_cast<Directive*>(parsed_directive.result);
+      }
+    }
     else if (http_parser::ConsumeByCString(&input, "autoindex") == 9)
     {
       http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
@@ -275,6 +410,24 @@ namespace directive_parser
         directive = static_cast<Directive*>(parsed_directive.result);
       }
     }
+    else if (http_parser::ConsumeByCString(&input, "tcp_nodelay") == 11)
+    {
+      http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
+      ParseOutput parsed_directive = http_parser::ConsumeByParserFunction(&input, &ParseTcpNodelay);
+      if (parsed_directive.is_valid())
+      {
+        directive = static_cast<Directive*>(parsed_directive.result);
+      }
+    }
+    else if (http_parser::ConsumeByCString(&input, "tcp_nopush") == 10)
+    {
+      http_parser::ConsumeByScanFunction(&input, &ScanOptionalWhitespace);
+      ParseOutput parsed_directive = http_parser::ConsumeByParserFunction(&input, &ParseTcpNopush);
+      if (parsed_directive.is_valid())
+      {
+        directive = static_cast<Directive*>(parsed_directive.result);
+      }
+    }
     if (directive)
     {
       output.result = directive;
@@ -613,7 +766,42 @@ namespace directive_parser
     return output;
   }
 
-  ParseOutput ParseClientMaxBodySize(ParseInput input)
+  template <typename T>
+  static ParseOutput ParseOnOff(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+
+    if (http_parser::ConsumeByCString(&input, "on") == 2)
+    {
+      T*  directive = new T();
+      directive->set(true);
+      output.result = directive;
+      output.length = input.bytes - input_start;
+    }
+    else if (http_parser::ConsumeByCString(&input, "off") == 3)
+    {
+      T*  directive = new T();
+      directive->set(false);
+      output.result = directive;
+      output.length = input.bytes - input_start;
+    }
+    return output;
+  }
+
+  ParseOutput ParseTcpNodelay(ParseInput input)
+  {
+    return ParseOnOff<directive::TcpNodelay>(input);
+  }
+
+  ParseOutput ParseTcpNopush(ParseInput input)
+  {
+    return ParseOnOff<directive::TcpNopush>(input);
+  }
+
+  // number with an optional unit k or m
+  template <typename T>
+  static ParseOutput ParseSize(ParseInput input, bool allow_zero)
   {
     ParseOutput output;
     const char* input_start = input.bytes;
@@ -625,7 +813,7 @@ namespace directive_parser
       number = number * 10 + (*input.bytes - '0');
       input.consume();
     }
-    if ((input.bytes - input_start) > 0)
+    if ((input.bytes - input_start) > 0 && (allow_zero || number > 0))
     {
       if (http_parser::ConsumeByCString(&input, "k"))
       {
@@ -635,14 +823,29 @@ namespace directive_parser
       {
         number *= 1000000;
       }
-      directive::ClientMaxBodySize* client_max_body_size = new directive::ClientMaxBodySize();
-      client_max_body_size->set(number);
-      output.result = client_max_body_size;
+      T*  directive = new T();
+      directive->set(number);
+      output.result = directive;
       output.length = input.bytes - input_start;
     }
     return output;
   }
 
+  ParseOutput ParseClientMaxBodySize(ParseInput input)
+  {
+    return ParseSize<directive::ClientMaxBodySize>(input, true);
+  }
+
+  ParseOutput ParseClientHeaderBufferSize(ParseInput input)
+  {
+    return ParseSize<directive::ClientHeaderBufferSize>(input, false);
+  }
+
+  ParseOutput ParseClientBodyBufferSize(ParseInput input)
+  {
+    return ParseSize<directive::ClientBodyBufferSize>(input, false);
+  }
+
   ParseOutput ParseAccessLog(ParseInput input)
   {
     ParseOutput output;
@@ -695,6 +898,132 @@ namespace directive_parser
     return output;
   }
 
+  // shutdown_timeout is in seconds, 0 closes all connections right away
+  ParseOutput ParseShutdownTimeout(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+    size_t number = 0;
+    while ((input.length > 0) && http_parser::IsDigit(*input.bytes))
+    {
+      number = number * 10 + (*input.bytes - '0');
+      input.consume();
+    }
+    if ((input.bytes - input_start) > 0)
+    {
+      directive::ShutdownTimeout* shutdown_timeout = new directive::ShutdownTimeout();
+      shutdown_timeout->set(number);
+      output.result = shutdown_timeout;
+      output.length = input.bytes - input_start;
+    }
+    return output;
+  }
+
+  // maximum amount of connections accepted from one listening socket per event loop iteration
+  ParseOutput ParseMultiAccept(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+    size_t number = 0;
+    while ((input.length > 0) && http_parser::IsDigit(*input.bytes))
+    {
+      number = number * 10 + (*input.bytes - '0');
+      input.consume();
+    }
+    if (((input.bytes - input_start) > 0) && (number > 0))
+    {
+      directive::MultiAccept* multi_accept = new directive::MultiAccept();
+      multi_accept->set(number);
+      output.result = multi_accept;
+      output.length = input.bytes - input_start;
+    }
+    return output;
+  }
+
+  // number of event loops, each one runs in its own thread
+  ParseOutput ParseWorkerThreads(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+    size_t number = 0;
+    while ((input.length > 0) && http_parser::IsDigit(*input.bytes))
+    {
+      number = number * 10 + (*input.bytes - '0');
+      input.consume();
+    }
+    if (((input.bytes - input_start) > 0) && (number > 0))
+    {
+      directive::WorkerThreads* worker_threads = new directive::WorkerThreads();
+      worker_threads->set(number);
+      output.result = worker_threads;
+      output.length = input.bytes - input_start;
+    }
+    return output;
+  }
+
+  // threads of the disk I/O pool, 0 keeps the disk operations in the event loops
+  ParseOutput ParseAioThreads(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+    size_t number = 0;
+    while ((input.length > 0) && http_parser::IsDigit(*input.bytes))
+    {
+      number = number * 10 + (*input.bytes - '0');
+      input.consume();
+    }
+    if ((input.bytes - input_start) > 0)
+    {
+      directive::AioThreads* aio_threads = new directive::AioThreads();
+      aio_threads->set(number);
+      output.result = aio_threads;
+      output.length = input.bytes - input_start;
+    }
+    return output;
+  }
+
+  // threads of the work-stealing pool, 0 builds the listings in the event loops
+  ParseOutput ParseCpuThreads(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+    size_t number = 0;
+    while ((input.length > 0) && http_parser::IsDigit(*input.bytes))
+    {
+      number = number * 10 + (*input.bytes - '0');
+      input.consume();
+    }
+    if ((input.bytes - input_start) > 0)
+    {
+      directive::CpuThreads* cpu_threads = new directive::CpuThreads();
+      cpu_threads->set(number);
+      output.result = cpu_threads;
+      output.length = input.bytes - input_start;
+    }
+    return output;
+  }
+
+  // event notification method of the connection loop
+  ParseOutput ParseUse(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+    const char* methods[] = {"io_uring", "epoll", "poll"};
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+    {
+      if (http_parser::ConsumeByCString(&input, methods[i]) > 0)
+      {
+        directive::Use* use = new directive::Use();
+        use->set(methods[i]);
+        output.result = use;
+        output.length = input.bytes - input_start;
+        break;
+      }
+    }
+    return output;
+  }
+
   ParseOutput ParseAllowMethods(ParseInput input)
   {
     ParseOutput output;
@@ -808,6 +1137,62 @@ namespace directive_parser
     return output;
   }
 
+  // number with an optional unit k or m, the same way as client_max_body_size
+  static bool ParseListenNumber(ParseInput* input, int* number, bool with_unit)
+  {
+    ParseInput  input_temp = *input;
+    const char* start = input_temp.bytes;
+    int         value = 0;
+    while ((input_temp.length > 0) && http_parser::IsDigit(*input_temp.bytes))
+    {
+      value = value * 10 + (*input_temp.bytes - '0');
+      input_temp.consume();
+    }
+    if ((input_temp.bytes - start) == 0)
+      return false;
+    if (with_unit && http_parser::ConsumeByCString(&input_temp, "k"))
+      value *= 1000;
+    else if (with_unit && http_parser::ConsumeByCString(&input_temp, "m"))
+      value *= 1000000;
+    *number = value;
+    *input = input_temp;
+    return true;
+  }
+
+  // parameters of the listen directive, in the form name=value
+  static bool ParseListenOption(ParseInput* input, directive::ListenOptions* options)
+  {
+    struct ListenOption
+    {
+      const char* name;
+      int         directive::ListenOptions::*value;
+      bool        with_unit;
+      int         minimum;
+    };
+    static const ListenOption listen_options[] = {
+      { "backlog=", &directive::ListenOptions::backlog, false, 1 },
+      { "defer_accept=", &directive::ListenOptions::defer_accept, false, 0 },
+      { "fastopen=", &directive::ListenOptions::fastopen, false, 0 },
+      { "rcvbuf=", &directive::ListenOptions::rcvbuf, true, 1 },
+      { "sndbuf=", &directive::ListenOptions::sndbuf, true, 1 }
+    };
+
+    for (size_t i = 0; i < sizeof(listen_options) / sizeof(listen_options[0]); i++)
+    {
+      ParseInput  input_temp = *input;
+      int         number = 0;
+      if ((http_parser::ConsumeByCString(&input_temp, listen_options[i].name) > 0) &&
+          ParseListenNumber(&input_temp, &number, listen_options[i].with_unit) &&
+          (number >= listen_options[i].minimum))
+      {
+        options->*(listen_options[i].value) = number;
+        *input = input_temp;
+        return true;
+      }
+    }
+    return false;
+  }
+
   ParseOutput ParseListen(ParseInput input)
   {
     ParseOutput output;
@@ -827,10 +1212,13 @@ namespace directive_parser
       delete listen;
       return output;
     }
+    directive::ListenOptions options;
     while (input.length > 0)
     {
       if (!http_parser::ConsumeByScanFunction(&input, &ScanRequiredWhitespace).is_valid())
         break;
+      if (ParseListenOption(&input, &options))
+        continue;
       snapshot = temporary::arena.snapshot();
       ParseOutput tmp = http_parser::ConsumeByParserFunction(&input, &http_parser::ParseUriAuthority);
       if (tmp.is_valid() && (AnalysisUriAuthority((http_parser::PTNodeUriAuthority*) tmp.result, &authority) == kNone))
@@ -843,6 +1231,7 @@ namespace directive_parser
         break;
       }
     }
+    listen->set_options(options);
     output.result = listen;
     output.length = input.bytes - input_start;
     return output;
@@ -890,6 +1279,7 @@ namespace directive_parser
       }
       if (mime_types)
       {
+        mime_types->build_indexes();
         output.result = mime_types;
         output.length = input.bytes - input_start;
       }
@@ -897,6 +1287,25 @@ namespace directive_parser
     return output;
   }
 
+  // a content type, the same as the types block
+  ParseOutput ParseDefaultType(ParseInput input)
+  {
+    ParseOutput output;
+    const char* input_start = input.bytes;
+
+    ArenaSnapshot snapshot = temporary::arena.snapshot();
+    ParseOutput parsed_mime_type = http_parser::ConsumeByParserFunction(&input, &http_parser::ParseFieldContentType);
+    if (parsed_mime_type.is_valid())
+    {
+      directive::DefaultType* default_type = new directive::DefaultType();
+      default_type->set(((http_parser::PTNodeFieldContentType*)parsed_mime_type.result)->content.to_string());
+      output.result = default_type;
+      output.length = input.bytes - input_start;
+    }
+    temporary::arena.rollback(snapshot);
+    return output;
+  }
+
   ParseOutput ParseReturn(ParseInput input)
   {
     ParseOutput output;
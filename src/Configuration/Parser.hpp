@@ -18,15 +18,26 @@ namespace directive_parser
   ParseOutput ParseIndex(ParseInput input);
   ParseOutput ParseAutoIndex(ParseInput input);
   ParseOutput ParseClientMaxBodySize(ParseInput input);
+  ParseOutput ParseClientHeaderBufferSize(ParseInput input);
+  ParseOutput ParseClientBodyBufferSize(ParseInput input);
+  ParseOutput ParseTcpNodelay(ParseInput input);
+  ParseOutput ParseTcpNopush(ParseInput input);
   ParseOutput ParseAccessLog(ParseInput input);
   ParseOutput ParseErrorLog(ParseInput input);
   ParseOutput ParseWorkerConnections(ParseInput input);
+  ParseOutput ParseShutdownTimeout(ParseInput input);
+  ParseOutput ParseMultiAccept(ParseInput input);
+  ParseOutput ParseUse(ParseInput input);
+  ParseOutput ParseWorkerThreads(ParseInput input);
+  ParseOutput ParseAioThreads(ParseInput input);
+  ParseOutput ParseCpuThreads(ParseInput input);
 
   ParseOutput ParseAllowMethods(ParseInput input);
   ParseOutput ParseCgi(ParseInput input);
   ParseOutput ParseErrorPages(ParseInput input);
   ParseOutput ParseListen(ParseInput input);
   ParseOutput ParseMimeTypes(ParseInput input);
+  ParseOutput ParseDefaultType(ParseInput input);
   ParseOutput ParseReturn(ParseInput input);
   ParseOutput ParseServerName(ParseInput input);
 } // namespace directive
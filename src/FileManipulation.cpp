@@ -1,23 +1,97 @@
 #include "Client.hpp"
 
+#include <fcntl.h>
 #include <string.h>
+#include <sys/syscall.h>
 #include <cassert>
 
-bool process::file::ModifyFile(struct Client *clt)
+#ifdef SYS_openat2
+# include <linux/openat2.h>
+#endif
+
+#ifdef SYS_openat2
+// set by the first openat2 that the kernel does not implement, the workers
+// and the pool threads share it
+static int	openat2_unsupported = 0;
+
+static bool	OpenAt2Unsupported()
 {
-	std::ofstream file(clt->path.c_str());
-	if (!file.is_open())
+	return (__sync_add_and_fetch(&openat2_unsupported, 0) != 0);
+}
+#endif
+
+#ifdef O_PATH
+static const int	kDirectoryLookup = O_PATH | O_DIRECTORY;
+#else
+static const int	kDirectoryLookup = O_RDONLY | O_DIRECTORY;
+#endif
+
+// the directory to resolve from and the path relative to it
+static const char	*RelativePath(const cache::LocationQuery *location, const std::string &path, int *directory_fd)
+{
+	const std::string	&root = location->root;
+
+	if (location->root_fd == -1 || path.compare(0, root.size(), root) != 0)
 	{
-		return false;
+		*directory_fd = AT_FDCWD;
+		return (path.c_str());
 	}
-	file << clt->req.getRequestBody();
-	if (file.good())
+	*directory_fd = location->root_fd;
+	const char	*relative = path.c_str() + root.size();
+	while (*relative == '/')
+		relative++;
+	if (*relative == '\0')
+		return (".");
+	return (relative);
+}
+
+// the parent directory of the path opened beneath the root, and the last component of the path,
+// empty when the path ends with a slash
+static int	OpenParentBeneath(const cache::LocationQuery *location, const std::string &path, std::string *name)
+{
+	size_t	pos = path.find_last_of('/');
+	if (pos == std::string::npos)
 	{
-		file.close();
-		return true;
+		*name = path;
+		return (process::file::OpenBeneath(location, ".", kDirectoryLookup));
 	}
-	file.close();
-	return false;
+	*name = path.substr(pos + 1);
+	return (process::file::OpenBeneath(location, path.substr(0, pos + 1), kDirectoryLookup));
+}
+
+static bool	WriteBody(int fd, StringView body)
+{
+	size_t	written = 0;
+	while (written < body.length)
+	{
+		ssize_t	result = write(fd, body.bytes + written, body.length - written);
+		if (result == -1 && errno == EINTR)
+			continue;
+		if (result == -1)
+		{
+			std::cerr << "write: " << strerror(errno) << std::endl;
+			return (false);
+		}
+		written += result;
+	}
+	return (true);
+}
+
+// the file is created or truncated beneath the root, and the body written to it
+static bool	WriteFileBeneath(const cache::LocationQuery *location, const std::string &path, StringView body)
+{
+	int	fd = process::file::OpenBeneath(location, path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1)
+		return (false);
+	bool	written = WriteBody(fd, body);
+	if (close(fd) != 0)
+		return (false);
+	return (written);
+}
+
+bool process::file::ModifyFile(struct Client *clt)
+{
+	return (WriteFileBeneath(clt->config.query, clt->path, clt->req.getRequestBody()));
 }
 
 bool process::file::UploadFile(struct Client *clt)
@@ -35,7 +109,7 @@ bool process::file::UploadFile(struct Client *clt)
 	size_t pos = file_path.find_last_of(".");
 	if (pos != std::string::npos && file_path[pos + 1] == '/')
 	{
-		HeaderString *content_type = static_cast<HeaderString *>(clt->req.returnValueAsPointer("Content-Type"));
+		HeaderString *content_type = static_cast<HeaderString *>(clt->req.returnValueAsPointer(kHeaderContentType));
 		if (content_type)
 		{
 			file_path += ".";
@@ -44,19 +118,10 @@ bool process::file::UploadFile(struct Client *clt)
 	}
 
 	//create file and all the directories in the path
-	if (!CreateDirRecurs(file_path))
+	if (!CreateDirsBeneath(clt->config.query, file_path))
 		return false;
-	std::ofstream file(file_path.c_str());
-	if (!file.is_open())
-		return false;
-	//write to file
-	file << clt->req.getRequestBody();
-	if (!file.good())
-	{
-		file.close();
+	if (!WriteFileBeneath(clt->config.query, file_path, clt->req.getRequestBody()))
 		return false;
-	}
-	file.close();
 
 	//Write to the location_created variable in the client struct
 	//the full path for gettting info about the file later when generating response
@@ -66,11 +131,95 @@ bool process::file::UploadFile(struct Client *clt)
 	return true;
 }
 
+// the link itself is removed when the file is one, from its parent resolved beneath the root
 bool process::file::DeleteFile(struct Client *clt)
 {
-	if (remove(clt->path.c_str()) != 0)
+	std::string	name;
+	int	directory_fd = OpenParentBeneath(clt->config.query, clt->path, &name);
+
+	if (directory_fd == -1)
 		return false;
-	return true;
+	int	result = unlinkat(directory_fd, name.c_str(), 0);
+	close(directory_fd);
+	return (result == 0);
+}
+
+int	process::file::OpenBeneath(const cache::LocationQuery *location, const std::string &path, int flags, mode_t mode)
+{
+	int			directory_fd;
+	const char	*relative = RelativePath(location, path, &directory_fd);
+
+#ifdef SYS_openat2
+	if (directory_fd != AT_FDCWD && !OpenAt2Unsupported())
+	{
+		struct open_how	how;
+		memset(&how, 0, sizeof(how));
+		how.flags = flags | O_CLOEXEC;
+		how.mode = mode;
+		how.resolve = RESOLVE_BENEATH;
+		int	fd = syscall(SYS_openat2, directory_fd, relative, &how, sizeof(how));
+		if (fd != -1 || errno != ENOSYS)
+			return (fd);
+		__sync_lock_test_and_set(&openat2_unsupported, 1);
+	}
+#endif
+	return (openat(directory_fd, relative, flags | O_CLOEXEC, mode));
+}
+
+// without openat2 the path is still normalized, a single fstatat is enough
+int	process::file::StatBeneath(const cache::LocationQuery *location, const std::string &path, struct stat *buff)
+{
+#if defined(SYS_openat2) && defined(O_PATH)
+	if (!OpenAt2Unsupported())
+	{
+		int	fd = OpenBeneath(location, path, O_PATH);
+		if (fd == -1)
+			return (-1);
+		int	result = fstat(fd, buff);
+		close(fd);
+		return (result);
+	}
+#endif
+	int			directory_fd;
+	const char	*relative = RelativePath(location, path, &directory_fd);
+	return (fstatat(directory_fd, relative, buff, 0));
+}
+
+// with openat2 a link as the last component is resolved beneath the root too, otherwise only
+// the directories of the path are
+int	process::file::AccessBeneath(const cache::LocationQuery *location, const std::string &path, int mode)
+{
+#if defined(SYS_openat2) && defined(O_PATH) && defined(AT_EMPTY_PATH)
+	if (!OpenAt2Unsupported())
+	{
+		int	fd = OpenBeneath(location, path, O_PATH);
+		if (fd == -1)
+			return (-1);
+		int	result = faccessat(fd, "", mode, AT_EMPTY_PATH);
+		close(fd);
+		// EINVAL from a kernel with openat2 but without faccessat2
+		if (result == 0 || errno != EINVAL)
+			return (result);
+	}
+#endif
+	std::string	name;
+	int	directory_fd = OpenParentBeneath(location, path, &name);
+	if (directory_fd == -1)
+		return (-1);
+	int	result = faccessat(directory_fd, name.empty() ? "." : name.c_str(), mode, 0);
+	close(directory_fd);
+	return (result);
+}
+
+DIR	*process::file::OpenDirBeneath(const cache::LocationQuery *location, const std::string &path)
+{
+	int	fd = OpenBeneath(location, path, O_RDONLY | O_DIRECTORY);
+	if (fd == -1)
+		return (NULL);
+	DIR	*dir_stream = fdopendir(fd);
+	if (dir_stream == NULL)
+		close(fd);
+	return (dir_stream);
 }
 
 //helper functions
@@ -79,65 +228,47 @@ std::string process::file::GenerateFileName(std::string path)
 	(void) path;
 	std::time_t	time = std::time(NULL);
 	char time_buf[80];
-	std::strftime(time_buf, 80, "%Y-%m-%dT%H-%M-%SZ", std::gmtime(&time));
+	struct tm	time_info;
+	gmtime_r(&time, &time_info);
+	std::strftime(time_buf, 80, "%Y-%m-%dT%H-%M-%SZ", &time_info);
 	return (std::string(time_buf));
 }
 
 std::string	process::file::GenerateFileExtension(std::string content_type, const directive::MimeTypes* mime_types)
 {
-	const std::map<std::string, std::string> &mime_map = mime_types->get();
-	std::map<std::string, std::string>::const_iterator it;
-	for (it = mime_map.begin(); it != mime_map.end(); it++)
-	{
-		if (it->second == content_type)
-		{
-			return it->first;
-		}
-	}
-	return "";
+	const directive::MimeTypes::Extension	*extension = mime_types->find_extension(content_type);
+	return extension ? *extension : "";
 }
 
-bool process::file::CreateDir(std::string dir)
+// mkdir from the parent of dir, resolved beneath the root
+bool process::file::CreateDirBeneath(const cache::LocationQuery *location, const std::string &dir)
 {
 	struct stat buffer;
-	int status = stat(dir.c_str(), &buffer);
-	if (status == 0 && S_ISDIR(buffer.st_mode))
-	{
-		std::cout << "Directory exists" << std::endl;
+	if (StatBeneath(location, dir, &buffer) == 0 && S_ISDIR(buffer.st_mode))
 		return true;
-	}
-	else
+	std::string	name;
+	int	directory_fd = OpenParentBeneath(location, dir, &name);
+	if (directory_fd == -1)
 	{
-		// std::cout << path << std::endl;
-		if (mkdir(dir.c_str(), 0777) != 0)
-		{
-			std::cout << "Error creating directory" << std::endl;
-			std::cerr << strerror(errno) << std::endl;
-			return false;
-		}
-		else
-		{
-			std::cout << "Directory created" << std::endl;
-			return true;
-		}
+		std::cerr << "Error creating directory " << dir << ": " << strerror(errno) << std::endl;
+		return false;
 	}
+	bool	created = mkdirat(directory_fd, name.c_str(), 0777) == 0 || errno == EEXIST;
+	if (!created)
+		std::cerr << "Error creating directory " << dir << ": " << strerror(errno) << std::endl;
+	close(directory_fd);
+	return (created);
 }
 
-bool process::file::CreateDirRecurs(std::string path)
+// the directories of the path, the last component is the file
+bool process::file::CreateDirsBeneath(const cache::LocationQuery *location, const std::string &path)
 {
-	size_t pos = 0;
-	pos = path.find_first_of("/", pos + 1);
-	std::string create_dir = path.substr(0, pos);
-	std::cout << create_dir << std::endl;
+	size_t pos = path.find_first_of("/", 1);
 	while (pos != std::string::npos)
 	{
-		if (!CreateDir(create_dir))
-		{
+		if (!CreateDirBeneath(location, path.substr(0, pos)))
 			return false;
-		}
 		pos = path.find_first_of("/", pos + 1);
-		create_dir = path.substr(0, pos);
-		std::cout << create_dir << std::endl;
 	}
 	return true;
 }
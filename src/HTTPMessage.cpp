@@ -1,15 +1,98 @@
 #include "HTTPMessage.hpp"
 
-HTTPMessage::HTTPMessage() {}
+#include <strings.h>
 
-HTTPMessage::HTTPMessage(const HTTPMessage &obj)
+#include <cassert>
+#include <cstring>
+
+#include "Arenas.hpp"
+#include "Http/Parser.hpp"
+
+namespace
+{
+	const std::string	kHeaderNames[kHeaderUnknown] = {
+		"Accept",
+		"Allow",
+		"Connection",
+		"Content-Length",
+		"Content-Type",
+		"Date",
+		"Host",
+		"Last-Modified",
+		"Location",
+		"Referer",
+		"Server",
+		"Transfer-Encoding",
+		"User-Agent"
+	};
+}
+
+// The length and the first letter select the only candidate, which is then
+// compared once. Keep the switch in sync with kHeaderNames.
+HeaderId	header::Intern(const char *name, size_t length)
+{
+	HeaderId	candidate = kHeaderUnknown;
+
+	if (length == 0)
+		return (kHeaderUnknown);
+	switch (length << 8 | (name[0] | 0x20))
+	{
+	case 4 << 8 | 'd': candidate = kHeaderDate; break;
+	case 4 << 8 | 'h': candidate = kHeaderHost; break;
+	case 5 << 8 | 'a': candidate = kHeaderAllow; break;
+	case 6 << 8 | 'a': candidate = kHeaderAccept; break;
+	case 6 << 8 | 's': candidate = kHeaderServer; break;
+	case 7 << 8 | 'r': candidate = kHeaderReferer; break;
+	case 8 << 8 | 'l': candidate = kHeaderLocation; break;
+	case 10 << 8 | 'c': candidate = kHeaderConnection; break;
+	case 10 << 8 | 'u': candidate = kHeaderUserAgent; break;
+	case 12 << 8 | 'c': candidate = kHeaderContentType; break;
+	case 13 << 8 | 'l': candidate = kHeaderLastModified; break;
+	case 14 << 8 | 'c': candidate = kHeaderContentLength; break;
+	case 17 << 8 | 't': candidate = kHeaderTransferEncoding; break;
+	default: return (kHeaderUnknown);
+	}
+	if (strncasecmp(kHeaderNames[candidate].c_str(), name, length) != 0)
+		return (kHeaderUnknown);
+	return (candidate);
+}
+
+HeaderId	header::Intern(const std::string &name)
+{
+	return (Intern(name.c_str(), name.size()));
+}
+
+const std::string	&header::Name(HeaderId id)
+{
+	return (kHeaderNames[id]);
+}
+
+bool	header::EqualNames(const std::string &name, const std::string &other)
+{
+	return (name.size() == other.size() && strcasecmp(name.c_str(), other.c_str()) == 0);
+}
+
+HTTPMessage::HTTPMessage()
+: arena_(),
+	unknown_(HeaderVector::allocator_type(&arena_))
 {
-	HeaderMapIt it;
+	for (int id = 0; id < kHeaderUnknown; id++)
+	{
+		known_[id] = NULL;
+		raw_[id].bytes = NULL;
+	}
+}
 
-	for (it = obj.headers_.begin(); it != obj.headers_.end(); ++it)
+HTTPMessage::HTTPMessage(const HTTPMessage &obj)
+: arena_(),
+	unknown_(HeaderVector::allocator_type(&arena_))
+{
+	for (int id = 0; id < kHeaderUnknown; id++)
 	{
-		addNewPair(it->first, it->second->clone());
+		known_[id] = NULL;
+		raw_[id].bytes = NULL;
 	}
+	copyHeaders(obj);
 }
 
 HTTPMessage::~HTTPMessage()
@@ -19,34 +102,85 @@ HTTPMessage::~HTTPMessage()
 
 HTTPMessage &HTTPMessage::operator=(const HTTPMessage &obj)
 {
+	if (this == &obj)
+		return (*this);
 	cleanHeaderMap();
+	copyHeaders(obj);
+	return (*this);
+}
 
-	HeaderMapIt it;
-
-	for (it = obj.headers_.begin(); it != obj.headers_.end(); ++it)
+// the values are cloned into the arena of this message, the raw values too
+void	HTTPMessage::copyHeaders(const HTTPMessage &obj)
+{
+	for (int id = 0; id < kHeaderUnknown; id++)
 	{
-		addNewPair(it->first, it->second->clone());
+		if (obj.known_[id])
+			known_[id] = obj.known_[id]->clone(arena_);
+		else if (obj.raw_[id].bytes)
+			addRawValue(static_cast<HeaderId>(id), obj.raw_[id].bytes, obj.raw_[id].length);
 	}
-	return (*this);
+	for (HeaderVectorIt it = obj.unknown_.begin(); it != obj.unknown_.end(); ++it)
+		unknown_.push_back(HeaderPair(it->first, it->second->clone(arena_)));
+}
+
+// the first value of a header is kept
+void	HTTPMessage::insertValue(HeaderId id, HeaderValue *value)
+{
+	if (known_[id])
+		value->~HeaderValue();
+	else
+		known_[id] = value;
+}
+
+void	HTTPMessage::insertValue(const std::string &key, HeaderValue *value)
+{
+	HeaderId	id = header::Intern(key);
+
+	if (id != kHeaderUnknown)
+		return (insertValue(id, value));
+	if (returnValueAsPointer(key))
+		value->~HeaderValue();
+	else
+		unknown_.push_back(HeaderPair(key, value));
 }
 
-void	HTTPMessage::addNewPair(std::string key, HeaderValue *value)
+// the value is copied into the arena, the first value of a header is kept
+void	HTTPMessage::addRawValue(HeaderId id, const char *bytes, size_t length)
 {
-	headers_.insert(std::make_pair(key, value));
+	if (known_[id] || raw_[id].bytes)
+		return ;
+	char	*copy = static_cast<char *>(arena_.allocate(length + 1));
+	std::memcpy(copy, bytes, length);
+	raw_[id].bytes = copy;
+	raw_[id].length = length;
 }
 
-void	HTTPMessage::addNewPair(HeaderPair pair)
+// the value is not copied, the first value of a header is kept
+void	HTTPMessage::referRawValue(HeaderId id, const char *bytes, size_t length)
 {
-	headers_.insert(pair);
+	if (known_[id] || raw_[id].bytes)
+		return ;
+	raw_[id].bytes = bytes;
+	raw_[id].length = length;
 }
 
-HeaderValue	*HTTPMessage::returnValueAsPointer(std::string key) const
+HeaderValue	*HTTPMessage::returnValueAsPointer(HeaderId id) const
 {
-	HeaderMapIt it;
+	// analysing a raw value only fills the cache of the value
+	if (known_[id] == NULL && raw_[id].bytes)
+		const_cast<HTTPMessage *>(this)->analyseRawValue(id);
+	return (known_[id]);
+}
 
-	for (it = headers_.begin(); it != headers_.end(); ++it)
+HeaderValue	*HTTPMessage::returnValueAsPointer(const std::string &key) const
+{
+	HeaderId	id = header::Intern(key);
+
+	if (id != kHeaderUnknown)
+		return (returnValueAsPointer(id));
+	for (HeaderVectorIt it = unknown_.begin(); it != unknown_.end(); ++it)
 	{
-		if (it->first == key)
+		if (header::EqualNames(it->first, key))
 			return (it->second);
 	}
 	return (NULL); // key not found
@@ -54,52 +188,79 @@ HeaderValue	*HTTPMessage::returnValueAsPointer(std::string key) const
 
 HeaderValue	*HTTPMessage::returnValueAsClonedPointer(std::string key) const
 {
-	HeaderMapIt it;
+	HeaderValue	*value = returnValueAsPointer(key);
 
-	for (it = headers_.begin(); it != headers_.end(); ++it)
-	{
-		if (it->first == key)
-			return (it->second->clone());
-	}
-	return (NULL); // key not found
+	if (value == NULL)
+		return (NULL); // key not found
+	return (value->clone());
 }
 
-std::string	HTTPMessage::returnMapAsString()
+std::string	HTTPMessage::returnMapAsString() const
 {
-	// for generation of headers in response
+	std::string	output;
 
-	HeaderMapIt it;
-	std::ostringstream oss;
+	appendHeaders(output);
+	return (output);
+}
 
-	for (it = headers_.begin(); it != headers_.end(); ++it)
+// for generation of headers in response, written after the status line
+void	HTTPMessage::appendHeaders(std::string &output) const
+{
+	for (int id = 0; id < kHeaderUnknown; id++)
 	{
-		oss << it->first << ": " << it->second->to_string() << "\r\n";
+		if (known_[id] == NULL)
+			continue ;
+		output += kHeaderNames[id];
+		output += ": ";
+		known_[id]->append_to(output);
+		output += "\r\n";
 	}
-	oss << "\r\n";
-
-	if (oss.fail())
-		return (std::string()); // stream error occurred
-
-	return (oss.str());
+	for (HeaderVectorIt it = unknown_.begin(); it != unknown_.end(); ++it)
+	{
+		output += it->first;
+		output += ": ";
+		it->second->append_to(output);
+		output += "\r\n";
+	}
+	output += "\r\n";
 }
 
 HeaderPair	HTTPMessage::returnClonedPair(std::string key) const
 {
-	HeaderMapIt it;
+	HeaderValue	*value = returnValueAsPointer(key);
 
-	for (it = headers_.begin(); it != headers_.end(); ++it)
-	{
-		if (it->first == key)
-			return (std::make_pair(key, it->second->clone()));
-	}
-	return (HeaderPair()); // key not found
+	if (value == NULL)
+		return (HeaderPair()); // key not found
+	return (std::make_pair(key, value->clone()));
 }
 
 void	HTTPMessage::cleanHeaderMap()
 {
-	HeaderMapIt it;
+	// the values live in the arena, only their destructors are run
+	for (int id = 0; id < kHeaderUnknown; id++)
+	{
+		if (known_[id])
+			known_[id]->~HeaderValue();
+		known_[id] = NULL;
+	}
+	for (HeaderVectorIt it = unknown_.begin(); it != unknown_.end(); ++it)
+		it->second->~HeaderValue();
+	// the memory of the vector is in the arena too
+	HeaderVector(HeaderVector::allocator_type(&arena_)).swap(unknown_);
+	for (int id = 0; id < kHeaderUnknown; id++)
+		raw_[id].bytes = NULL;
+	arena_.reset();
+}
 
-	for (it = headers_.begin(); it != headers_.end(); ++it)
-		delete (it->second);
-	headers_.clear();
+// only the fields without a grammar are kept raw, so the analysis cannot fail: the value of the
+// others is checked with the head, where an invalid one fails the request with 400
+void	HTTPMessage::analyseRawValue(HeaderId id)
+{
+	RawValue	raw = raw_[id];
+	raw_[id].bytes = NULL;
+	ArenaSnapshot	snapshot = temporary::arena.snapshot();
+	enum ParseError	error = AnalysisRequestField(id, raw.bytes, raw.length, this);
+	assert(error == kNone);
+	(void)error;
+	temporary::arena.rollback(snapshot);
 }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <map>
+#include <vector>
 #include <iterator>
 #include <sstream>
 #include "Protocol.hpp"
@@ -9,14 +9,30 @@
 #include "HeaderValue/HeaderInt.hpp"
 #include "HeaderValue/HeaderStringVector.hpp"
 #include "Uri/Uri.hpp"
+#include "Arena/RequestArena.hpp"
 
 typedef std::pair<std::string, HeaderValue *>	HeaderPair;
-typedef std::map<std::string, HeaderValue *>	HeaderMap;
-typedef HeaderMap::const_iterator HeaderMapIt;
+typedef std::vector<HeaderPair, RequestArenaAllocator<HeaderPair> >	HeaderVector;
+typedef HeaderVector::const_iterator HeaderVectorIt;
+
+namespace header
+{
+	// case insensitive, kHeaderUnknown for the fields without an id
+	HeaderId	Intern(const char *name, size_t length);
+	HeaderId	Intern(const std::string &name);
+	const std::string	&Name(HeaderId id);
+	bool	EqualNames(const std::string &name, const std::string &other);
+}
 
 /*
 	An abstract class having member variables and functions
-	shared by Request and Response classes */
+	shared by Request and Response classes.
+	Known header fields are stored in a table indexed by their id,
+	the others in a vector searched by name. The header values and
+	the vector are allocated from the arena of the message, which
+	is reset with the headers. A request can also keep the raw value
+	of a known field, analysed when it is first asked for, which may
+	refer to the head of the request instead of a copy of it */
 
 class HTTPMessage
 {
@@ -27,16 +43,48 @@ class HTTPMessage
 
 		HTTPMessage &operator=(const HTTPMessage &obj);
 
-		void	addNewPair(std::string key, HeaderValue *value);
-		void	addNewPair(HeaderPair pair);
+		template <class Value, class Content>
+		void	addNewPair(HeaderId id, const Content &content);
+		template <class Value, class Content>
+		void	addNewPair(const std::string &key, const Content &content);
 
-		HeaderValue	*returnValueAsPointer(std::string key) const; // memory managed by this class
+		void	addRawValue(HeaderId id, const char *bytes, size_t length);
+		void	referRawValue(HeaderId id, const char *bytes, size_t length); // the bytes must outlive the value
+		HeaderValue	*returnValueAsPointer(HeaderId id) const; // memory managed by this class
+		HeaderValue	*returnValueAsPointer(const std::string &key) const; // memory managed by this class
 		HeaderValue	*returnValueAsClonedPointer(std::string key) const; // should be freed elsewhere
 		HeaderPair	returnClonedPair(std::string key) const; // should be freed elsewhere
-		std::string	returnMapAsString();
+		std::string	returnMapAsString() const;
+		void	appendHeaders(std::string &output) const; // the header lines and the empty line
 		void	cleanHeaderMap();
 
-	public:
-		std::map<std::string, HeaderValue *>	headers_;
+	private:
+		RequestArena	arena_; // constructed before the vector that allocates from it
+		struct RawValue
+		{
+			const char	*bytes; // in the arena or the pinned head, NULL when there is none
+			size_t	length;
+		};
+
+		HeaderValue	*known_[kHeaderUnknown];
+		RawValue	raw_[kHeaderUnknown];
+		HeaderVector	unknown_;
+
+		void	copyHeaders(const HTTPMessage &obj);
+		void	insertValue(HeaderId id, HeaderValue *value);
+		void	insertValue(const std::string &key, HeaderValue *value);
+		void	analyseRawValue(HeaderId id);
 };
 
+// the value is constructed in the arena of the message from its content
+template <class Value, class Content>
+void	HTTPMessage::addNewPair(HeaderId id, const Content &content)
+{
+	insertValue(id, arena_.create<Value>(content));
+}
+
+template <class Value, class Content>
+void	HTTPMessage::addNewPair(const std::string &key, const Content &content)
+{
+	insertValue(key, arena_.create<Value>(content));
+}
@@ -2,6 +2,8 @@
 
 #include <string>
 
+class RequestArena;
+
 /*
 	An interface class which serves as a base class
 	for classes storing different data types */
@@ -20,6 +22,8 @@ class HeaderValue
 
 		virtual	const ValueType	&type() const = 0;
 		virtual HeaderValue	*clone() const = 0;
+		virtual HeaderValue	*clone(RequestArena &arena) const = 0; // destroyed but not freed by its owner
 		virtual std::string to_string() const = 0;
+		virtual void	append_to(std::string &output) const = 0; // same bytes as to_string
 };
 
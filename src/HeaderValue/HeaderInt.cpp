@@ -1,4 +1,5 @@
 #include "HeaderInt.hpp"
+#include "Arena/RequestArena.hpp"
 #include <cstdio>
 
 HeaderInt::HeaderInt()
@@ -34,26 +35,35 @@ HeaderInt	*HeaderInt::clone() const
 	return (new HeaderInt(*this));
 }
 
+HeaderInt	*HeaderInt::clone(RequestArena &arena) const
+{
+	return (arena.create<HeaderInt>(*this));
+}
+
 std::string HeaderInt::to_string() const
 {
-	char  buff[12];
-	// std::snprintf(buff, 12, "%d", content_);
-	int int_len = 0;
-	int tmp = content_;
-	if (tmp == 0)
-		int_len = 1;
-	while (tmp)
-	{
-		tmp = tmp / 10;
-		int_len++;
-	}
-	long new_n = static_cast<long>(content_);
-	buff[int_len] = '\0';
-	while (int_len)
+	std::string	result;
+
+	append_to(result);
+	return (result);
+}
+
+// the digits are written from the end of a buffer, without a stream
+void	HeaderInt::append_to(std::string &output) const
+{
+	char	buff[12];
+	char	*digit = buff + sizeof(buff);
+	long	n = content_;
+
+	if (n < 0)
+		n = -n;
+	do
 	{
-		buff[--int_len] = new_n % 10 + '0';
-		new_n = new_n / 10;
-	}
-	return std::string(buff);
+		*--digit = n % 10 + '0';
+		n /= 10;
+	} while (n);
+	if (content_ < 0)
+		*--digit = '-';
+	output.append(digit, buff + sizeof(buff) - digit);
 }
 
@@ -15,7 +15,9 @@ class HeaderInt : public HeaderValue
 		const ValueType	&type() const;
 		const int &content() const;
 		HeaderInt	*clone() const;
+		HeaderInt	*clone(RequestArena &arena) const;
     std::string to_string() const;
+    void  append_to(std::string &output) const;
 
 	private:
 		ValueType	type_;
@@ -1,4 +1,5 @@
 #include "HeaderString.hpp"
+#include "Arena/RequestArena.hpp"
 
 HeaderString::HeaderString()
 : type_(kString), content_() {}
@@ -33,8 +34,18 @@ HeaderString	*HeaderString::clone() const
 	return (new HeaderString(*this));
 }
 
+HeaderString	*HeaderString::clone(RequestArena &arena) const
+{
+	return (arena.create<HeaderString>(*this));
+}
+
 std::string HeaderString::to_string() const
 {
 	return content_;
 }
 
+void	HeaderString::append_to(std::string &output) const
+{
+	output += content_;
+}
+
@@ -16,7 +16,9 @@ class HeaderString : public HeaderValue
 
 		const std::string &content() const;
 		HeaderString	*clone() const;
+		HeaderString	*clone(RequestArena &arena) const;
     std::string to_string() const;
+    void  append_to(std::string &output) const;
 
 	private:
 		ValueType	type_;
@@ -1,4 +1,5 @@
 #include "HeaderStringVector.hpp"
+#include "Arena/RequestArena.hpp"
 #include <algorithm>
 #include <cassert>
 
@@ -39,16 +40,27 @@ HeaderStringVector	*HeaderStringVector::clone() const
 	return (new HeaderStringVector(*this));
 }
 
+HeaderStringVector	*HeaderStringVector::clone(RequestArena &arena) const
+{
+	return (arena.create<HeaderStringVector>(*this));
+}
+
 std::string HeaderStringVector::to_string() const
 {
   std::string result;
+
+  append_to(result);
+  return result;
+}
+
+void	HeaderStringVector::append_to(std::string &output) const
+{
 	for (std::vector<std::string>::const_iterator it = content_.begin(); it != content_.end(); ++it)
 	{
-		result += *it;
-		if (it + 1 != content_.end())
-			result += ", ";
+		if (it != content_.begin())
+			output += ", ";
+		output += *it;
 	}
-  return result;
 }
 
 void	HeaderStringVector::addString(const std::string &str)
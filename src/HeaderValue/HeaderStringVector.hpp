@@ -19,7 +19,9 @@ class HeaderStringVector : public HeaderValue
 		const ValueType	&type() const;
 		const StringVector &content() const;
 		HeaderStringVector	*clone() const;
+		HeaderStringVector	*clone(RequestArena &arena) const;
     std::string to_string() const;
+    void  append_to(std::string &output) const;
 
 		void	addString(const std::string &str);
 		void	addString(const char *str);
@@ -2,8 +2,12 @@
 
 #include <cstring>
 #include "Arena/Arena.hpp"
+#include "Http/Scanner.hpp"
 #include "Request.hpp"
 
+static enum ParseError  AnalysisMethod(enum Method method, RequestLine* output);
+static enum ParseError  AnalysisHttpVersion(http_parser::StringSlice version, RequestLine* output);
+
 StatusCode  ParseErrorToStatusCode(enum ParseError error)
 {
   StatusCode  status_code = k000;
@@ -75,44 +79,28 @@ enum ParseError AnalysisRequestLine(http_parser::PTNodeRequestLine* request_line
   enum ParseError error = kNone;
   assert((request_line) && (request_line->type == http_parser::kRequestLine) && "Parse result should be a request line");
 
-  switch (request_line->method->method)
-  {
-  case kGet:
-  case kPost:
-  case kDelete:
-  {
-    output->method = request_line->method->method;
-  } break;
-  case kUnmatched:
-  {
-    error = kUnsupportedMethod;
-  } break;
-  case kWrong:
-  {
-    error = kWrongMethod;
-  } break;
-  }
+  error = AnalysisMethod(request_line->method->method, output);
   switch(request_line->request_target_header->type)
   {
   case http_parser::kRequestTargetOriginForm:
   {
     http_parser::PTNodeRequestTargetOriginForm* origin_form = request_line->request_target_origin_form;
-    output->request_target.path = origin_form->absolute_path->content.to_string();
+    output->request_target.path = StringView(origin_form->absolute_path->content.bytes, origin_form->absolute_path->content.length);
     if (origin_form->query && origin_form->query->content.is_valid())
-      output->request_target.query = origin_form->query->content.to_string();
+      output->request_target.query = StringView(origin_form->query->content.bytes, origin_form->query->content.length);
   } break;
   case http_parser::kUriAbsolute:
   {
     http_parser::PTNodeUriAbsolute* uri_absolute = request_line->request_target_absolute_form;
     if (uri_absolute->scheme->content.bytes && (uri_absolute->scheme->content.match("http") == 4))
-      output->request_target.scheme = "http";
+      output->request_target.scheme = StringView("http", 4);
     else
     {
       error = kUnsupportedScheme;
       break;
     }
     if (uri_absolute->query && uri_absolute->query->content.bytes)
-      output->request_target.query = uri_absolute->query->content.to_string();
+      output->request_target.query = StringView(uri_absolute->query->content.bytes, uri_absolute->query->content.length);
     switch (uri_absolute->path_header->type)
     {
       case http_parser::kUriReferenceNetworkPath:
@@ -120,15 +108,15 @@ enum ParseError AnalysisRequestLine(http_parser::PTNodeRequestLine* request_line
         error = AnalysisUriAuthority(uri_absolute->network_path_reference->authority, &output->request_target.authority);
         if (error)
           break;
-        output->request_target.path = uri_absolute->network_path_reference->path->content.to_string();
+        output->request_target.path = StringView(uri_absolute->network_path_reference->path->content.bytes, uri_absolute->network_path_reference->path->content.length);
       } break;
       case http_parser::kUriAbsolute:
       {
-        output->request_target.path = uri_absolute->path_absolute->content.to_string();
+        output->request_target.path = StringView(uri_absolute->path_absolute->content.bytes, uri_absolute->path_absolute->content.length);
       } break;
       case http_parser::kPathRootless:
       {
-        output->request_target.path = uri_absolute->path_rootless->content.to_string();
+        output->request_target.path = StringView(uri_absolute->path_rootless->content.bytes, uri_absolute->path_rootless->content.length);
       } break;
       case http_parser::kPathEmpty:
       default:
@@ -145,136 +133,216 @@ enum ParseError AnalysisRequestLine(http_parser::PTNodeRequestLine* request_line
     error = kWrongRequestTarget;
   }
   }
+  if (AnalysisHttpVersion(request_line->version->content, output) != kNone)
+    error = kUnsupportedHttpVersion;
+  return error;
+}
+
+size_t  AnalysisOriginFormRequestLine(const char* bytes, size_t length, RequestLine* output, enum ParseError* error)
+{
+  using namespace http_parser;
+
+  size_t  method_length = SpanClass(bytes, length, kClassTokenText);
+  size_t  i = method_length + 1;
+  // "//" would start a network path, which is left to the full grammar
+  if (method_length == 0 || i + 1 >= length ||
+      bytes[method_length] != ' ' || bytes[i] != '/' || bytes[i + 1] == '/')
+    return 0;
+  const char* path = bytes + i;
+  size_t  path_length = SpanPercentEncoded(path, length - i, kAbsolutePathSet);
+  i += path_length;
+  const char* query = NULL;
+  size_t  query_length = 0;
+  if (i < length && bytes[i] == '?')
+  {
+    query = bytes + i + 1;
+    query_length = SpanPercentEncoded(query, length - i - 1, kQueryCharSet);
+    i += 1 + query_length;
+  }
+  if (length - i != 9 || bytes[i] != ' ' ||
+      std::memcmp(bytes + i + 1, "HTTP/", 5) != 0 ||
+      !IsDigit(bytes[i + 6]) || bytes[i + 7] != '.' || !IsDigit(bytes[i + 8]))
+    return 0;
+
+  *error = AnalysisMethod(MatchMethod(StringSlice(bytes, method_length)), output);
+  output->request_target.path = StringView(path, path_length);
+  if (query != NULL)
+    output->request_target.query = StringView(query, query_length);
+  if (AnalysisHttpVersion(StringSlice(bytes + i + 1, 8), output) != kNone)
+    *error = kUnsupportedHttpVersion;
+  return length;
+}
+
+static enum ParseError  AnalysisMethod(enum Method method, RequestLine* output)
+{
+  enum ParseError error = kNone;
+
+  switch (method)
   {
-    http_parser::PTNodeHttpVersion* version = request_line->version;
-    if(version->content.match("HTTP/0.9") == 8)
-      output->version = kCompatible;
-    else if(version->content.match("HTTP/1.0") == 8)
-      output->version = kCompatible;
-    else if(version->content.match("HTTP/1.1") == 8)
-      output->version = kStandard;
-    else if(version->content.match("HTTP/2.0") == 8)
-      output->version = kCompatible;
-    else
-      error = kUnsupportedHttpVersion;
+  case kGet:
+  case kPost:
+  case kDelete:
+  {
+    output->method = method;
+  } break;
+  case kUnmatched:
+  {
+    error = kUnsupportedMethod;
+  } break;
+  case kWrong:
+  {
+    error = kWrongMethod;
+  } break;
   }
   return error;
 }
 
-enum ParseError AnalysisRequestHeaders(http_parser::PTNodeFields* fields, HeaderMap* output)
+static enum ParseError  AnalysisHttpVersion(http_parser::StringSlice version, RequestLine* output)
+{
+  enum ParseError error = kNone;
+
+  if (version.match("HTTP/0.9") == 8)
+    output->version = kCompatible;
+  else if (version.match("HTTP/1.0") == 8)
+    output->version = kCompatible;
+  else if (version.match("HTTP/1.1") == 8)
+    output->version = kStandard;
+  else if (version.match("HTTP/2.0") == 8)
+    output->version = kCompatible;
+  else
+    error = kUnsupportedHttpVersion;
+  return error;
+}
+
+enum ParseError AnalysisRequestHeaders(http_parser::PTNodeFields* fields, HTTPMessage* output)
 {
   enum ParseError error = kNone;
 
-  (void) output;
-  for (temporary::vector<http_parser::PTNodeFieldLine*>::iterator it = fields->fields.begin(); it != fields->fields.end(); it++)
+  for (temporary::vector<http_parser::PTNodeFieldLine*>::iterator it = fields->fields.begin(); it != fields->fields.end() && error == kNone; it++)
   {
-    http_parser::PTNodeFieldLine* field_line = *it;
-    if (field_line->name->content.match("Content-Type") == 12)
+    http_parser::StringSlice  value = (*it)->value->content;
+    // field names are case insensitive
+    HeaderId  id = header::Intern((*it)->name->content.bytes, (*it)->name->content.length);
+    switch (id)
     {
-      http_parser::ParseOutput parsed_field = http_parser::ParseFieldContentType(field_line->value->content);
-      if (parsed_field.is_valid())
-      {
-        if (output->find("Content-Type") == output->end())
-        {
-          output->insert(std::make_pair("Content-Type", new HeaderString(static_cast<http_parser::PTNodeFieldContentType*>(parsed_field.result_ptnode)->content.to_string())));
-        }
-      }
+    // the fields that frame and route the request are analysed at once
+    case kHeaderHost:
+    {
+      if (output->returnValueAsPointer(kHeaderHost) != NULL)
+        error = kDuplicatedHost;
       else
-      {
-        error = kWrongHeader;
-        break;
-      }
+        error = AnalysisRequestField(id, value.bytes, value.length, output);
+    } break;
+    // and the fields that can be invalid, which fail the request with 400:
+    // their value is parsed to be checked anyway, so it is kept
+    case kHeaderContentLength:
+    case kHeaderTransferEncoding:
+    case kHeaderConnection:
+    case kHeaderContentType:
+    {
+      error = AnalysisRequestField(id, value.bytes, value.length, output);
+    } break;
+    case kHeaderUnknown:
+    {}
+    break;
+    // the fields without a grammar when they are first asked for, from the
+    // head they were received in
+    default:
+    {
+      output->referRawValue(id, value.bytes, value.length);
     }
-    else if (field_line->name->content.match("Content-Length") == 14)
+    }
+  }
+  if (output->returnValueAsPointer(kHeaderHost) == NULL)
+  {
+    error = kNoHost;
+  }
+  return error;
+}
+
+enum ParseError AnalysisRequestField(HeaderId id, const char* bytes, size_t length, HTTPMessage* output)
+{
+  enum ParseError error = kNone;
+  http_parser::StringSlice  value(bytes, length);
+  http_parser::ParseOutput  parsed_field;
+
+  switch (id)
+  {
+  case kHeaderContentType:
+  {
+    parsed_field = http_parser::ParseFieldContentType(value);
+    if (!parsed_field.is_valid())
+      error = kWrongHeader;
+    else
     {
-      http_parser::ParseOutput parsed_field = http_parser::ParseFieldContentLength(field_line->value->content);
-      if (parsed_field.is_valid())
-      {
-        if (output->find("Content-Length") == output->end())
-        {
-          output->insert(std::make_pair("Content-Length", new HeaderInt(static_cast<http_parser::PTNodeFieldContentLength*>(parsed_field.result_ptnode)->number)));
-        }
-      }
-      else
-      {
-        error = kWrongHeader;
-        break;
-      }
+      output->addNewPair<HeaderString>(kHeaderContentType, static_cast<http_parser::PTNodeFieldContentType*>(parsed_field.result_ptnode)->content.to_string());
     }
-    else if (field_line->name->content.match("Connection") == 10)
+  } break;
+  case kHeaderContentLength:
+  {
+    parsed_field = http_parser::ParseFieldContentLength(value);
+    if (!parsed_field.is_valid())
+      error = kWrongHeader;
+    else
     {
-      http_parser::ParseOutput parsed_field = http_parser::ParseFieldConnection(field_line->value->content);
-      if (parsed_field.is_valid())
-      {
-        if (output->find("Connection") == output->end())
-        {
-          http_parser::PTNodeFieldConnection* connection = static_cast<http_parser::PTNodeFieldConnection*>(parsed_field.result_ptnode);
-          for (temporary::vector<http_parser::PTNodeToken*>::iterator it = connection->options.begin(); it != connection->options.end(); it++)
-          {
-            if ((*it)->content.match("close") == 5)
-            {
-              output->insert(std::make_pair("Connection", new HeaderString((*it)->content.to_string())));
-              break;
-            }
-          }
-        }
-      }
-      else
-      {
-        error = kWrongHeader;
-        break;
-      }
+      output->addNewPair<HeaderInt>(kHeaderContentLength, static_cast<http_parser::PTNodeFieldContentLength*>(parsed_field.result_ptnode)->number);
     }
-    else if (field_line->name->content.match("Host") == 4)
+  } break;
+  case kHeaderConnection:
+  {
+    parsed_field = http_parser::ParseFieldConnection(value);
+    // the parser stops at the first option that is not a token
+    if (!parsed_field.is_valid() || parsed_field.length != value.length)
+      error = kWrongHeader;
+    else
     {
-      http_parser::ParseOutput parsed_field = http_parser::ParseFieldHost(field_line->value->content);
-      if (parsed_field.is_valid())
+      http_parser::PTNodeFieldConnection* connection = static_cast<http_parser::PTNodeFieldConnection*>(parsed_field.result_ptnode);
+      for (temporary::vector<http_parser::PTNodeToken*>::iterator it = connection->options.begin(); it != connection->options.end(); it++)
       {
-        if (output->find("Host") == output->end())
+        if ((*it)->content.match("close") == 5)
         {
-          output->insert(std::make_pair("Host", new HeaderString(static_cast<http_parser::PTNodeFieldHost*>(parsed_field.result_ptnode)->host->reg_name->content.to_string())));
-        }
-        else
-        {
-          error = kDuplicatedHost;
+          output->addNewPair<HeaderString>(kHeaderConnection, (*it)->content.to_string());
           break;
         }
       }
-      else
-      {
-        error = kWrongHeader;
-        break;
-      }
     }
-    else if (field_line->name->content.match("Transfer-Encoding") == 17)
+  } break;
+  case kHeaderHost:
+  {
+    parsed_field = http_parser::ParseFieldHost(value);
+    if (!parsed_field.is_valid())
+      error = kWrongHeader;
+    else
     {
-      http_parser::ParseOutput parsed_field = http_parser::ParseFieldTransferEncoding(field_line->value->content);
-      if (parsed_field.is_valid())
+      output->addNewPair<HeaderString>(kHeaderHost, static_cast<http_parser::PTNodeFieldHost*>(parsed_field.result_ptnode)->host->reg_name->content.to_string());
+    }
+  } break;
+  case kHeaderTransferEncoding:
+  {
+    parsed_field = http_parser::ParseFieldTransferEncoding(value);
+    if (!parsed_field.is_valid())
+      error = kWrongHeader;
+    else
+    {
+      http_parser::PTNodeFieldTransferEncoding* transfer_encoding = static_cast<http_parser::PTNodeFieldTransferEncoding*>(parsed_field.result_ptnode);
+      for (temporary::vector<http_parser::StringSlice>::iterator it = transfer_encoding->codings.begin(); it != transfer_encoding->codings.end(); it++)
       {
-        if (output->find("Transfer-Encoding") == output->end())
+        if (it->match("chunked") == 7)
         {
-          http_parser::PTNodeFieldTransferEncoding* transfer_encoding = static_cast<http_parser::PTNodeFieldTransferEncoding*>(parsed_field.result_ptnode);
-          for (temporary::vector<http_parser::StringSlice>::iterator it = transfer_encoding->codings.begin(); it != transfer_encoding->codings.end(); it++)
-          {
-            if (it->match("chunked") == 7)
-            {
-              output->insert(std::make_pair("Transfer-Encoding", new HeaderString(it->to_string())));
-              break;
-            }
-          }
+          output->addNewPair<HeaderString>(kHeaderTransferEncoding, it->to_string());
+          break;
         }
       }
-      else
-      {
-        error = kWrongHeader;
-        break;
-      }
     }
-    field_line++;
-  }
-  if (output->find("Host") == output->end())
+  } break;
+  case kHeaderUnknown:
+  {}
+  break;
+  // the fields without a grammar are kept as they are
+  default:
   {
-    error = kNoHost;
+    output->addNewPair<HeaderString>(id, value.to_string());
+  }
   }
   return error;
 }
@@ -287,8 +355,7 @@ namespace http_parser
 
   bool  IsAlpha(char character)
   {
-    return ((character >= 'a' && character <= 'z') ||
-        (character >= 'A' && character <= 'Z'));
+    return IsOfClass(character, kClassAlpha);
   }
 
   bool  IsBit(char character)
@@ -303,12 +370,12 @@ namespace http_parser
 
   bool  IsControls(char character)
   {
-    return ((character <= 31) || (character == 127));
+    return IsOfClass(character, kClassControl);
   }
 
   bool  IsDigit(char character)
   {
-    return (character >= '0' && character <= '9');
+    return IsOfClass(character, kClassDigit);
   }
 
   bool  IsDoubleQuote(char character)
@@ -318,7 +385,7 @@ namespace http_parser
 
   bool  IsHexDigit(char character)
   {
-    return (IsDigit(character) || (character >= 'A' && character <= 'F'));
+    return IsOfClass(character, kClassHexDigit);
   }
 
   bool  IsHorizontalTab(char character)
@@ -338,39 +405,27 @@ namespace http_parser
 
   bool  IsVisibleCharacter(char character)
   {
-    return (character >= 21 && character <= 126);
+    return IsOfClass(character, kClassVisible);
   }
 
   bool  IsWhitespace(char character)
   {
-    return (IsSpace(character) || IsHorizontalTab(character));
+    return IsOfClass(character, kClassWhitespace);
   }
 
   bool  IsTokenText(char character)
   {
-    return ((std::strchr("!#$%&\'*+-.^_`|~", character) != NULL) ||
-          IsDigit(character) ||
-          IsAlpha(character));
+    return IsOfClass(character, kClassTokenText);
   }
 
   bool  IsQuotedStringText(char character)
   {
-    return (IsHorizontalTab(character) ||
-            IsSpace(character) ||
-            (character == '!') ||
-            (character >= '#' && character <= '[') ||
-            (character >= ']' && character <= '~') ||
-            IsOpaqueText(character));
+    return IsOfClass(character, kClassQuotedText);
   }
 
   bool  IsCommentText(char character)
   {
-    return (IsHorizontalTab(character) ||
-            IsSpace(character) ||
-            (character >= '!' && character <= '\'') ||
-            (character >= '*' && character <= '[') ||
-            (character >= ']' && character <= '~') ||
-            IsOpaqueText(character));
+    return IsOfClass(character, kClassCommentText);
   }
 
   bool  IsOpaqueText(unsigned char character)
@@ -380,10 +435,7 @@ namespace http_parser
 
   bool  IsEscapedText(char character)
   {
-    return (IsHorizontalTab(character) ||
-            IsSpace(character) ||
-            IsVisibleCharacter(character) ||
-            IsOpaqueText(character));
+    return IsOfClass(character, kClassEscapedText);
   }
 
   //////////////////////////////////////////
@@ -402,6 +454,12 @@ namespace http_parser
     return string;
   }
 
+  // reuses the capacity of the output string
+  void  StringSlice::copy_to(std::string& output) const
+  {
+    output.assign(bytes, length);
+  }
+
   bool  StringSlice::is_valid() const
   {
     return (bytes != NULL);
@@ -592,12 +650,7 @@ namespace http_parser
     ParseOutput output;
     StringSlice content;
     content.bytes = input.bytes;
-    while (input.length > 0)
-    {
-      if (!ConsumeByUnitFunction(&input, &IsTokenText))
-        break;
-      content.length++;
-    }
+    content.length = SpanClass(input.bytes, input.length, kClassTokenText);
     if (content.length >= 1)
     {
       PTNodeToken*  token = PTNodeCreate<PTNodeToken>();
@@ -774,25 +827,22 @@ namespace http_parser
 
   bool  IsUnreservered(char character)
   {
-    return (IsAlpha(character) ||
-            IsDigit(character) ||
-            std::strchr("-._~", character));
+    return IsOfClass(character, kClassUnreserved);
   }
 
   bool  IsReservered(char character)
   {
-    return (IsGenDelims(character) ||
-            IsSubDelims(character));
+    return IsOfClass(character, kClassGenDelims | kClassSubDelims);
   }
 
   bool  IsGenDelims(char character)
   {
-    return (std::strchr(":/?#[]", character));
+    return IsOfClass(character, kClassGenDelims);
   }
 
   bool  IsSubDelims(char character)
   {
-    return (std::strchr("!$&'()*+,;=", character));
+    return IsOfClass(character, kClassSubDelims);
   }
 
   ScanOutput  ScanPathChar(Input input)
@@ -836,14 +886,7 @@ namespace http_parser
     ScanOutput  output;
 
     output.bytes = input.bytes;
-    int total_length = 0;
-    ScanOutput scan_result = ConsumeByScanFunction(&input, &ScanPathChar);
-    while (scan_result.is_valid())
-    {
-      total_length += scan_result.length;
-      scan_result = ConsumeByScanFunction(&input, &ScanPathChar);
-    }
-    output.length = total_length;
+    output.length = SpanPercentEncoded(input.bytes, input.length, kPathCharSet);
     return output;
   }
 
@@ -876,13 +919,7 @@ namespace http_parser
     ScanOutput  output;
 
     output.bytes = input.bytes;
-    int total_length = 0;
-    ScanOutput scan_result = ConsumeByScanFunction(&input, &ScanPathChar);
-    while (scan_result.is_valid())
-    {
-      total_length += scan_result.length;
-      scan_result = ConsumeByScanFunction(&input, &ScanPathChar);
-    }
+    int total_length = SpanPercentEncoded(input.bytes, input.length, kPathCharSet);
     if (total_length >= 1)
       output.length = total_length;
     else
@@ -1332,10 +1369,7 @@ namespace http_parser
     ParseOutput output;
     const char* input_start = input.bytes;
 
-    while (ConsumeByScanFunction(&input, &ScanPathChar).is_valid() ||
-           ConsumeByCharacter(&input, '/') ||
-           ConsumeByCharacter(&input, '?'))
-      ;
+    input.consume(SpanPercentEncoded(input.bytes, input.length, kQueryCharSet));
 
     PTNodeUriQuery* query = PTNodeCreate<PTNodeUriQuery>();
     query->type = kUriQuery;
@@ -1425,10 +1459,7 @@ namespace http_parser
     ParseOutput output;
     const char* input_start = input.bytes;
 
-    while (ConsumeByScanFunction(&input, &ScanPathChar).is_valid() ||
-           ConsumeByCharacter(&input, '/') ||
-           ConsumeByCharacter(&input, '?'))
-      ;
+    input.consume(SpanPercentEncoded(input.bytes, input.length, kQueryCharSet));
 
     PTNodeUriFragment* fragment = PTNodeCreate<PTNodeUriFragment>();
     fragment->type = kUriFragment;
@@ -1782,6 +1813,24 @@ namespace http_parser
     return output;
   }
 
+  enum Method  MatchMethod(StringSlice string)
+  {
+    enum Method method_name = kWrong;
+    if (string.match("GET") == 3)
+      method_name = kGet;
+    else if (string.match("POST") == 4)
+      method_name = kPost;
+    else if (string.match("DELETE") == 6)
+      method_name = kDelete;
+    else if ((string.match("HEAD") == 4) ||
+             (string.match("PUT") == 3) ||
+             (string.match("CONNECT") == 7) ||
+             (string.match("OPTIONS") == 7) ||
+             (string.match("TRACE") == 5))
+      method_name = kUnmatched;
+    return method_name;
+  }
+
   ParseOutput  ParseMethod(Input input)
   {
     ParseOutput output;
@@ -1791,20 +1840,7 @@ namespace http_parser
     ParseOutput parsed_token = ConsumeByParserFunction(&input, &ParseToken);
     if (parsed_token.is_valid())
     {
-      enum Method method_name = kWrong;
-      StringSlice string = ((PTNodeToken*) parsed_token.result_ptnode)->content;
-      if (string.match("GET") == 3)
-        method_name = kGet;
-      else if (string.match("POST") == 4)
-        method_name = kPost;
-      else if (string.match("DELETE") == 6)
-        method_name = kDelete;
-      else if ((string.match("HEAD") == 4) ||
-               (string.match("PUT") == 3) ||
-               (string.match("CONNECT") == 7) ||
-               (string.match("OPTIONS") == 7) ||
-               (string.match("TRACE") == 5))
-        method_name = kUnmatched;
+      enum Method method_name = MatchMethod(((PTNodeToken*) parsed_token.result_ptnode)->content);
       temporary::arena.rollback(snapshot);
       PTNodeMethod*  method = PTNodeCreate<PTNodeMethod>();
       method->type = kMethod;
@@ -2106,35 +2142,8 @@ namespace http_parser
     while (ConsumeByUnitFunction(&input, &IsWhitespace) == 1)
       ;
     const char* value_start = input.bytes;
-    while (input.length > 0)
-    {
-      if (IsVisibleCharacter(*input.bytes) ||
-          IsOpaqueText(*input.bytes))
-      {
-        input.consume();
-        Input input_tmp = input;
-        int amount = 0;
-        while (input_tmp.length > 0)
-        {
-          if (IsSpace(*input_tmp.bytes) ||
-              IsHorizontalTab(*input_tmp.bytes) ||
-              IsVisibleCharacter(*input_tmp.bytes) ||
-              IsOpaqueText(*input_tmp.bytes))
-          {
-             input_tmp.consume();
-             amount++;
-          }
-          else
-            break;
-        }
-        if ((amount > 0) && (input_tmp.length > 0) &&
-            (IsVisibleCharacter(*input_tmp.bytes) ||
-             IsOpaqueText(*input_tmp.bytes)))
-          input = input_tmp;
-      }
-      else
-        break;
-    }
+    // the space is visible, so the value runs until a tab or a control
+    input.consume(Span(input.bytes, input.length, kFieldValueSet));
     const char* value_end = input.bytes;
     // remove trailing white space
     if ((value_end - value_start) > 0)
@@ -2311,24 +2320,24 @@ namespace http_parser
       ParseOutput parsed_connection_option = ConsumeByParserFunction(&input, &ParseToken);
       if (parsed_connection_option.is_valid())
         options.push_back(static_cast<PTNodeToken*>(parsed_connection_option.result_ptnode));
-      else
+      // the other options of the list, after a comma
+      while (input.length > 0)
       {
-        while (input.length > 0)
+        Input input_tmp = input;
+        if (!ConsumeByScanFunction(&input_tmp, &ScanOptionalWhitespace).is_valid() ||
+            (ConsumeByCharacter(&input_tmp, ',') == 0) ||
+            !ConsumeByScanFunction(&input_tmp, &ScanOptionalWhitespace).is_valid())
+          break;
+        parsed_connection_option = ConsumeByParserFunction(&input_tmp, &ParseToken);
+        if (parsed_connection_option.is_valid())
         {
-          Input input_tmp = input;
-          if (!ConsumeByScanFunction(&input_tmp, &ScanOptionalWhitespace).is_valid() ||
-              (ConsumeByCharacter(&input_tmp, ',') == 0) ||
-              !ConsumeByScanFunction(&input_tmp, &ScanOptionalWhitespace).is_valid())
-            break;
-          parsed_connection_option = ConsumeByParserFunction(&input_tmp, &ParseToken);
-          if (parsed_connection_option.is_valid())
-          {
-            options.push_back(static_cast<PTNodeToken*>(parsed_connection_option.result_ptnode));
-            input = input_tmp;
-          }
-          else
-            break;
+          options.push_back(static_cast<PTNodeToken*>(parsed_connection_option.result_ptnode));
+          input = input_tmp;
         }
+        else if (input_tmp.length == 0 || *input_tmp.bytes == ',')
+          input = input_tmp; // an empty element of the list
+        else
+          break;
       }
     }
     PTNodeFieldConnection*  connection = PTNodeCreate<PTNodeFieldConnection>();
@@ -2532,8 +2541,7 @@ namespace http_parser
   {
     ParseOutput output;
     const char* input_start = input.bytes;
-    static int chunk_size = 0;
-    chunk_size = 0;
+    int chunk_size = 0;
 
     while (input.length > 0)
     {
@@ -2553,7 +2561,10 @@ namespace http_parser
     }
     ConsumeByScanFunction(&input, &ScanChunkExtension);
     output.length = input.bytes - input_start;
-    output.result = &chunk_size;
+    // the result lives in the arena of the calling thread
+    int* result = temporary::arena.allocate<int>();
+    *result = chunk_size;
+    output.result = result;
     return output;
   }
 
@@ -33,9 +33,18 @@ struct PTNodeFields;
 struct PTNodeUriAuthority;
 }
 
+// The target of the output and the raw header values refer to the parsed
+// bytes, which must outlive the output.
 enum ParseError AnalysisRequestLine(http_parser::PTNodeRequestLine* request_line, RequestLine* output);
-enum ParseError AnalysisRequestHeaders(http_parser::PTNodeFields* fields, HeaderMap* output);
+enum ParseError AnalysisRequestHeaders(http_parser::PTNodeFields* fields, HTTPMessage* output);
+// Analyses the value of a known field into output, kWrongHeader when it is invalid.
+// The fields without a grammar are analysed on first access, the others with the head.
+enum ParseError AnalysisRequestField(HeaderId id, const char* bytes, size_t length, HTTPMessage* output);
 enum ParseError AnalysisUriAuthority(http_parser::PTNodeUriAuthority* authority, struct uri::Authority* output);
+// Parses and analyses "METHOD /path[?query] HTTP/x.y" (without the CRLF) in a
+// single pass, without a parse tree. Returns the length of the request line, or
+// 0 when the line needs ParseRequestLine and AnalysisRequestLine.
+size_t  AnalysisOriginFormRequestLine(const char* bytes, size_t length, RequestLine* output, enum ParseError* error);
 
 namespace http_parser
 {
@@ -75,6 +84,7 @@ namespace http_parser
     StringSlice();
     StringSlice(const char* bytes, unsigned int length);
     std::string to_string() const;
+    void  copy_to(std::string& output) const;
     bool  is_valid() const;
     const char* consume(unsigned int amount = 1);
     int   match(const char* string);
@@ -462,6 +472,7 @@ namespace http_parser
   };
 
   ParseOutput  ParseHttpVersion(Input input);
+  enum Method  MatchMethod(StringSlice string);
   ParseOutput  ParseMethod(Input input);
   ParseOutput  ParseRequestTargetOriginForm(Input input);
   ParseOutput  ParseRequestTargetAuthorityForm(Input input);
@@ -0,0 +1,260 @@
+#include "Scanner.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define SCANNER_X86 1
+#endif
+
+namespace http_parser
+{
+  // Generated from the predicates of RFC 9110 and RFC 3986, with two
+  // deviations kept from the original predicates: visible characters start at
+  // 21 (decimal) instead of 0x21, and every byte from 128 is also a control.
+  // NUL is a member of no class.
+  const unsigned int kCharacterClasses[256] = {
+    0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x00790, 0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x00080, // 0x00 - 0x0f
+    0x00080, 0x00080, 0x00080, 0x00080, 0x00080, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, 0x044a0, // 0x10 - 0x1f
+    0x04730, 0x3d728, 0x04620, 0x06728, 0x3d728, 0x3c728, 0x3d728, 0x3d728, 0x3d520, 0x3d520, 0x3d728, 0x3d728, 0x3d720, 0x3cf28, 0x3cf28, 0x36720, // 0x20 - 0x2f
+    0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3cf2e, 0x3e720, 0x3d720, 0x04720, 0x3d720, 0x04720, 0x16720, // 0x30 - 0x3f
+    0x3c720, 0x3cf2d, 0x3cf2d, 0x3cf2d, 0x3cf2d, 0x3cf2d, 0x3cf2d, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, // 0x40 - 0x4f
+    0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x06720, 0x04420, 0x06720, 0x04728, 0x3cf28, // 0x50 - 0x5f
+    0x04728, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, // 0x60 - 0x6f
+    0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x3cf29, 0x04720, 0x04728, 0x04720, 0x3cf28, 0x00080, // 0x70 - 0x7f
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0x80 - 0x8f
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0x90 - 0x9f
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0xa0 - 0xaf
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0xb0 - 0xbf
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0xc0 - 0xcf
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0xd0 - 0xdf
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0xe0 - 0xef
+    0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, 0x047c0, // 0xf0 - 0xff
+  };
+
+  const CharacterSet kFieldValueSet = {kClassFieldValue, 21, 126, true, ""};
+  const CharacterSet kPathCharSet = {kClassPathChar, 0x21, 0x7E, false, "\"#/<>?[\\]^`{|}"};
+  const CharacterSet kQueryCharSet = {kClassQueryChar, 0x21, 0x7E, false, "\"#<>[\\]^`{|}"};
+  const CharacterSet kAbsolutePathSet = {kClassAbsolutePath, 0x21, 0x7E, false, "\"#<>?[\\]^`{|}"};
+
+  namespace
+  {
+    size_t  SpanScalar(const char* bytes, size_t length, const CharacterSet& set)
+    {
+      return SpanClass(bytes, length, set.character_class);
+    }
+
+#ifdef SCANNER_X86
+    // compares 16 bytes against the range and the excluded bytes
+    __attribute__((target("sse2")))
+    size_t  SpanSse2(const char* bytes, size_t length, const CharacterSet& set)
+    {
+      const __m128i first = _mm_set1_epi8(set.first);
+      const __m128i last = _mm_set1_epi8(set.last);
+      const __m128i opaque = set.opaque ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+      __m128i excluded[16];
+      size_t  excluded_count = std::strlen(set.excluded);
+      for (size_t i = 0; i < excluded_count; i++)
+        excluded[i] = _mm_set1_epi8(set.excluded[i]);
+
+      size_t  i = 0;
+      while (i < length && length >= 16)
+      {
+        // the last chunk overlaps bytes that are already known members
+        size_t  offset = (i + 16 <= length) ? i : length - 16;
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + offset));
+        __m128i member = _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, first), chunk),
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, last), chunk));
+        for (size_t j = 0; j < excluded_count; j++)
+          member = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, excluded[j]), member);
+        member = _mm_or_si128(member, _mm_and_si128(opaque,
+            _mm_cmplt_epi8(chunk, _mm_setzero_si128())));
+        unsigned int outside = ~_mm_movemask_epi8(member) & 0xFFFF;
+        if (outside)
+          return offset + __builtin_ctz(outside);
+        i = offset + 16;
+      }
+      return i + SpanScalar(bytes + i, length - i, set);
+    }
+
+    // One bit per ascii byte: the low nibble selects a row of the bitmap
+    // and the high nibble a bit of the row, so that a pshufb per nibble
+    // tests 32 bytes at once whatever the shape of the set.
+    struct AsciiBitmap
+    {
+      unsigned char rows[16];
+    };
+
+    AsciiBitmap MakeBitmap(const CharacterSet& set)
+    {
+      AsciiBitmap bitmap;
+      std::memset(bitmap.rows, 0, sizeof(bitmap.rows));
+      for (int character = 1; character < 128; character++)
+      {
+        if (kCharacterClasses[character] & set.character_class)
+          bitmap.rows[character & 0x0F] |= 1 << (character >> 4);
+      }
+      return bitmap;
+    }
+
+    const AsciiBitmap kFieldValueBitmap = MakeBitmap(kFieldValueSet);
+    const AsciiBitmap kPathCharBitmap = MakeBitmap(kPathCharSet);
+    const AsciiBitmap kQueryCharBitmap = MakeBitmap(kQueryCharSet);
+    const AsciiBitmap kAbsolutePathBitmap = MakeBitmap(kAbsolutePathSet);
+
+    __attribute__((target("avx2")))
+    size_t  SpanAvx2(const char* bytes, size_t length, const CharacterSet& set)
+    {
+      const AsciiBitmap*  bitmap;
+      if (&set == &kFieldValueSet)
+        bitmap = &kFieldValueBitmap;
+      else if (&set == &kPathCharSet)
+        bitmap = &kPathCharBitmap;
+      else if (&set == &kQueryCharSet)
+        bitmap = &kQueryCharBitmap;
+      else if (&set == &kAbsolutePathSet)
+        bitmap = &kAbsolutePathBitmap;
+      else
+        return SpanSse2(bytes, length, set);
+
+      const __m256i rows = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(bitmap->rows)));
+      // bytes from 128 select no bit and are tested apart
+      const __m256i bits = _mm256_setr_epi8(
+          1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+          1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+      const __m256i nibble = _mm256_set1_epi8(0x0F);
+      const __m256i opaque = set.opaque ? _mm256_set1_epi8(-1) : _mm256_setzero_si256();
+
+      size_t  i = 0;
+      while (i < length && length >= 32)
+      {
+        size_t  offset = (i + 32 <= length) ? i : length - 32;
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + offset));
+        __m256i row = _mm256_shuffle_epi8(rows, _mm256_and_si256(chunk, nibble));
+        __m256i bit = _mm256_shuffle_epi8(bits,
+            _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+        __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+        outside = _mm256_andnot_si256(_mm256_and_si256(opaque,
+            _mm256_cmpgt_epi8(_mm256_setzero_si256(), chunk)), outside);
+        unsigned int mask = _mm256_movemask_epi8(outside);
+        if (mask)
+          return offset + __builtin_ctz(mask);
+        i = offset + 32;
+      }
+      if (i == 0 && length >= 16)
+        return SpanSse2(bytes, length, set);
+      return i + SpanScalar(bytes + i, length - i, set);
+    }
+#endif
+
+    typedef size_t (*SpanKernel)(const char*, size_t, const CharacterSet&);
+
+    SpanKernel  span_kernel = &SpanScalar;
+    const char* kernel_name = "scalar";
+
+    // selects the widest kernel before main
+    struct KernelSelection
+    {
+      KernelSelection() { UseKernel(kKernelBest); }
+    } kernel_selection;
+  }
+
+  bool  UseKernel(enum ScanKernel kernel)
+  {
+#ifdef SCANNER_X86
+    __builtin_cpu_init();
+    if (kernel == kKernelBest)
+    {
+      if (__builtin_cpu_supports("avx2"))
+        kernel = kKernelAvx2;
+      else if (__builtin_cpu_supports("sse2"))
+        kernel = kKernelSse2;
+      else
+        kernel = kKernelScalar;
+    }
+    if (kernel == kKernelAvx2 && __builtin_cpu_supports("avx2"))
+    {
+      span_kernel = &SpanAvx2;
+      kernel_name = "avx2";
+      return true;
+    }
+    if (kernel == kKernelSse2 && __builtin_cpu_supports("sse2"))
+    {
+      span_kernel = &SpanSse2;
+      kernel_name = "sse2";
+      return true;
+    }
+#endif
+    if (kernel == kKernelScalar || kernel == kKernelBest)
+    {
+      span_kernel = &SpanScalar;
+      kernel_name = "scalar";
+      return true;
+    }
+    return false;
+  }
+
+  const char* KernelName()
+  {
+    return kernel_name;
+  }
+
+  size_t  Span(const char* bytes, size_t length, const CharacterSet& set)
+  {
+    return span_kernel(bytes, length, set);
+  }
+
+  size_t  SpanPercentEncoded(const char* bytes, size_t length, const CharacterSet& set)
+  {
+    size_t  span = Span(bytes, length, set);
+    const char* percent = static_cast<const char*>(std::memchr(bytes, '%', span));
+    while (percent != NULL)
+    {
+      size_t  offset = percent - bytes;
+      // the hex digits are members of the set, so they are inside the span
+      if (offset + 2 >= span ||
+          !IsOfClass(percent[1], kClassHexDigit) ||
+          !IsOfClass(percent[2], kClassHexDigit))
+        return offset;
+      percent = static_cast<const char*>(std::memchr(percent + 3, '%', span - offset - 3));
+    }
+    return span;
+  }
+
+  size_t  SpanClass(const char* bytes, size_t length, unsigned int character_class)
+  {
+    size_t  i = 0;
+    while (i < length && IsOfClass(bytes[i], character_class))
+      i++;
+    return i;
+  }
+
+  // memchr already compares a vector of bytes at a time
+  size_t  FindNewLine(const char* bytes, size_t length)
+  {
+    const char* end = bytes + length;
+    const char* found = static_cast<const char*>(std::memchr(bytes, '\r', length));
+    while (found != NULL && found + 1 < end)
+    {
+      if (found[1] == '\n')
+        return found - bytes;
+      found = static_cast<const char*>(std::memchr(found + 1, '\r', end - found - 1));
+    }
+    return length;
+  }
+
+  size_t  FindEmptyLine(const char* bytes, size_t length)
+  {
+    const char* end = bytes + length;
+    const char* found = static_cast<const char*>(std::memchr(bytes, '\r', length));
+    while (found != NULL && found + 3 < end)
+    {
+      if (found[1] == '\n' && found[2] == '\r' && found[3] == '\n')
+        return found - bytes;
+      found = static_cast<const char*>(std::memchr(found + 1, '\r', end - found - 1));
+    }
+    return length;
+  }
+}
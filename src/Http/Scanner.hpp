@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+
+namespace http_parser
+{
+  ///////////////////////////////////////////////////////////////
+  ////////////////   character classification    ////////////////
+  ///////////////////////////////////////////////////////////////
+
+  enum CharacterClass
+  {
+    kClassAlpha = 1 << 0,
+    kClassDigit = 1 << 1,
+    kClassHexDigit = 1 << 2,
+    kClassTokenText = 1 << 3,
+    kClassWhitespace = 1 << 4,
+    kClassVisible = 1 << 5,
+    kClassOpaque = 1 << 6,
+    kClassControl = 1 << 7,
+    kClassQuotedText = 1 << 8,
+    kClassCommentText = 1 << 9,
+    kClassEscapedText = 1 << 10,
+    kClassUnreserved = 1 << 11,
+    kClassSubDelims = 1 << 12,
+    kClassGenDelims = 1 << 13,
+    kClassFieldValue = 1 << 14, // visible or opaque
+    kClassPathChar = 1 << 15,   // pchar, with the '%' of a pct-encoded triplet
+    kClassQueryChar = 1 << 16,  // pchar, '/' and '?'
+    kClassAbsolutePath = 1 << 17 // pchar and '/'
+  };
+
+  // the classes of every byte, indexed by the byte as an unsigned char
+  extern const unsigned int kCharacterClasses[256];
+
+  inline bool IsOfClass(char character, unsigned int character_class)
+  {
+    return (kCharacterClasses[static_cast<unsigned char>(character)] & character_class);
+  }
+
+  ////////////////////////////////////////////////
+  ////////////////   span kernels  ////////////////
+  ////////////////////////////////////////////////
+
+  // A set of bytes that the vector kernels can test without the table: the
+  // ascii members are the range [first, last] minus the excluded bytes.
+  struct CharacterSet
+  {
+    unsigned int  character_class;
+    unsigned char first;
+    unsigned char last;
+    bool          opaque; // the bytes from 128 are members
+    const char*   excluded;
+  };
+
+  extern const CharacterSet kFieldValueSet;
+  extern const CharacterSet kPathCharSet;
+  extern const CharacterSet kQueryCharSet;
+  extern const CharacterSet kAbsolutePathSet;
+
+  enum ScanKernel
+  {
+    kKernelScalar,
+    kKernelSse2,
+    kKernelAvx2,
+    kKernelBest // the widest kernel the cpu supports
+  };
+
+  // returns false when the cpu or the build does not support the kernel
+  bool        UseKernel(enum ScanKernel kernel);
+  const char* KernelName();
+
+  // length of the leading run of bytes that are members of the set
+  size_t  Span(const char* bytes, size_t length, const CharacterSet& set);
+  // same as Span, but cut before the first '%' that does not start a
+  // pct-encoded triplet
+  size_t  SpanPercentEncoded(const char* bytes, size_t length, const CharacterSet& set);
+  // length of the leading run of bytes of the class, for short runs
+  size_t  SpanClass(const char* bytes, size_t length, unsigned int character_class);
+
+  // offset of the first "\r\n" or "\r\n\r\n", or length when there is none
+  size_t  FindNewLine(const char* bytes, size_t length);
+  size_t  FindEmptyLine(const char* bytes, size_t length);
+}
@@ -9,13 +9,13 @@ void	process::ProcessRequest(struct Client *clt)
 {
 	assert(clt && clt->client_socket && "client_socket is null");
 
-	if (clt->status_code != k000)
-		return (res_builder::GenerateErrorResponse(clt)); // there is an existing error
-
-	HeaderString	*connection = static_cast<HeaderString *> (clt->req.returnValueAsPointer("Connection"));
+	HeaderString	*connection = static_cast<HeaderString *> (clt->req.returnValueAsPointer(kHeaderConnection));
 	if (connection && connection->content() == "close")
 		clt->keepAlive = false;
 
+	if (clt->status_code != k000)
+		return (res_builder::GenerateErrorResponse(clt)); // there is an existing error
+
 	//check redirect
 	if (clt->config.query->redirect)
 		return (res_builder::GenerateRedirectResponse(clt));
@@ -47,7 +47,7 @@ void	process::ProcessGetRequest(struct Client *clt)
 			return (cgi::ProcessGetRequestCgi(clt));
 		// std::string content_type = process::GetReqExtension(clt->path);
 
-		if (access(clt->path.c_str(), R_OK) != 0)
+		if (file::AccessBeneath(location, clt->path, R_OK) != 0)
 		{
 			clt->status_code = k403;
 			return (res_builder::GenerateErrorResponse(clt));
@@ -59,7 +59,7 @@ void	process::ProcessGetRequest(struct Client *clt)
 	{
 		if (location->autoindex == true)
 		{
-			if (access(clt->path.c_str(), R_OK) != 0)
+			if (file::AccessBeneath(location, clt->path, R_OK) != 0)
 			{
 				clt->status_code = k403;
 				return (res_builder::GenerateErrorResponse(clt));
@@ -81,12 +81,12 @@ void	process::ProcessGetRequest(struct Client *clt)
 				clt->path = index_path;
 				if (process::IsCgi(clt->cgi_argv, clt->path, location))
 					return (cgi::ProcessGetRequestCgi(clt));
-				if (access(index_path.c_str(), F_OK) != 0)
+				if (file::AccessBeneath(location, index_path, F_OK) != 0)
 				{
 					clt->status_code = k404;
 					return (res_builder::GenerateErrorResponse(clt));
 				}
-				if (access(index_path.c_str(), R_OK) != 0)
+				if (file::AccessBeneath(location, index_path, R_OK) != 0)
 				{
 					clt->status_code = k403;
 					return (res_builder::GenerateErrorResponse(clt));
@@ -108,7 +108,7 @@ void	process::ProcessPostRequest(struct Client *clt)
 	cache::LocationQuery	*location= clt->config.query;
 
 	std::string req_content_type = "";
-	HeaderString	*content_type = static_cast<HeaderString *>(clt->req.returnValueAsPointer("Content-Type"));
+	HeaderString	*content_type = static_cast<HeaderString *>(clt->req.returnValueAsPointer(kHeaderContentType));
 	if (!content_type)
 		req_content_type = "application/octet-stream";
 	else
@@ -120,7 +120,7 @@ void	process::ProcessPostRequest(struct Client *clt)
 	}
 
 	//path is in the clt->path
-	if (stat(clt->path.c_str(), &clt->stat_buff) == 0)  //file exists
+	if (file::StatBeneath(location, clt->path, &clt->stat_buff) == 0)  //file exists
 	{
 		if (S_ISDIR(clt->stat_buff.st_mode))
 		{
@@ -141,7 +141,7 @@ void	process::ProcessPostRequest(struct Client *clt)
 		{
 			if (IsCgi(clt->cgi_argv, clt->path, location))
 				return (cgi::ProcessPostRequestCgi(clt));
-			if(access(clt->path.c_str(), W_OK) != 0)
+			if(file::AccessBeneath(location, clt->path, W_OK) != 0)
 			{
 				clt->status_code = k403;
 				return (res_builder::GenerateErrorResponse(clt));
@@ -204,13 +204,13 @@ void	process::ProcessDeleteRequest(struct Client *clt)
 	}
 	if (S_ISREG(clt->stat_buff.st_mode))
 	{
-		if (access(clt->path.c_str(), W_OK) != 0)
+		if (file::AccessBeneath(location, clt->path, W_OK) != 0)
 		{
 			clt->status_code = k403;
 			return (res_builder::GenerateErrorResponse(clt));
 		}
 		size_t pos = clt->path.find_last_of('/');
-		if(access(clt->path.substr(0, pos).c_str(), W_OK) !=0)
+		if(file::AccessBeneath(location, clt->path.substr(0, pos), W_OK) != 0)
 		{
 			clt->status_code = k403;
 			return (res_builder::GenerateErrorResponse(clt));
@@ -230,14 +230,40 @@ void	process::ProcessDeleteRequest(struct Client *clt)
 	}
 }
 
-std::string process::GetExactPath(const std::string root, std::string match_path, const struct Uri uri)
+// Requests that write, remove or list files. Building their response can wait for a slow
+// disk, so it is done in a pool thread when aio_threads is set.
+bool	process::IsDiskRequest(struct Client *clt)
+{
+	if (clt->status_code != k000 || clt->config.query == NULL || clt->config.query->redirect)
+		return (false);
+	switch (clt->req.getMethod())
+	{
+		case kPost:
+		case kDelete:
+			return (true);
+		case kGet:
+			return (S_ISDIR(clt->stat_buff.st_mode));
+		default:
+			return (false);
+	}
+}
+
+// Directory listings: the HTML of a large directory takes long to build.
+bool	process::IsCpuRequest(struct Client *clt)
+{
+	if (clt->status_code != k000 || clt->config.query == NULL || clt->config.query->redirect)
+		return (false);
+	return (clt->req.getMethod() == kGet && S_ISDIR(clt->stat_buff.st_mode) && clt->config.query->autoindex);
+}
+
+// the path is normalized, it cannot go above the root
+std::string process::GetExactPath(const std::string &root, const std::string &match_path, const std::string &path)
 {
 	(void) match_path;
-	// std::string exact_path = "." + root;
-	// if (uri.path[0] != '/')
-	// 	exact_path += "/";
-	std::string exact_path = root;
-	exact_path += uri.path;
+	std::string exact_path;
+	exact_path.reserve(root.size() + path.size());
+	exact_path = root;
+	exact_path += path;
 	return (exact_path);
 }
 
@@ -264,11 +290,11 @@ bool		process::IsCgi(std::vector<std::string> &cgi_argv, std::string path, cache
 std::string	process::GetReqExtension(std::string path)
 {
 	assert((path != "") && "clt->path is empty");
-	std::string extension = path.substr(path.find_last_of('.') + 1);
-	if (extension == path)
+	// only the dots of the file name, not the ones of the directories
+	size_t	dot = path.find_last_of("./");
+	if (dot == std::string::npos || path[dot] != '.')
 		return ("");
-	else
-		return (extension);
+	return (path.substr(dot + 1));
 }
 
 // bool	process::IsAcceptable(std::string content_type, HeaderValue *accept, cache::LocationQuery *location)
@@ -293,7 +319,7 @@ std::string	process::GetIndexPath(std::string path, cache::LocationQuery *locati
 			path += "/";
 		index_path = path + location->indexes[i]->get();
 		std::cerr << "index_path: " << index_path << std::endl;
-		if (access(index_path.c_str(), F_OK) == 0)
+		if (file::AccessBeneath(location, index_path, F_OK) == 0)
 			return (index_path);
 	}
 	return ("");
@@ -301,14 +327,7 @@ std::string	process::GetIndexPath(std::string path, cache::LocationQuery *locati
 
 bool		process::IsSupportedMediaType(std::string req_content_type, const directive::MimeTypes* mime_types)
 {
-	const std::map<directive::MimeTypes::Extension, directive::MimeTypes::MimeType>	types = mime_types->get();
-	std::map<directive::MimeTypes::Extension, directive::MimeTypes::MimeType>::const_iterator it;
-	for (it = types.begin(); it != types.end(); it++)
-	{
-		if (it->second == req_content_type)
-			return (true);
-	}
-	return (false);
+	return (mime_types->find_extension(req_content_type) != NULL);
 }
 
 bool		process::IsDirFormat(std::string path)
@@ -23,6 +23,26 @@ enum Version
 	kBad // 400 Bad Request
 };
 
+// Header fields known by the server, in the order they are written in a response.
+// Other fields are stored under their name.
+enum HeaderId
+{
+	kHeaderAccept,
+	kHeaderAllow,
+	kHeaderConnection,
+	kHeaderContentLength,
+	kHeaderContentType,
+	kHeaderDate,
+	kHeaderHost,
+	kHeaderLastModified,
+	kHeaderLocation,
+	kHeaderReferer,
+	kHeaderServer,
+	kHeaderTransferEncoding,
+	kHeaderUserAgent,
+	kHeaderUnknown // also the number of known fields
+};
+
 enum StatusCode
 {
 	k000 = 0, // default value
@@ -1,5 +1,23 @@
 #include "Request.hpp"
 
+#include <algorithm>
+
+// a view into the pinned bytes of another request, at the same place in this one
+static StringView	Rebase(const StringView &view, const std::string &from, const std::string &to)
+{
+	if (view.bytes == NULL || view.bytes < from.data() || view.bytes > from.data() + from.size())
+		return (view);
+	return (StringView(to.data() + (view.bytes - from.data()), view.length));
+}
+
+static void	RebaseTarget(struct Uri &target, const std::string &from, const std::string &to)
+{
+	target.scheme = Rebase(target.scheme, from, to);
+	target.path = Rebase(target.path, from, to);
+	target.query = Rebase(target.query, from, to);
+	target.fragment = Rebase(target.fragment, from, to);
+}
+
 RequestLine::RequestLine()
 : method(kGet),
 	request_target(),
@@ -10,23 +28,38 @@ Request::Request()
 	method_(kGet),
 	request_target_(),
 	version_(kStandard),
-	requestBody_() {}
+	requestBody_(),
+	pinned_(),
+	pinned_body_() {}
 
+// The copy has its own pinned bytes, the raw header values are copied into
+// its arena, so it can outlive the buffer of the request it was copied from.
 Request::Request(const Request &obj)
 :	HTTPMessage(obj),
 	method_(obj.method_),
 	request_target_(obj.request_target_),
 	version_(obj.version_),
-	requestBody_(obj.requestBody_) {}
+	requestBody_(obj.requestBody_),
+	pinned_(obj.pinned_),
+	pinned_body_(Rebase(obj.pinned_body_, obj.pinned_, pinned_))
+{
+	RebaseTarget(request_target_, obj.pinned_, pinned_);
+}
 
 Request::~Request() {}
 
 Request &Request::operator=(const Request &obj)
 {
+	if (this == &obj)
+		return (*this);
+	HTTPMessage::operator=(obj);
 	method_ = obj.method_;
 	request_target_ = obj.request_target_;
 	version_ = obj.version_;
 	requestBody_ = obj.requestBody_;
+	pinned_ = obj.pinned_;
+	pinned_body_ = Rebase(obj.pinned_body_, obj.pinned_, pinned_);
+	RebaseTarget(request_target_, obj.pinned_, pinned_);
 	return (*this);
 }
 
@@ -45,9 +78,21 @@ const Version	&Request::getVersion() const
 	return (version_);
 }
 
-const std::string	&Request::getRequestBody() const
+StringView	Request::getRequestBody() const
+{
+	if (pinned_body_.bytes)
+		return (pinned_body_);
+	return (StringView(requestBody_));
+}
+
+const std::string	&Request::getPinnedHead() const
 {
-	return (requestBody_);
+	return (pinned_);
+}
+
+bool	Request::hasPinnedBody() const
+{
+	return (pinned_body_.bytes != NULL);
 }
 
 void  Request::setRequestLine(const RequestLine &request_line)
@@ -57,6 +102,19 @@ void  Request::setRequestLine(const RequestLine &request_line)
   version_ = request_line.version;
 }
 
+// the authority of the request target changes hands instead of being copied,
+// the views keep looking at the bytes the line was parsed from
+void  Request::swapRequestLine(RequestLine &request_line)
+{
+  std::swap(method_, request_line.method);
+  std::swap(version_, request_line.version);
+  std::swap(request_target_.scheme, request_line.request_target.scheme);
+  std::swap(request_target_.authority, request_line.request_target.authority);
+  std::swap(request_target_.path, request_line.request_target.path);
+  std::swap(request_target_.query, request_line.request_target.query);
+  std::swap(request_target_.fragment, request_line.request_target.fragment);
+}
+
 void	Request::setMethod(const Method &method)
 {
 	method_ = method;
@@ -75,6 +133,27 @@ void	Request::setVersion(const Version &version)
 void	Request::setRequestBody(const std::string &requestBody)
 {
 	requestBody_ = requestBody;
+	pinned_body_ = StringView();
+}
+
+// The received bytes become the pinned buffer of the request: the request
+// line, the raw header values and a body received with the head are parsed
+// and read where they are, and the buffer is not touched until the request
+// is reset.
+void	Request::pinHead(std::string &received)
+{
+	pinned_.swap(received);
+	received.clear();
+}
+
+// The bytes after the head go back to the receive buffer, except the first
+// body_length of them, which stay pinned as the body of the request.
+void	Request::unpinRest(std::string &received, size_t head_length, size_t body_length)
+{
+	if (body_length > 0)
+		pinned_body_ = StringView(pinned_.data() + head_length, body_length);
+	if (head_length + body_length < pinned_.size())
+		received.append(pinned_, head_length + body_length, std::string::npos);
 }
 
 void	Request::reset()
@@ -84,4 +163,7 @@ void	Request::reset()
 	request_target_ = Uri();
 	version_ = kStandard;
 	requestBody_.clear();
+	// the socket allocates the receive buffer of the next request
+	std::string().swap(pinned_);
+	pinned_body_ = StringView();
 }
@@ -23,19 +23,26 @@ class Request : public HTTPMessage
 		const Method	&getMethod() const;
 		const struct Uri	&getRequestTarget() const;
 		const Version	&getVersion() const;
-		const std::string	&getRequestBody() const;
+		StringView	getRequestBody() const;
+		const std::string	&getPinnedHead() const;
+		bool	hasPinnedBody() const;
 
     void  setRequestLine(const RequestLine &request_line);
+    void  swapRequestLine(RequestLine &request_line);
 		void	setMethod(const Method &method);
 		void	setRequestTarget(const struct Uri &requestTarget);
 		void	setVersion(const Version &version);
 		void	setRequestBody(const std::string &requestBody);
+		void	pinHead(std::string &received);
+		void	unpinRest(std::string &received, size_t head_length, size_t body_length);
 		void	reset();
 
 	public:
     Method	    method_;
     struct Uri	request_target_;
     Version	    version_;
-		std::string requestBody_;
+		std::string requestBody_; // a body read after the head
+		std::string pinned_; // the head and the bytes received with it
+		StringView	pinned_body_;
 };
 
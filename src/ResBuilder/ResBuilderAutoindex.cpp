@@ -1,11 +1,14 @@
 #include "Client.hpp"
 #include <cassert>
 
-std::string res_builder::BuildAutoindexHTML(DSet files, std::string path)
+std::string res_builder::BuildAutoindexHTML(const DSet &files, std::string path)
 {
-	DSetIt it;
+	DSet::const_iterator it;
 
-	std::string html = "<!DOCTYPE html>\r\n";
+	// one line per entry is about 100 bytes plus the names
+	std::string html;
+	html.reserve(1024 + files.size() * (100 + 2 * path.size()));
+	html += "<!DOCTYPE html>\r\n";
 	html += "<html>\r\n";
 	html += "<head>";
 
@@ -43,7 +46,8 @@ std::string res_builder::BuildAutoindexHTML(DSet files, std::string path)
     for (it = ++(files.begin()); it != files.end(); ++it)
     {
       html += "<li><a href=\"";
-      html += path + it->second;
+      html += path;
+      html += it->second;
       if (it->first == DT_DIR)
         html += "\"><i class=\"fa-regular fa-folder\"></i>";
       else
@@ -61,16 +65,16 @@ std::string res_builder::BuildAutoindexHTML(DSet files, std::string path)
 void	res_builder::GenerateAutoindexResponse(struct Client *clt)
 {
 	// build the status line
-	std::string &response = clt->client_socket->res_buf;
+	std::string response;
 	BuildStatusLine(clt->status_code, response);
 
 	// build basic headers
-	BuildBasicHeaders(&clt->res);
+	BuildBasicHeaders(clt, response);
 
 	// build autoindex body
 	struct dirent *dirent;
 	std::string path = clt->path;
-	DIR	*dir_stream = opendir(path.c_str());
+	DIR	*dir_stream = process::file::OpenDirBeneath(clt->config.query, path);
 
 	if (dir_stream == NULL)
 	{
@@ -95,7 +99,7 @@ void	res_builder::GenerateAutoindexResponse(struct Client *clt)
 		return ;
 	}
 
-	std::string html = BuildAutoindexHTML(files, clt->req.getRequestTarget().path);
+	std::string html = BuildAutoindexHTML(files, clt->req.getRequestTarget().path.str());
 	if (closedir(dir_stream) == -1)
 	{
 		ServerError500(clt);
@@ -105,17 +109,11 @@ void	res_builder::GenerateAutoindexResponse(struct Client *clt)
 	clt->res.setResponseBody(html);
 
 	// build content headers
-	BuildContentHeaders(clt, "text/html", "");
+	BuildContentHeaders(clt, response, "text/html", "");
 
-	// add headers to the response
-	std::string	headers = clt->res.returnMapAsString();
-	if (headers.empty()) // stream error occurred
-	{
-		ServerError500(clt);
-		return ;
-	}
-	response += headers;
+	// add the remaining headers to the response
+	clt->res.appendHeaders(response);
 
-	// add body to response
-	response += clt->res.getResponseBody();
+	// queue the response with its body
+	QueueResponse(clt, response);
 }
@@ -0,0 +1,92 @@
+#include "Client.hpp"
+
+#include <cstring>
+
+namespace
+{
+	const char	kDayNames[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+	const char	kMonthNames[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+	// IMF-fixdate of RFC 7231, "Sun, 06 Nov 1994 08:49:37 GMT"
+	const size_t	kHttpDateLength = 29;
+	// last modification dates remembered by each thread, a power of two
+	const size_t	kModifiedDateSlots = 64;
+
+	struct FormattedDate
+	{
+		bool	valid;
+		time_t	time;
+		char	text[kHttpDateLength];
+	};
+
+	// Every thread that builds responses (the workers and the threads of the
+	// pools) keeps the date of the current second, formatted again when the
+	// second changes, and the dates of the files it served, keyed by mtime.
+	__thread FormattedDate	current_date;
+	__thread FormattedDate	modified_dates[kModifiedDateSlots];
+
+	void	WriteDigits(char *text, int value, int count)
+	{
+		while (count--)
+		{
+			text[count] = value % 10 + '0';
+			value /= 10;
+		}
+	}
+
+	// gmtime_r is locale independent, unlike the names of strftime
+	bool	FormatHttpDate(time_t raw_time, char *text)
+	{
+		struct tm	time_info;
+
+		if (gmtime_r(&raw_time, &time_info) == NULL || time_info.tm_year + 1900 < 0 || time_info.tm_year + 1900 > 9999)
+			return (false);
+		std::memcpy(text, kDayNames[time_info.tm_wday], 3);
+		std::memcpy(text + 3, ", ", 2);
+		WriteDigits(text + 5, time_info.tm_mday, 2);
+		text[7] = ' ';
+		std::memcpy(text + 8, kMonthNames[time_info.tm_mon], 3);
+		text[11] = ' ';
+		WriteDigits(text + 12, time_info.tm_year + 1900, 4);
+		text[16] = ' ';
+		WriteDigits(text + 17, time_info.tm_hour, 2);
+		text[19] = ':';
+		WriteDigits(text + 20, time_info.tm_min, 2);
+		text[22] = ':';
+		WriteDigits(text + 23, time_info.tm_sec, 2);
+		std::memcpy(text + 25, " GMT", 4);
+		return (true);
+	}
+
+	// false when the date cannot be written in the IMF-fixdate format
+	bool	LookUp(FormattedDate &date, time_t raw_time)
+	{
+		if (date.valid && date.time == raw_time)
+			return (true);
+		date.valid = FormatHttpDate(raw_time, date.text);
+		date.time = raw_time;
+		return (date.valid);
+	}
+
+	void	AppendFormattedDate(std::string &response, HeaderId id, const FormattedDate &date)
+	{
+		response += header::Name(id);
+		response += ": ";
+		response.append(date.text, kHttpDateLength);
+		response += "\r\n";
+	}
+}
+
+void	res_builder::AppendDateHeader(std::string &response)
+{
+	if (LookUp(current_date, time(NULL)))
+		AppendFormattedDate(response, kHeaderDate, current_date);
+}
+
+void	res_builder::AppendLastModifiedHeader(std::string &response, time_t modified)
+{
+	FormattedDate	&date = modified_dates[static_cast<size_t>(modified) & (kModifiedDateSlots - 1)];
+
+	if (LookUp(date, modified))
+		AppendFormattedDate(response, kHeaderLastModified, date);
+}
@@ -8,12 +8,6 @@ void	res_builder::BuildErrorHeaders(struct Client *clt)
 		case k405:
 			AddAllowHeader(clt);
 			break ;
-		case k408:
-			clt->res.addNewPair("Connection", new HeaderString("close"));
-			break ;
-		case k413:
-			clt->res.addNewPair("Connection", new HeaderString("close"));
-			break ;
 		case k415:
 			AddAcceptHeader(clt);
 			break ;
@@ -45,11 +39,11 @@ std::string res_builder::BuildErrorPage(StatusCode status_code)
 void	res_builder::GenerateErrorResponse(struct Client *clt)
 {
 	// build the status line
-	std::string &response = clt->client_socket->res_buf;
+	std::string response;
 	BuildStatusLine(clt->status_code, response);
 
 	// build basic and error headers
-	BuildBasicHeaders(&clt->res); // add basic headers
+	BuildBasicHeaders(clt, response);
 	BuildErrorHeaders(clt); // add additional headers according to the error code
 
 	// build the body
@@ -78,23 +72,17 @@ void	res_builder::GenerateErrorResponse(struct Client *clt)
 			return ;
 		}
 		// build content headers
-		BuildContentHeaders(clt, "text/html", pathErrorPage);
+		BuildContentHeaders(clt, response, "text/html", pathErrorPage);
 	}
 	else
 	{
 		clt->res.setResponseBody(BuildErrorPage(clt->status_code));
-		BuildContentHeaders(clt, "text/html", "");
+		BuildContentHeaders(clt, response, "text/html", "");
 	}
 
-	// add headers to the response
-	std::string	headers = clt->res.returnMapAsString();
-	if (headers.empty()) // stream error occurred
-	{
-		ServerError500(clt);
-		return ;
-	}
-	response += headers;
+	// add the remaining headers to the response
+	clt->res.appendHeaders(response);
 
-	// add body to response
-	response += clt->res.getResponseBody();
+	// queue the response with its body
+	QueueResponse(clt, response);
 }
@@ -36,29 +36,23 @@ void	res_builder::GenerateRedirectResponse(struct Client *clt)
 	assert((clt->status_code == k301 || clt->status_code == k307) &&  "Invalid status code for redirect");
 
 	// build the status line
-	std::string &response = clt->client_socket->res_buf;
+	std::string response;
 	BuildStatusLine(clt->status_code, response);
 
 	// build basic headers
-	BuildBasicHeaders(&clt->res);
+	BuildBasicHeaders(clt, response);
 
 	std::string location = clt->config.query->redirect->get_path();
-	clt->res.addNewPair("Location", new HeaderString(location));
+	clt->res.addNewPair<HeaderString>(kHeaderLocation, location);
 
 	// build the body and content headers
 	BuildRedirectResponseBody(clt);
-	BuildContentHeaders(clt, "text/html", "");
+	BuildContentHeaders(clt, response, "text/html", "");
 
-	// add headers to the response
-	std::string	headers = clt->res.returnMapAsString();
-	if (headers.empty()) // stream error occurred
-	{
-		ServerError500(clt);
-		return ;
-	}
-	response += headers;
+	// add the remaining headers to the response
+	clt->res.appendHeaders(response);
 
-	// add body to response
-	response += clt->res.getResponseBody();
+	// queue the response with its body
+	QueueResponse(clt, response);
 }
 
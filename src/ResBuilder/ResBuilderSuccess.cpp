@@ -46,67 +46,49 @@ void	res_builder::BuildPostResponseBody(struct Client *clt)
 void	res_builder::GenerateSuccessResponse(struct Client *clt)
 {
 	// build the status line
-	std::string &response = clt->client_socket->res_buf;
+	std::string response;
+	int	file_fd = -1;
+	size_t	file_size = 0;
 	BuildStatusLine(clt->status_code, response);
 
 	// build basic headers
-	BuildBasicHeaders(&clt->res);
+	BuildBasicHeaders(clt, response);
 
 	// build the body and content headers
 	if (!clt->cgi_argv.empty())
 	{
-		BuildContentHeadersCGI(clt);
+		BuildContentHeadersCGI(clt, response);
 	}
 	else
 	{
 		if (clt->req.getMethod() == kGet) // it is not a cgi request
 		{
-			if (ReadFileToBody(clt->path, &clt->res) != kResponseNoError)
+			if (OpenFileForBody(clt->config.query, clt->path, &file_fd, &file_size) != kResponseNoError)
 			{
 				ServerError500(clt);
 				return ;
 			}
-			std::string extension = process::GetReqExtension(clt->path);
-			if (extension == "" || extension == "txt")
-				extension = "text/plain";
-			else if (extension == "html" || extension == "htm")
-				extension = "text/html";
-			else if (extension == "css")
-				extension = "text/css";
-			else if (extension == "js")
-				extension = "text/javascript";
-			else if (extension == "json")
-				extension = "application/json";
-			else if (extension == "png")
-				extension = "image/png";
-			else if (extension == "jpg" || extension == "jpeg")
-				extension = "image/jpeg";
-			else
-				extension = "application/octet-stream";
-			BuildContentHeaders(clt, extension, clt->path);
+			std::string	extension = process::GetReqExtension(clt->path);
+			const directive::MimeTypes::MimeType	*mime_type = extension.empty() ? &constants::kNoExtensionMimeType : clt->config.query->mime_types->find_type(extension);
+			BuildContentHeaders(clt, response, mime_type ? *mime_type : clt->config.query->default_type, clt->path, file_size);
 		}
 		else if (clt->req.getMethod() == kPost) // it is not a cgi request
 		{
 			AddAllowHeader(clt);
 			AddLocationHeader(clt);
 			BuildPostResponseBody(clt);
-			BuildContentHeaders(clt, "text/html", "");
+			BuildContentHeaders(clt, response, "text/html", "");
 		}
 		else
 			assert(clt->req.getMethod() == kDelete && "Invalid method");
 	}
 
-	// add headers to the response
-	std::string	headers = clt->res.returnMapAsString();
-	if (headers.empty()) // stream error occurred
-	{
-		ServerError500(clt);
-		return ;
-	}
-	response += headers;
+	// add the remaining headers to the response
+	clt->res.appendHeaders(response);
 
-	// add body to response
-	if (!clt->res.getResponseBody().empty())
-		response += clt->res.getResponseBody();
+	// queue the response, a file body is sent straight from the disk
+	QueueResponse(clt, response);
+	if (file_fd != -1)
+		clt->client_socket->output.push_file(file_fd, 0, file_size);
 }
 
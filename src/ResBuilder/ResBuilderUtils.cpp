@@ -1,13 +1,81 @@
 #include "Client.hpp"
 
 #include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+	// the status codes are smaller than this, except kError
+	const int	kStatusCodeLimit = 600;
+	// enough for the status line and the headers of most responses
+	const size_t	kResponseHeadCapacity = 512;
+
+	struct StatusText
+	{
+		StatusCode	code;
+		const char	*text;
+	};
+
+	const StatusText	kStatusTexts[] = {
+		{k200, "200 OK"},
+		{k201, "201 Created"},
+		{k204, "204 No Content"},
+		{k301, "301 Moved Permanently"},
+		{k303, "303 See Other"},
+		{k304, "304 Not Modified"},
+		{k307, "307 Temporary Redirection"},
+		{k400, "400 Bad Request"},
+		{k403, "403 Forbidden"},
+		{k404, "404 Not Found"},
+		{k405, "405 Method Not Allowed"},
+		{k406, "406 Not Acceptable"},
+		{k408, "408 Request Timeout"},
+		{k411, "411 Length Required"},
+		{k412, "412 Precondition Failed"},
+		{k413, "413 Request Entity Too Large"},
+		{k414, "414 URI Too Long"},
+		{k415, "415 Unsupported Media Type"},
+		{k422, "422 Unprocessable Entity"},
+		{k500, "500 Internal Server Error"},
+		{k501, "501 Not Implemented"},
+		{k503, "503 Service Unavailable"},
+		{k504, "504 Gateway Timeout"},
+		{k505, "505 HTTP Version Not Supported"}
+	};
+
+	// The text and the status line of every code are serialized once, an
+	// unknown code has an empty text.
+	struct StatusTable
+	{
+		std::string	texts[kStatusCodeLimit];
+		std::string	lines[kStatusCodeLimit];
+
+		StatusTable()
+		{
+			for (size_t i = 0; i < sizeof(kStatusTexts) / sizeof(kStatusTexts[0]); i++)
+				texts[kStatusTexts[i].code] = kStatusTexts[i].text;
+			for (int code = 0; code < kStatusCodeLimit; code++)
+				lines[code] = "HTTP/1.1 " + texts[code] + "\r\n";
+		}
+	};
+
+	const StatusTable	kStatusTable;
+	const std::string	kUnknownStatusText;
+	const std::string	kUnknownStatusLine = "HTTP/1.1 \r\n";
+
+	// header lines whose value never changes
+	const std::string	kServerHeader = "Server: Webserv\r\n";
+	const std::string	kConnectionCloseHeader = "Connection: close\r\n";
+	const std::string	kHtmlContentTypeHeader = "Content-Type: text/html\r\n";
+}
 
 void	res_builder::AddLocationHeader(struct Client *clt)
 {
 	std::string file_path = clt->location_created;
 	size_t root_pos = file_path.find(clt->config.query->root) + clt->config.query->root.size();
 	std::string location = file_path.substr(root_pos);
-	clt->res.addNewPair("Location", new HeaderString(location));
+	clt->res.addNewPair<HeaderString>(kHeaderLocation, location);
 }
 
 std::string	res_builder::MethodToString(enum directive::Method method)
@@ -32,47 +100,44 @@ void	res_builder::AddAllowHeader(struct Client *clt)
 	for (int i = 1; i < 8; i *= 2)
 		if (allowed_methods & i)
 			allows.push_back(MethodToString((enum directive::Method) i));
-	clt->res.addNewPair("Allow", new HeaderStringVector(allows));
+	clt->res.addNewPair<HeaderStringVector>(kHeaderAllow, allows);
 }
 
 void	res_builder::AddAcceptHeader(struct Client *clt)
 {
-	StringVector	accepts;
-	std::map<directive::MimeTypes::Extension, directive::MimeTypes::MimeType>	mime_types = clt->config.query->mime_types->get();
-	std::map<directive::MimeTypes::Extension, directive::MimeTypes::MimeType>::iterator	it;
-	for (it = mime_types.begin(); it != mime_types.end(); ++it)
-		accepts.push_back(it->second);
-	clt->res.addNewPair("Accept", new HeaderStringVector(accepts));
+	clt->res.addNewPair<HeaderStringVector>(kHeaderAccept, clt->config.query->mime_types->types());
 }
 
-void	res_builder::BuildContentHeadersCGI(struct Client *clt)
+void	res_builder::BuildContentHeadersCGI(struct Client *clt, std::string &response)
 {
-	// add content-length header
-	clt->res.addNewPair("Content-Length", new HeaderInt(clt->cgi_content_length));
-
-	// add content-type header
-	clt->res.addNewPair("Content-Type", new HeaderString(clt->cgi_content_type));
+	AppendHeader(response, kHeaderContentLength, clt->cgi_content_length);
+	AppendHeader(response, kHeaderContentType, clt->cgi_content_type);
 
 	// add location header if created
 	if (!clt->location_created.empty())
 		AddLocationHeader(clt);
 }
 
-void	res_builder::BuildContentHeaders(struct Client *clt, std::string extension, std::string path)
+void	res_builder::BuildContentHeaders(struct Client *clt, std::string &response, const std::string &type, const std::string &path)
 {
-	// add content-length header
-	clt->res.addNewPair("Content-Length", new HeaderInt(clt->res.getResponseBody().size()));
+	BuildContentHeaders(clt, response, type, path, clt->res.getResponseBody().size());
+}
 
-	// add content-type header
-  clt->res.addNewPair("Content-Type", new HeaderString(extension));
+void	res_builder::BuildContentHeaders(struct Client *clt, std::string &response, const std::string &type, const std::string &path, size_t content_length)
+{
+	AppendHeader(response, kHeaderContentLength, content_length);
+	if (type == "text/html")
+		response += kHtmlContentTypeHeader;
+	else
+		AppendHeader(response, kHeaderContentType, type);
 
-	// add last-modified header
+	// add last-modified header, the error pages of a request without a location are outside of any root
 	struct stat	file_stat;
-	if (!path.empty() && stat(path.c_str(), &file_stat) == 0)
-	{
-		std::string last_modified = GetTimeGMT((time_t) file_stat.st_mtime);
-		clt->res.addNewPair("Last-Modified", new HeaderString(last_modified));
-	}
+	int	status = -1;
+	if (!path.empty())
+		status = clt->config.query ? process::file::StatBeneath(clt->config.query, path, &file_stat) : stat(path.c_str(), &file_stat);
+	if (status == 0)
+		AppendLastModifiedHeader(response, file_stat.st_mtime);
 }
 
 void	res_builder::ServerError500(struct Client *clt)
@@ -83,41 +148,50 @@ void	res_builder::ServerError500(struct Client *clt)
 	return ;
 }
 
-std::string	res_builder::GetTimeGMT(time_t raw_time)
+// the connection is closed after this response (408, 413, Connection: close, shutdown)
+void	res_builder::BuildBasicHeaders(struct Client *clt, std::string &response)
 {
-	struct tm	*time_info;
-	char		buffer[80];
-
-	time_info = gmtime(&raw_time); // GMT time
-	strftime(buffer, 80, "%a, %d %b %Y %H:%M:%S GMT", time_info);
-
-	return (std::string(buffer));
+	response += kServerHeader;
+	AppendDateHeader(response);
+	if (!clt->keepAlive)
+		response += kConnectionCloseHeader;
 }
 
-std::string	res_builder::GetTimeGMT()
+// the head of the response is written into one buffer, reserved here
+void	res_builder::BuildStatusLine(StatusCode status_code, std::string &response)
 {
-	time_t	raw_time;
-	struct tm	*time_info;
-	char		buffer[80];
-
-	time(&raw_time);
-	time_info = gmtime(&raw_time); // GMT time
-	strftime(buffer, 80, "%a, %d %b %Y %H:%M:%S GMT", time_info);
+	response.reserve(kResponseHeadCapacity);
+	response = StatusLine(status_code);
+}
 
-	return (std::string(buffer));
+const std::string	&res_builder::StatusLine(StatusCode code)
+{
+	if (static_cast<int>(code) < 0 || static_cast<int>(code) >= kStatusCodeLimit)
+		return (kUnknownStatusLine);
+	return (kStatusTable.lines[code]);
 }
 
-void	res_builder::BuildBasicHeaders(Response *res)
+void	res_builder::AppendHeader(std::string &response, HeaderId id, const std::string &value)
 {
-	res->addNewPair("Server", new HeaderString("Webserv"));
-	res->addNewPair("Date", new HeaderString(GetTimeGMT()));
+	response += header::Name(id);
+	response += ": ";
+	response += value;
+	response += "\r\n";
 }
 
-void	res_builder::BuildStatusLine(StatusCode status_code, std::string &response)
+void	res_builder::AppendHeader(std::string &response, HeaderId id, size_t value)
 {
-	response = "";
-	response += "HTTP/1.1 ";
-	response += StatusCodeAsString(status_code);
+	char	digits[20];
+	char	*digit = digits + sizeof(digits);
+
+	do
+	{
+		*--digit = value % 10 + '0';
+		value /= 10;
+	} while (value);
+	response += header::Name(id);
+	response += ": ";
+	response.append(digit, digits + sizeof(digits) - digit);
 	response += "\r\n";
 }
 
@@ -138,58 +212,37 @@ enum ResponseError	res_builder::ReadFileToBody(const std::string &path, Response
 	return (kResponseNoError);
 }
 
-std::string	res_builder::StatusCodeAsString(StatusCode code)
+// open a file that is sent from the disk instead of being copied into the response body
+enum ResponseError	res_builder::OpenFileForBody(const cache::LocationQuery *location, const std::string &path, int *fd, size_t *size)
 {
-	switch (code)
+	struct stat	file_stat;
+
+	*fd = process::file::OpenBeneath(location, path, O_RDONLY);
+	if (*fd == -1)
+		return (kFileOpenError);
+	if (fstat(*fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode))
 	{
-		case k200:
-			return ("200 OK");
-		case k201:
-			return ("201 Created");
-		case k204:
-			return ("204 No Content");
-		case k301:
-			return ("301 Moved Permanently");
-		case k303:
-			return ("303 See Other");
-		case k304:
-			return ("304 Not Modified");
-		case k307:
-			return ("307 Temporary Redirection");
-		case k400:
-			return ("400 Bad Request");
-		case k403:
-			return ("403 Forbidden");
-		case k404:
-			return ("404 Not Found");
-		case k405:
-			return ("405 Method Not Allowed");
-		case k406:
-			return ("406 Not Acceptable");
-		case k408:
-			return ("408 Request Timeout");
-		case k411:
-			return ("411 Length Required");
-		case k412:
-			return ("412 Precondition Failed");
-		case k413:
-			return ("413 Request Entity Too Large");
-		case k414:
-			return ("414 URI Too Long");
-		case k415:
-			return ("415 Unsupported Media Type");
-		case k422:
-			return ("422 Unprocessable Entity");
-		case k500:
-			return ("500 Internal Server Error");
-		case k501:
-			return ("501 Not Implemented");
-		case k503:
-			return ("503 Service Unavailable");
-		case k504:
-			return ("504 Gateway Timeout");
-		default:
-		 return (""); // Error
+		close(*fd);
+		*fd = -1;
+		return (kFileStreamError);
 	}
+	*size = file_stat.st_size;
+	return (kResponseNoError);
+}
+
+// move the status line, the headers and the body into the output queue of the client
+void	res_builder::QueueResponse(struct Client *clt, std::string &response)
+{
+	std::string	body;
+
+	clt->res.swapResponseBody(body);
+	clt->client_socket->output.push(response);
+	clt->client_socket->output.push(body);
 }
 
+const std::string	&res_builder::StatusCodeAsString(StatusCode code)
+{
+	if (static_cast<int>(code) < 0 || static_cast<int>(code) >= kStatusCodeLimit)
+		return (kUnknownStatusText);
+	return (kStatusTable.texts[code]);
+}
@@ -12,6 +12,9 @@ Response::~Response() {}
 
 Response &Response::operator=(const Response &obj)
 {
+	if (this == &obj)
+		return (*this);
+	HTTPMessage::operator=(obj);
 	responseBody_ = obj.responseBody_;
 	return (*this);
 }
@@ -26,6 +29,11 @@ void	Response::setResponseBody(const std::string &responseBody)
 	responseBody_ = responseBody;
 }
 
+void	Response::swapResponseBody(std::string &responseBody)
+{
+	responseBody_.swap(responseBody);
+}
+
 void Response::reset()
 {
 	cleanHeaderMap();
@@ -0,0 +1,101 @@
+#include "CompletionQueue.hpp"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <cerrno>
+#include <iostream>
+#include <stdint.h>
+#ifdef __linux__
+# include <sys/eventfd.h>
+#endif
+
+CompletionQueue::CompletionQueue() : head_(NULL)
+{
+	fds_[0] = -1;
+	fds_[1] = -1;
+}
+
+CompletionQueue::~CompletionQueue() {}
+
+bool CompletionQueue::open()
+{
+#ifdef __linux__
+	fds_[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fds_[0] == -1)
+	{
+		std::cerr << "eventfd: " << strerror(errno) << std::endl;
+		return (false);
+	}
+	fds_[1] = fds_[0];
+#else
+	if (pipe(fds_) == -1)
+	{
+		std::cerr << "pipe: " << strerror(errno) << std::endl;
+		return (false);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (fcntl(fds_[i], F_SETFL, O_NONBLOCK) == -1 || fcntl(fds_[i], F_SETFD, FD_CLOEXEC) == -1)
+		{
+			std::cerr << "fcntl: " << strerror(errno) << std::endl;
+			close();
+			return (false);
+		}
+	}
+#endif
+	return (true);
+}
+
+void CompletionQueue::close()
+{
+	if (fds_[0] != -1)
+		::close(fds_[0]);
+	if (fds_[1] != -1 && fds_[1] != fds_[0])
+		::close(fds_[1]);
+	fds_[0] = -1;
+	fds_[1] = -1;
+}
+
+int CompletionQueue::fd() const
+{
+	return (fds_[0]);
+}
+
+void CompletionQueue::push(Task *task)
+{
+	Task *head;
+	do
+	{
+		head = head_;
+		task->next_completed = head;
+	} while (!__sync_bool_compare_and_swap(&head_, head, task));
+	// the event loop is woken up once per batch, it takes the whole list at once
+	if (head == NULL)
+	{
+		uint64_t one = 1;
+		ssize_t written = write(fds_[1], &one, sizeof(one));
+		(void)written;
+	}
+}
+
+// The wakeup is consumed before the list is taken: a task pushed after the exchange
+// signals fd() again, and is found at the next wakeup.
+Task *CompletionQueue::pop_all()
+{
+	uint64_t signals;
+	while (read(fds_[0], &signals, sizeof(signals)) > 0)
+		;
+	Task *tasks = __sync_lock_test_and_set(&head_, static_cast<Task *>(NULL));
+	__sync_synchronize();
+	// the list is in push order reversed
+	Task *ordered = NULL;
+	while (tasks != NULL)
+	{
+		Task *next = tasks->next_completed;
+		tasks->next_completed = ordered;
+		ordered = tasks;
+		tasks = next;
+	}
+	return (ordered);
+}
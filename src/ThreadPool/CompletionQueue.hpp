@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Task.hpp"
+
+//Finished tasks on their way back to the event loop that submitted them.
+//Pool threads push without a lock, onto a singly linked list with a compare and swap.
+//The push onto an empty list also signals fd(), an eventfd (a pipe where there is no
+//eventfd) that the event loop polls together with its sockets.
+//
+//Like OutputQueue, the queue is copied inside a vector, the descriptors are closed by close().
+class CompletionQueue
+{
+	public:
+		CompletionQueue();
+		~CompletionQueue();
+
+		bool open();
+		void close();
+		int fd() const;
+
+		void push(Task *task); //from any thread
+		Task *pop_all(); //from the owning event loop, in completion order, linked by next_completed
+
+	private:
+		Task *volatile head_;
+		int fds_[2]; //read and write end, the same eventfd twice
+};
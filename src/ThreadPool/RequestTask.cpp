@@ -0,0 +1,40 @@
+#include "RequestTask.hpp"
+
+RequestTask::RequestTask(struct Client &client)
+	: cancelled(false), client_(client), socket_(*client.client_socket)
+{
+	// the copy of the request has its own pinned head and header values
+	client_.req.requestBody_.swap(client.req.requestBody_);
+	client_.client_socket = &socket_;
+	client_.task = NULL;
+	socket_.req_buf.clear();
+	// the configuration of the request must outlive the connection
+	if (client_.database)
+		client_.database->retain();
+}
+
+RequestTask::~RequestTask()
+{
+	socket_.output.clear();
+	if (client_.database)
+		client_.database->release();
+}
+
+void RequestTask::run()
+{
+	process::ProcessRequest(&client_);
+}
+
+void RequestTask::finish(struct Client &client)
+{
+	struct ClientSocket *client_socket = client.client_socket;
+	client = client_;
+	client.client_socket = client_socket;
+	client.task = NULL;
+	client_socket->output.swap(socket_.output);
+}
+
+int RequestTask::fd() const
+{
+	return (socket_.socket);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Task.hpp"
+#include "Client.hpp"
+
+//A request whose response is built in a pool thread, because building it waits for the disk.
+//The task works on copies of the client and of its socket: the event loop moves clients
+//inside its vectors, and may close the connection before the task is finished.
+class RequestTask : public Task
+{
+	public:
+		RequestTask(struct Client &client); //takes the request body of client
+		~RequestTask();
+
+		void run();
+		//the result goes back to the client, the response to the output of its socket
+		void finish(struct Client &client);
+
+		int fd() const;
+		bool cancelled; //the connection was closed, the result is dropped
+
+	private:
+		struct Client client_;
+		struct ClientSocket socket_;
+};
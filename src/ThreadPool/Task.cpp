@@ -0,0 +1,7 @@
+#include "Task.hpp"
+
+#include <cstddef>
+
+Task::Task() : completions(NULL), next_completed(NULL) {}
+
+Task::~Task() {}
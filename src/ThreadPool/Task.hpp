@@ -0,0 +1,22 @@
+#pragma once
+
+class CompletionQueue;
+
+//Work that an event loop hands to a pool thread.
+//run() is called in the pool thread. The task is then pushed to the CompletionQueue of
+//the event loop that submitted it, which finishes it in its own thread.
+class Task
+{
+	public:
+		Task();
+		virtual ~Task();
+
+		virtual void run() = 0;
+
+		CompletionQueue *completions; //set by the pool when the task is submitted
+		Task *next_completed; //link in the CompletionQueue
+
+	private:
+		Task(const Task &src);
+		Task &operator=(const Task &src);
+};
@@ -0,0 +1,92 @@
+#include "ThreadPool.hpp"
+
+#include <signal.h>
+#include <string.h>
+#include <iostream>
+
+ThreadPool::ThreadPool() : stopping_(false)
+{
+	pthread_mutex_init(&lock_, NULL);
+	pthread_cond_init(&queued_, NULL);
+}
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+	pthread_cond_destroy(&queued_);
+	pthread_mutex_destroy(&lock_);
+}
+
+// Fails only if no thread could be started, the pool then stays stopped.
+bool ThreadPool::start(size_t threads)
+{
+	sigset_t all;
+	sigset_t previous;
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &previous);
+	stopping_ = false;
+	for (size_t i = 0; i < threads; i++)
+	{
+		pthread_t thread;
+		int error = pthread_create(&thread, NULL, thread_main, this);
+		if (error != 0)
+		{
+			std::cerr << "pthread_create: " << strerror(error) << std::endl;
+			break;
+		}
+		threads_.push_back(thread);
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	return (!threads_.empty());
+}
+
+void ThreadPool::stop()
+{
+	pthread_mutex_lock(&lock_);
+	stopping_ = true;
+	pthread_cond_broadcast(&queued_);
+	pthread_mutex_unlock(&lock_);
+	std::vector<pthread_t>::iterator it;
+	for (it = threads_.begin(); it != threads_.end(); it++)
+		pthread_join(*it, NULL);
+	threads_.clear();
+}
+
+bool ThreadPool::running() const
+{
+	return (!threads_.empty());
+}
+
+void ThreadPool::submit(Task *task, CompletionQueue *completions)
+{
+	task->completions = completions;
+	pthread_mutex_lock(&lock_);
+	tasks_.push_back(task);
+	pthread_cond_signal(&queued_);
+	pthread_mutex_unlock(&lock_);
+}
+
+void *ThreadPool::thread_main(void *pool)
+{
+	static_cast<ThreadPool *>(pool)->run_tasks();
+	return (NULL);
+}
+
+void ThreadPool::run_tasks()
+{
+	pthread_mutex_lock(&lock_);
+	while (true)
+	{
+		while (tasks_.empty() && !stopping_)
+			pthread_cond_wait(&queued_, &lock_);
+		if (tasks_.empty())
+			break;
+		Task *task = tasks_.front();
+		tasks_.pop_front();
+		pthread_mutex_unlock(&lock_);
+		task->run();
+		task->completions->push(task);
+		pthread_mutex_lock(&lock_);
+	}
+	pthread_mutex_unlock(&lock_);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Task.hpp"
+#include "CompletionQueue.hpp"
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+//Threads that run the blocking work of the event loops, like nginx's aio threads.
+//The event loops submit tasks to one shared queue and go on with their other
+//connections, a finished task comes back through the CompletionQueue given to submit().
+//The pool threads block all signals, the signals stay with the main thread.
+class ThreadPool
+{
+	public:
+		ThreadPool();
+		~ThreadPool();
+
+		bool start(size_t threads);
+		void stop(); //runs the tasks that are still queued, then joins the threads
+		bool running() const;
+
+		void submit(Task *task, CompletionQueue *completions);
+
+	private:
+		pthread_mutex_t lock_;
+		pthread_cond_t queued_;
+		std::deque<Task *> tasks_;
+		std::vector<pthread_t> threads_;
+		bool stopping_;
+
+		static void *thread_main(void *pool);
+		void run_tasks();
+
+		ThreadPool(const ThreadPool &src);
+		ThreadPool &operator=(const ThreadPool &src);
+};
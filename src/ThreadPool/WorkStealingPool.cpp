@@ -0,0 +1,162 @@
+#include "WorkStealingPool.hpp"
+
+#include <signal.h>
+#include <string.h>
+#include <iostream>
+
+WorkStealingPool::WorkStealingPool()
+	: queued_(0), sleepers_(0), stopping_(false), next_queue_(0), stolen_(0)
+{
+	pthread_mutex_init(&idle_lock_, NULL);
+	pthread_cond_init(&idle_, NULL);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	stop();
+	pthread_cond_destroy(&idle_);
+	pthread_mutex_destroy(&idle_lock_);
+}
+
+// Fails only if no thread could be started, the pool then stays stopped.
+bool WorkStealingPool::start(size_t threads)
+{
+	// the threads read their Thread and Queue, both are in place before the first one starts
+	threads_.resize(threads);
+	for (size_t i = 0; i < threads; i++)
+	{
+		Queue *queue = new Queue;
+		pthread_mutex_init(&queue->lock, NULL);
+		queues_.push_back(queue);
+		threads_[i].pool = this;
+		threads_[i].index = i;
+	}
+	sigset_t all;
+	sigset_t previous;
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &previous);
+	stopping_ = false;
+	size_t started = 0;
+	for (; started < threads; started++)
+	{
+		int error = pthread_create(&threads_[started].thread, NULL, thread_main, &threads_[started]);
+		if (error != 0)
+		{
+			std::cerr << "pthread_create: " << strerror(error) << std::endl;
+			break;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	// the queues of the threads that did not start are emptied by the other threads
+	threads_.resize(started);
+	if (started == 0)
+		stop();
+	return (started > 0);
+}
+
+void WorkStealingPool::stop()
+{
+	pthread_mutex_lock(&idle_lock_);
+	stopping_ = true;
+	pthread_cond_broadcast(&idle_);
+	pthread_mutex_unlock(&idle_lock_);
+	std::vector<Thread>::iterator it;
+	for (it = threads_.begin(); it != threads_.end(); it++)
+		pthread_join(it->thread, NULL);
+	threads_.clear();
+	std::vector<Queue *>::iterator queue;
+	for (queue = queues_.begin(); queue != queues_.end(); queue++)
+	{
+		pthread_mutex_destroy(&(*queue)->lock);
+		delete *queue;
+	}
+	queues_.clear();
+}
+
+bool WorkStealingPool::running() const
+{
+	return (!threads_.empty());
+}
+
+unsigned long WorkStealingPool::stolen() const
+{
+	return (stolen_);
+}
+
+void WorkStealingPool::submit(Task *task, CompletionQueue *completions)
+{
+	task->completions = completions;
+	Queue *queue = queues_[__sync_fetch_and_add(&next_queue_, 1) % queues_.size()];
+	pthread_mutex_lock(&queue->lock);
+	queue->tasks.push_back(task);
+	__sync_add_and_fetch(&queued_, 1);
+	pthread_mutex_unlock(&queue->lock);
+	// a thread counts itself in sleepers_ before it looks at queued_, so either it sees this
+	// task or it is seen here, and it holds idle_lock_ until it waits
+	if (__sync_add_and_fetch(&sleepers_, 0) > 0)
+	{
+		pthread_mutex_lock(&idle_lock_);
+		pthread_cond_signal(&idle_);
+		pthread_mutex_unlock(&idle_lock_);
+	}
+}
+
+void *WorkStealingPool::thread_main(void *thread)
+{
+	Thread *self = static_cast<Thread *>(thread);
+	self->pool->run_tasks(self->index);
+	return (NULL);
+}
+
+void WorkStealingPool::run_tasks(size_t index)
+{
+	while (true)
+	{
+		Task *task = take(index);
+		if (task != NULL)
+		{
+			task->run();
+			task->completions->push(task);
+			continue;
+		}
+		// queued_ is raised with the push and lowered with the take, so it is only above 0 here
+		// for a task queued after take() looked at its queue: the next turn finds it
+		pthread_mutex_lock(&idle_lock_);
+		__sync_add_and_fetch(&sleepers_, 1);
+		while (__sync_add_and_fetch(&queued_, 0) == 0 && !stopping_)
+			pthread_cond_wait(&idle_, &idle_lock_);
+		__sync_sub_and_fetch(&sleepers_, 1);
+		bool done = (__sync_add_and_fetch(&queued_, 0) == 0 && stopping_);
+		pthread_mutex_unlock(&idle_lock_);
+		if (done)
+			return ;
+	}
+}
+
+Task *WorkStealingPool::take(size_t index)
+{
+	Task *task = NULL;
+	Queue *own = queues_[index];
+	pthread_mutex_lock(&own->lock);
+	if (!own->tasks.empty())
+	{
+		task = own->tasks.front();
+		own->tasks.pop_front();
+		__sync_sub_and_fetch(&queued_, 1);
+	}
+	pthread_mutex_unlock(&own->lock);
+	for (size_t i = 1; task == NULL && i < queues_.size(); i++)
+	{
+		Queue *victim = queues_[(index + i) % queues_.size()];
+		pthread_mutex_lock(&victim->lock);
+		if (!victim->tasks.empty())
+		{
+			task = victim->tasks.back();
+			victim->tasks.pop_back();
+			__sync_sub_and_fetch(&queued_, 1);
+			__sync_add_and_fetch(&stolen_, 1);
+		}
+		pthread_mutex_unlock(&victim->lock);
+	}
+	return (task);
+}
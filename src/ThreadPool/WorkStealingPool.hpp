@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Task.hpp"
+#include "CompletionQueue.hpp"
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+//Threads for the CPU-heavy part of the responses, like the HTML of a large directory listing.
+//Every thread has its own queue. The event loops spread their tasks over the queues, a thread
+//runs the tasks of its own queue first and steals from the other queues when it has none,
+//so one expensive task does not hold up the tasks queued behind it. The idle lock is only taken
+//by a thread that has found no task and goes to sleep, and by a submit() that may have to wake it.
+//A finished task comes back through the CompletionQueue given to submit().
+class WorkStealingPool
+{
+	public:
+		WorkStealingPool();
+		~WorkStealingPool();
+
+		bool start(size_t threads);
+		void stop(); //runs the tasks that are still queued, then joins the threads
+		bool running() const;
+
+		void submit(Task *task, CompletionQueue *completions);
+
+		unsigned long stolen() const; //tasks run by another thread than the one they were queued to
+
+	private:
+		//a thread takes from the front of its own queue, thieves from the back
+		struct Queue
+		{
+			pthread_mutex_t lock;
+			std::deque<Task *> tasks;
+		};
+		struct Thread
+		{
+			WorkStealingPool *pool;
+			size_t index;
+			pthread_t thread;
+		};
+
+		std::vector<Queue *> queues_;
+		std::vector<Thread> threads_;
+		pthread_mutex_t idle_lock_;
+		pthread_cond_t idle_;
+		size_t queued_; //tasks in all queues, changed under the lock of the queue, atomic
+		size_t sleepers_; //threads waiting on idle_ or about to, atomic
+		bool stopping_; //guarded by idle_lock_
+		size_t next_queue_; //round robin of submit(), atomic
+		unsigned long stolen_; //atomic
+
+		static void *thread_main(void *thread);
+		void run_tasks(size_t index);
+		Task *take(size_t index);
+
+		WorkStealingPool(const WorkStealingPool &src);
+		WorkStealingPool &operator=(const WorkStealingPool &src);
+};
@@ -0,0 +1,62 @@
+#include "Path.hpp"
+
+namespace uri
+{
+  static int  HexValue(char character)
+  {
+    if (character >= '0' && character <= '9')
+      return character - '0';
+    if (character >= 'A' && character <= 'F')
+      return character - 'A' + 10;
+    if (character >= 'a' && character <= 'f')
+      return character - 'a' + 10;
+    return -1;
+  }
+
+  // The output always ends with the segment being decoded, which starts after
+  // the last slash of the output. A slash of the input, or the end of it,
+  // completes the segment.
+  bool  NormalizePath(const StringView& path, std::string& output)
+  {
+    size_t  segment = 1;
+
+    output.assign(1, '/');
+    for (size_t i = 0; i <= path.length; i++)
+    {
+      bool  end = (i == path.length);
+      char  character = '/';
+      if (!end)
+      {
+        character = path.bytes[i];
+        if (character == '%' && i + 2 < path.length && HexValue(path.bytes[i + 1]) >= 0 && HexValue(path.bytes[i + 2]) >= 0)
+        {
+          character = static_cast<char>(HexValue(path.bytes[i + 1]) << 4 | HexValue(path.bytes[i + 2]));
+          i += 2;
+        }
+        if (character == '\0')
+          return false;
+        if (character != '/')
+        {
+          output += character;
+          continue;
+        }
+      }
+      size_t  length = output.size() - segment;
+      if (length == 1 && output[segment] == '.')
+        output.resize(segment);
+      else if (length == 2 && output[segment] == '.' && output[segment + 1] == '.')
+      {
+        // the root is its own parent
+        if (segment > 1)
+          segment = output.rfind('/', segment - 2) + 1;
+        output.resize(segment);
+      }
+      else if (length > 0 && !end)
+      {
+        output += '/';
+        segment = output.size();
+      }
+    }
+    return true;
+  }
+} // namespace uri
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "misc/StringView.hpp"
+
+namespace uri
+{
+  // Canonical form of the path of a request target, in a single pass: the
+  // pct-encoded bytes are decoded, repeated slashes are collapsed and the
+  // "." and ".." segments are removed. A ".." never goes above the root, so
+  // the result can be appended to a root directory. A trailing slash is kept.
+  // Returns false when the path decodes to a NUL byte.
+  bool  NormalizePath(const StringView& path, std::string& output);
+} // namespace uri
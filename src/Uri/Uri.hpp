@@ -5,17 +5,20 @@
 #include <utility>
 
 #include "Uri/Authority.hpp"
+#include "misc/StringView.hpp"
 
 namespace uri
 {
   typedef std::vector<std::pair<std::string, std::string> > Query;
 } // namespace uri
 
+// The views are in the request line the target was parsed from, the
+// authority of an absolute-form target is copied.
 struct Uri
 {
-  std::string     scheme;
+  StringView      scheme;
   uri::Authority  authority;
-  std::string     path;
-  std::string     query;
-  std::string     fragment;
+  StringView      path;
+  StringView      query;
+  StringView      fragment;
 };
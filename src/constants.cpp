@@ -4,25 +4,54 @@
 #include "Configuration/Directive/Simple/MimeTypes.hpp"
 #include "Configuration/Directive/Simple.hpp"
 #include "Configuration/Directive/Simple/AllowMethods.hpp"
+#include "Configuration/Directive/Simple/Listen.hpp"
 
 namespace constants
 {
   const int kDefaultWorkerConnections = 1024;
 
+  const size_t kDefaultShutdownTimeout = 10; // seconds
+
+  const size_t kDefaultMultiAccept = 64; // connections accepted per poll() wakeup and listening socket
+
+  const std::string kDefaultUse = "epoll"; // falls back to poll where epoll is not available
+
+  const size_t kDefaultWorkerThreads = 1; // the event loop runs in the main thread only
+
+  const size_t kDefaultAioThreads = 0; // disk operations run in the event loops
+
+  const size_t kDefaultCpuThreads = 0; // directory listings are built in the event loops
+
+  const int kDefaultListenBacklog = 511;
+
+  const directive::ListenOptions kDefaultListenOptions;
+
   const uri::Authority  kDefaultAuthority;
 
   const directive::Methods  kDefaultAllowedMethods = directive::kMethodGet | directive::kMethodDelete;
 
   const size_t  kDefaultClientMaxBodySize = (1 << 20); // 1 MB
 
+  const size_t  kDefaultClientHeaderBufferSize = 1024;
+
+  const size_t  kDefaultClientBodyBufferSize = 16384;
+
   const std::string  kDefaultRoot = "html";
 
   const directive::Index  kDefaultIndex("index.html");
 
   const bool  kDefaultAutoindex = false;
 
+  const bool  kDefaultTcpNodelay = true;
+
+  const bool  kDefaultTcpNopush = false;
+
   const directive::MimeTypes  kDefaultMimeTypes = Nothing();
 
+  const std::string  kDefaultMimeType = "application/octet-stream";
+  // the files without an extension, default_type is for the unknown extensions
+  const std::string  kNoExtensionMimeType = "text/plain";
+
   const std::string  kDefaultAccessLog = "logs/access.log";
 
   const std::string  kDefaultErrorLog = "logs/error.log";
@@ -4,25 +4,53 @@
 #include "Configuration/Directive/Simple/MimeTypes.hpp"
 #include "Configuration/Directive/Simple.hpp"
 #include "Configuration/Directive/Simple/AllowMethods.hpp"
+#include "Configuration/Directive/Simple/Listen.hpp"
 
 namespace constants
 {
   extern const int                  kDefaultWorkerConnections;
 
+  extern const size_t               kDefaultShutdownTimeout;
+
+  extern const size_t               kDefaultMultiAccept;
+
+  extern const std::string          kDefaultUse;
+
+  extern const size_t               kDefaultWorkerThreads;
+
+  extern const size_t               kDefaultAioThreads;
+
+  extern const size_t               kDefaultCpuThreads;
+
+  extern const int                  kDefaultListenBacklog;
+
+  extern const directive::ListenOptions kDefaultListenOptions;
+
   extern const uri::Authority       kDefaultAuthority;
 
   extern const directive::Methods   kDefaultAllowedMethods;
 
   extern const size_t               kDefaultClientMaxBodySize;
 
+  extern const size_t               kDefaultClientHeaderBufferSize;
+
+  extern const size_t               kDefaultClientBodyBufferSize;
+
   extern const std::string          kDefaultRoot;
 
   extern const directive::Index     kDefaultIndex;
 
   extern const bool                 kDefaultAutoindex;
 
+  extern const bool                 kDefaultTcpNodelay;
+
+  extern const bool                 kDefaultTcpNopush;
+
   extern const directive::MimeTypes kDefaultMimeTypes;
 
+  extern const std::string          kDefaultMimeType;
+  extern const std::string          kNoExtensionMimeType;
+
   extern const std::string          kDefaultAccessLog;
 
   extern const std::string          kDefaultErrorLog;
@@ -1,49 +1,132 @@
 #include "socket_manager/SocketManager.hpp"
 #include "socket_manager/SocketError.hpp"
+#include "socket_manager/EventPoller.hpp"
+#include "ThreadPool/ThreadPool.hpp"
+#include "ThreadPool/WorkStealingPool.hpp"
+#include "ThreadPool/RequestTask.hpp"
 #include "Configuration.hpp"
 #include "Client.hpp"
 #include "Http/Parser.hpp"
+#include "Http/Scanner.hpp"
 #include "Configuration/Parser.hpp"
 
 #include <poll.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <ctime>
+#include <cstdlib>
+#include <sstream>
 #include <string.h>
 #include <cerrno>
 #include <cassert>
 #include <signal.h>
+#include <pthread.h>
+#include <climits>
 
 #include <vector>
 
 #define POLL_TIMEOUT 30
 
-int server_running = 1;
+// layout of pfds: [signal pipe][completion queue][server sockets][client sockets]
+#define SIGNAL_PFD 0
+#define COMPLETION_PFD 1
+#define SERVER_PFDS_BEGIN 2
 
+// listening sockets passed to the new binary on SIGUSR2, as "fd;fd;"
+#define INHERITED_FDS_ENV "WEBSERV_LISTEN_FDS"
+// first fd passed by systemd socket activation
+#define SD_LISTEN_FDS_START 3
+
+extern char **environ;
+
+volatile sig_atomic_t server_running = 1;
+volatile sig_atomic_t server_reload = 0;
+volatile sig_atomic_t server_force_stop = 0;
+volatile sig_atomic_t server_upgrade = 0;
+int signal_pipe[2] = {-1, -1}; // written by the signal handler to wake up worker 0
+__thread EventPoller *event_poller = NULL; // poll, epoll or io_uring of the calling worker, chosen by the use directive at startup
+
+// One event loop. Worker 0 runs in the main thread: it owns the listening sockets, handles the
+// signals and wakes up the other workers, which accept from the same listening sockets.
+// A connection is served by the worker that accepted it until it is closed.
+struct Worker
+{
+	int id;
+	pthread_t thread;
+	int wake_pipe[2]; // worker 0 uses the signal pipe
+	unsigned long generation; // of the listening sockets in the SocketManager of the worker
+	CompletionQueue completions; // requests processed by the disk pool
+	int pending_tasks;
+	enum SocketError result;
+};
+std::vector<struct Worker> workers; // not resized while the threads run
+int workers_running = 0; // threads other than worker 0, atomic
+
+ThreadPool disk_pool; // aio_threads, shared by the workers
+WorkStealingPool cpu_pool; // cpu_threads, shared by the workers
+
+std::string executable_path; // started again on SIGUSR2
+
+// listening sockets of worker 0, published to the other workers at startup and on a reload
+pthread_mutex_t listeners_lock = PTHREAD_MUTEX_INITIALIZER;
+std::vector<struct ServerSocket> listeners;
+unsigned long listeners_generation = 0;
+
+// The pollfd vector of a worker, every change is passed to its event poller.
 namespace pollfds
 {
+	void AddFd(std::vector<struct pollfd> &pfds, int fd, enum EventPoller::Kind kind)
+	{
+		struct pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		pfds.push_back(pfd);
+		event_poller->watch(pfds, pfds.size() - 1, kind);
+	}
+
 	int AddServerFd(std::vector<struct pollfd> &pfds, std::vector<struct ServerSocket> servers)
 	{
 		std::vector<struct ServerSocket>::iterator it;
 		for (it = servers.begin(); it != servers.end(); it++)
+			AddFd(pfds, it->socket, EventPoller::kListen);
+		return (servers.size());
+	}
+
+	// replace the server fds in pfds, the client fds are kept in place
+	int ReplaceServerFd(std::vector<struct pollfd> &pfds, int server_socket_count, std::vector<struct ServerSocket> servers)
+	{
+		for (int i = SERVER_PFDS_BEGIN; i < SERVER_PFDS_BEGIN + server_socket_count; i++)
+			event_poller->remove(pfds[i].fd);
+		pfds.erase(pfds.begin() + SERVER_PFDS_BEGIN, pfds.begin() + SERVER_PFDS_BEGIN + server_socket_count);
+		struct pollfd pfd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		for (size_t i = 0; i < servers.size(); i++)
 		{
-			struct pollfd pfd;
-			pfd.fd = it->socket;
-			pfd.events = POLLIN;
-			pfds.push_back(pfd);
+			pfd.fd = servers[i].socket;
+			pfds.insert(pfds.begin() + SERVER_PFDS_BEGIN + i, pfd);
+			event_poller->watch(pfds, SERVER_PFDS_BEGIN + i, EventPoller::kListen);
 		}
+		event_poller->moved(pfds, SERVER_PFDS_BEGIN + servers.size());
 		return (servers.size());
 	}
 
 	void AddClientFd(std::vector<struct pollfd> &pfds, int client_socket)
 	{
-		struct pollfd pfd;
-		pfd.fd = client_socket;
-		pfd.events = POLLIN;
-		pfds.push_back(pfd);
+		AddFd(pfds, client_socket, EventPoller::kConnection);
 	}
 
+	void SetEvents(struct pollfd &pfd, short events)
+	{
+		event_poller->modify(pfd, events);
+	}
+
+	// the fd has been closed with event_poller->close()
 	void DeleteClientFd(std::vector<struct pollfd> &pfds, int i)
 	{
 		pfds.erase(pfds.begin() + i);
+		event_poller->moved(pfds, i);
 	}
 }
 
@@ -73,6 +156,9 @@ void PrintClients(std::vector<struct Client> &clients)
 
 void DeleteClient(std::vector<struct Client> &clients, SocketManager &sm, int client_fd)
 {
+	struct Client *clt = client_lifespan::GetClientByFd(clients, client_fd);
+	if (clt && clt->task)
+		clt->task->cancelled = true;
 	int index = client_lifespan::DeleteClientFromVector(clients, client_fd);
 	sm.delete_client_socket(client_fd);
 	for (std::vector<struct Client>::iterator it = clients.begin() + index; it != clients.end(); it++)
@@ -81,123 +167,533 @@ void DeleteClient(std::vector<struct Client> &clients, SocketManager &sm, int cl
 	}
 }
 
+void CloseClient(std::vector<struct Client> &clients, SocketManager &sm, std::vector<struct pollfd> &pfds, int i)
+{
+	event_poller->close(pfds[i].fd);
+	DeleteClient(clients, sm, pfds[i].fd);
+	pollfds::DeleteClientFd(pfds, i);
+	PrintClients(clients);
+}
+
+// Send as much of the response as the socket accepts right away, the socket is almost always
+// writable after a request. POLLOUT is only waited for when the kernel buffer is full.
+// With io_uring the kernel sends the whole output queue, and POLLOUT is reported when it is done.
+// Returns -1 when the connection failed, 1 while the output is not sent yet.
+int SendOutput(SocketManager &sm, int fd, struct ClientSocket *client_socket)
+{
+	if (event_poller->completes_io())
+		return (event_poller->send(fd, client_socket->output, client_socket->nopush));
+	if (client_socket->output.empty())
+		return (0);
+	if (sm.send_to_client(fd) < 0)
+		return (-1);
+	return (client_socket->output.empty() ? 0 : 1);
+}
+
+// Returns false when the client was closed.
+bool FlushResponse(std::vector<struct Client> &clients, SocketManager &sm, std::vector<struct pollfd> &pfds, int i)
+{
+	struct Client *clt = client_lifespan::GetClientByFd(clients, pfds[i].fd);
+	if (!clt->client_socket->output.empty())
+	{
+		if (clt->config.query)
+			sm.set_tcp_options(pfds[i].fd, clt->config.query->tcp_nodelay, clt->config.query->tcp_nopush);
+		else
+			sm.set_tcp_options(pfds[i].fd, constants::kDefaultTcpNodelay, constants::kDefaultTcpNopush);
+	}
+	int sent = SendOutput(sm, pfds[i].fd, clt->client_socket);
+	if (sent < 0)
+	{
+		PrintDebugMessage("send() error (removed from pdfs)", pfds[i].fd);
+		CloseClient(clients, sm, pfds, i);
+		return (false);
+	}
+	if (sent > 0)
+	{
+		pollfds::SetEvents(pfds[i], POLLOUT);
+		return (true);
+	}
+	// check if client is still alive
+	if (client_lifespan::IsClientAlive(clt) == false)
+	{
+		PrintDebugMessage("Response sent, client is not alive (removed from pdfs)", pfds[i].fd);
+		CloseClient(clients, sm, pfds, i);
+		return (false);
+	}
+	// all bytes are sent, and client is still alive
+	pollfds::SetEvents(pfds[i], POLLIN);
+	sm.set_time_assets(pfds[i].fd);
+	client_lifespan::ResetClient(*clt);
+	PrintDebugMessage("Reset", pfds[i].fd);
+	PrintClients(clients);
+	return (true);
+}
+
+// Build the response of the request, in the cpu pool for a directory listing, in the disk
+// pool if it waits for the disk. The client is not polled until the task is finished.
+// Returns false when the client was closed.
+bool HandleRequest(struct Worker &worker, std::vector<struct Client> &clients, SocketManager &sm, std::vector<struct pollfd> &pfds, int i)
+{
+	struct Client *clt = client_lifespan::GetClientByFd(clients, pfds[i].fd);
+	bool to_cpu_pool = cpu_pool.running() && process::IsCpuRequest(clt);
+	if (to_cpu_pool || (disk_pool.running() && process::IsDiskRequest(clt)))
+	{
+		clt->task = new RequestTask(*clt);
+		if (to_cpu_pool)
+			cpu_pool.submit(clt->task, &worker.completions);
+		else
+			disk_pool.submit(clt->task, &worker.completions);
+		worker.pending_tasks++;
+		pollfds::SetEvents(pfds[i], 0);
+		PrintDebugMessage("Request handed to a thread pool", pfds[i].fd);
+		return (true);
+	}
+	process::ProcessRequest(clt);
+	return (FlushResponse(clients, sm, pfds, i));
+}
+
+// Send the responses built by the disk pool. Returns the number of closed clients.
+int FinishTasks(struct Worker &worker, std::vector<struct Client> &clients, SocketManager &sm, std::vector<struct pollfd> &pfds)
+{
+	int closed = 0;
+	Task *task = worker.completions.pop_all();
+	while (task != NULL)
+	{
+		RequestTask *request = static_cast<RequestTask *>(task);
+		task = task->next_completed;
+		worker.pending_tasks--;
+		if (!request->cancelled)
+		{
+			for (size_t i = SERVER_PFDS_BEGIN; i < pfds.size(); i++)
+			{
+				if (pfds[i].fd != request->fd())
+					continue;
+				request->finish(*client_lifespan::GetClientByFd(clients, pfds[i].fd));
+				if (!FlushResponse(clients, sm, pfds, i))
+					closed++;
+				break;
+			}
+		}
+		delete request;
+	}
+	return (closed);
+}
+
 void SignalHandler(int signum)
 {
-	if (signum == SIGINT)
+	int saved_errno = errno;
+	if (signum == SIGINT || signum == SIGTERM)
+	{
+		// a second signal skips the draining
+		if (!server_running)
+			server_force_stop = 1;
 		server_running = 0;
+	}
+	else if (signum == SIGHUP)
+		server_reload = 1;
+	else if (signum == SIGUSR2)
+		server_upgrade = 1;
+	ssize_t written = write(signal_pipe[1], "", 1);
+	(void)written;
+	errno = saved_errno;
 }
 
-int main(int argc, char **argv)
+// a byte written to the pipe wakes up the event loop that polls it
+bool OpenWakePipe(int fds[2])
 {
-	if (argc != 2)
+	if (pipe(fds) == -1)
 	{
-		std::cout << "Usage: " << argv[0] << " configuration_file" << std::endl;
-		return (1);
+		std::cerr << "pipe: " << strerror(errno) << std::endl;
+		return (false);
 	}
-	else if (signal(SIGINT, SignalHandler) == SIG_ERR)
+	for (int i = 0; i < 2; i++)
+	{
+		if (fcntl(fds[i], F_SETFL, O_NONBLOCK) == -1 || fcntl(fds[i], F_SETFD, FD_CLOEXEC) == -1)
+		{
+			std::cerr << "fcntl: " << strerror(errno) << std::endl;
+			close(fds[0]);
+			close(fds[1]);
+			return (false);
+		}
+	}
+	return (true);
+}
+
+// the signal pipe lets a signal wake up poll() immediately instead of at the next poll timeout
+bool SetupSignals()
+{
+	if (!OpenWakePipe(signal_pipe))
+		return (false);
+	if (signal(SIGINT, SignalHandler) == SIG_ERR ||
+		signal(SIGTERM, SignalHandler) == SIG_ERR ||
+		signal(SIGHUP, SignalHandler) == SIG_ERR ||
+		signal(SIGUSR2, SignalHandler) == SIG_ERR ||
+		signal(SIGPIPE, SIG_IGN) == SIG_ERR) // sendfile() has no MSG_NOSIGNAL
 	{
 		std::cerr << "signal: " << strerror(errno) << std::endl;
-		return (1);
+		return (false);
 	}
+	return (true);
+}
+
+// the other workers look at server_running, server_force_stop and the listening sockets
+void WakeWorkers()
+{
+	for (size_t i = 1; i < workers.size(); i++)
 	{
-		std::ifstream file(argv[1], std::ios::in | std::ios::ate);
-		if (!file.is_open())
+		ssize_t written = write(workers[i].wake_pipe[1], "", 1);
+		(void)written;
+	}
+}
+
+void PublishServers(const SocketManager &sm)
+{
+	pthread_mutex_lock(&listeners_lock);
+	listeners = sm.get_servers();
+	listeners_generation++;
+	pthread_mutex_unlock(&listeners_lock);
+	WakeWorkers();
+}
+
+// Take the listening sockets published by worker 0 if they changed since the last call.
+// A worker can poll a socket that worker 0 has just closed until it is woken up, accept()
+// on it fails and the worker carries on.
+int RefreshServers(struct Worker &worker, SocketManager &sm, std::vector<struct pollfd> &pfds, int server_socket_count)
+{
+	std::vector<struct ServerSocket> servers;
+	pthread_mutex_lock(&listeners_lock);
+	bool changed = (listeners_generation != worker.generation);
+	if (changed)
+	{
+		servers = listeners;
+		worker.generation = listeners_generation;
+	}
+	pthread_mutex_unlock(&listeners_lock);
+	if (!changed)
+		return (server_socket_count);
+	sm.share_servers(servers);
+	return (pollfds::ReplaceServerFd(pfds, server_socket_count, sm.get_servers()));
+}
+
+// Listening sockets passed by systemd socket activation (LISTEN_FDS) or by the previous binary
+// on an upgrade. They are removed from the environment so that CGI scripts do not see them.
+std::vector<int> InheritedListenFds()
+{
+	std::vector<int> fds;
+	const char *listen_pid = getenv("LISTEN_PID");
+	const char *listen_fds = getenv("LISTEN_FDS");
+	if (listen_pid && listen_fds && atol(listen_pid) == getpid())
+	{
+		int count = atoi(listen_fds);
+		for (int fd = SD_LISTEN_FDS_START; fd < SD_LISTEN_FDS_START + count; fd++)
+			fds.push_back(fd);
+	}
+	const char *inherited = getenv(INHERITED_FDS_ENV);
+	if (inherited)
+	{
+		std::istringstream stream(inherited);
+		std::string fd;
+		while (std::getline(stream, fd, ';'))
 		{
-			std::cerr << "Unable to open file " << argv[1] << std::endl;
-			return (1);
+			if (!fd.empty())
+				fds.push_back(atoi(fd.c_str()));
 		}
-		size_t size = file.tellg();
-		char *string = new char[size];
-		file.seekg(0, std::ios::beg);
-		file.read(string, size);
-		file.close();
-
-		directive_parser::ParseOutput parsed_main_block = directive_parser::ParseMainBlock(directive_parser::ParseInput(string, size));
-		delete[] string;
-		if (parsed_main_block.is_valid())
-		{
-			directive::MainBlock *main_block = static_cast<directive::MainBlock *>(parsed_main_block.result);
-#ifdef DEBUG
-			main_block->print(0);
+	}
+	unsetenv("LISTEN_PID");
+	unsetenv("LISTEN_FDS");
+	unsetenv("LISTEN_FDNAMES");
+	unsetenv(INHERITED_FDS_ENV);
+	return (fds);
+}
+
+// Path of the running binary, resolved at startup: argv[0] can be relative to the working
+// directory or looked up in PATH.
+std::string ResolveExecutablePath(const char *argv0)
+{
+	char path[PATH_MAX];
+#ifdef __linux__
+	ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+	if (length > 0)
+		return (std::string(path, length));
 #endif
-			if (main_block->http() == NULL)
-			{
-				std::cerr << "Configuration file must include a HTTP block" << std::endl;
-				return (1);
-			}
-			if (!directive::DirectiveRangeIsValid(main_block->http()->servers()))
-			{
-				std::cerr << "Configuration file must include at least one Server block" << std::endl;
-				return (1);
-			}
-			ws_database.set_main_block(main_block);
-		}
-		else
+	if (realpath(argv0, path) != NULL)
+		return (path);
+	return (argv0);
+}
+
+// Start the new binary on SIGUSR2 with the listening sockets of this process. Both processes
+// accept connections until this one is stopped with SIGTERM and has drained its connections,
+// so there is no moment without a listener.
+void UpgradeBinary(char **argv, SocketManager &sm, std::vector<struct pollfd> &pfds, int server_socket_count)
+{
+	// only async-signal-safe calls are made between fork() and execve(), so the
+	// environment of the new binary is built here
+	std::string listen_fds = INHERITED_FDS_ENV "=";
+	std::vector<struct ServerSocket> servers = sm.get_servers();
+	for (std::vector<struct ServerSocket>::iterator it = servers.begin(); it != servers.end(); it++)
+	{
+		std::ostringstream fd;
+		fd << it->socket << ";";
+		listen_fds += fd.str();
+	}
+	std::vector<char *> envp;
+	for (char **variable = environ; *variable != NULL; variable++)
+	{
+		if (strncmp(*variable, INHERITED_FDS_ENV "=", sizeof(INHERITED_FDS_ENV)) != 0)
+			envp.push_back(*variable);
+	}
+	envp.push_back(&listen_fds[0]);
+	envp.push_back(NULL);
+	pid_t pid = fork();
+	if (pid == -1)
+	{
+		std::cerr << "fork: " << strerror(errno) << std::endl;
+		return ;
+	}
+	if (pid == 0)
+	{
+		// the client connections stay with the old process
+		for (unsigned long i = SERVER_PFDS_BEGIN + server_socket_count; i < pfds.size(); i++)
+			close(pfds[i].fd);
+		execve(executable_path.c_str(), argv, &envp[0]);
+		const char message[] = "upgrade: execve failed\n";
+		ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+		(void)written;
+		_exit(1);
+	}
+	std::cout << "upgrade: started " << executable_path << " with pid " << pid << std::endl;
+}
+
+// Stop accepting new connections and close the idle ones. The connections with a request in
+// progress get their response (with Connection: close) and are closed afterwards.
+int StartDrain(struct Worker &worker, SocketManager &sm, std::vector<struct pollfd> &pfds, int server_socket_count, std::vector<struct Client> &clients, int &client_count)
+{
+	if (worker.id != 0)
+		std::cout << "worker " << worker.id << ": ";
+	std::cout << "shutting down, " << clients.size() << " connections open" << std::endl;
+	sm.print_accept_stats();
+	sm.close_servers();
+	server_socket_count = pollfds::ReplaceServerFd(pfds, server_socket_count, sm.get_servers());
+	for (unsigned long i = SERVER_PFDS_BEGIN + server_socket_count; i < pfds.size(); i++)
+	{
+		struct Client *clt = client_lifespan::GetClientByFd(clients, pfds[i].fd);
+		clt->keepAlive = false;
+		if (pfds[i].events == POLLIN && !clt->continue_reading && clt->client_socket->req_buf.empty())
 		{
-			std::cerr << "Configuration file parsing error" << std::endl;
-			return (1);
+			PrintDebugMessage("Idle at shutdown (removed from pfds)", pfds[i].fd);
+			CloseClient(clients, sm, pfds, i);
+			client_count--;
+			i--;
 		}
 	}
+	return (server_socket_count);
+}
 
+// read and parse the configuration file, returns NULL if the file is not a valid configuration
+Configuration *LoadConfiguration(const char *path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::ate);
+	if (!file.is_open())
+	{
+		std::cerr << "Unable to open file " << path << std::endl;
+		return (NULL);
+	}
+	size_t size = file.tellg();
+	char *string = new char[size];
+	file.seekg(0, std::ios::beg);
+	file.read(string, size);
+	file.close();
+
+	directive_parser::ParseOutput parsed_main_block = directive_parser::ParseMainBlock(directive_parser::ParseInput(string, size));
+	delete[] string;
+	if (!parsed_main_block.is_valid())
+	{
+		std::cerr << "Configuration file parsing error" << std::endl;
+		return (NULL);
+	}
+	directive::MainBlock *main_block = static_cast<directive::MainBlock *>(parsed_main_block.result);
+#ifdef DEBUG
+	main_block->print(0);
+#endif
+	if (main_block->http() == NULL)
+	{
+		std::cerr << "Configuration file must include a HTTP block" << std::endl;
+		delete main_block;
+		return (NULL);
+	}
+	if (!directive::DirectiveRangeIsValid(main_block->http()->servers()))
+	{
+		std::cerr << "Configuration file must include at least one Server block" << std::endl;
+		delete main_block;
+		return (NULL);
+	}
+	Configuration *database = new Configuration();
+	database->set_main_block(main_block);
+	return (database);
+}
+
+// Reload the configuration file on SIGHUP. Requests that are already being processed keep the
+// configuration they started with, the old configuration is freed when the last of them is reset.
+// If the new configuration is invalid, or one of its sockets can not be opened, the old one stays.
+// Returns false if the old configuration stays.
+bool ReloadConfiguration(const char *path, SocketManager &sm)
+{
+	std::cout << "reloading configuration " << path << std::endl;
+	Configuration *database = LoadConfiguration(path);
+	if (database == NULL)
+	{
+		std::cerr << "reload: keeping the old configuration" << std::endl;
+		return (false);
+	}
+	if (database->worker_connections() != ws_database->worker_connections())
+		std::cerr << "reload: worker_connections only takes effect after a restart" << std::endl;
+	if (database->worker_threads() != workers.size())
+		std::cerr << "reload: worker_threads only takes effect after a restart" << std::endl;
+	if (sm.update_servers(database->all_server_sockets(), *database) != kNoError)
+	{
+		std::cerr << "reload: keeping the old configuration" << std::endl;
+		database->release();
+		return (false);
+	}
+	ReplaceConfiguration(database);
+	return (true);
+}
+
+// The connection loop of one worker. Worker 0 also handles the reload and upgrade signals,
+// the other workers follow the listening sockets that it publishes.
+enum SocketError EventLoop(struct Worker &worker, SocketManager &sm, char **argv)
+{
+	Configuration *database = AcquireConfiguration();
 	std::vector<struct Client> clients;
 	std::vector<struct pollfd> pfds;
-	static char recv_buf[BUF_SIZE];
+	EventPoller poller;
+	event_poller = &poller;
 
-	int max_clients = ws_database.worker_connections();
-	SocketManager sm(max_clients);
+	int max_clients = database->worker_connections();
 	int client_count = 0;
-	SocketError err;
+	int multi_accept = database->multi_accept();
+	std::vector<int> accepted;
+	enum SocketError err = kNoError;
+	clients.reserve(max_clients);
+	pfds.reserve(SERVER_PFDS_BEGIN + max_clients + sm.get_servers().size());
+	poller.open(database->use());
+	if (worker.id == 0)
+		std::cout << "event method: " << poller.name() << std::endl;
+	worker.pending_tasks = 0;
+	if (!worker.completions.open())
 	{
-		std::vector<const uri::Authority *> sockets = ws_database.all_server_sockets();
-		clients.reserve(max_clients);
-		pfds.reserve(max_clients + sockets.size());
-		err = sm.set_servers(sockets);
+		database->release();
+		return (kPollError);
 	}
-	if (err != kNoError)
-		return (err);
+	pollfds::AddFd(pfds, worker.wake_pipe[0], EventPoller::kNotify);
+	pollfds::AddFd(pfds, worker.completions.fd(), EventPoller::kNotify);
 	int server_socket_count = pollfds::AddServerFd(pfds, sm.get_servers());
-	while (server_running)
+	bool draining = false;
+	bool update_configuration = false;
+	time_t drain_deadline = 0;
+	while (true)
 	{
-		// poll for events
-		int poll_count = poll(pfds.data(), pfds.size(), POLL_TIMEOUT * 1000);
+		if (!server_running && !draining)
+		{
+			draining = true;
+			drain_deadline = time(NULL) + database->shutdown_timeout();
+			server_socket_count = StartDrain(worker, sm, pfds, server_socket_count, clients, client_count);
+		}
+		// worker 0 stops after the other workers, it has to wake them up on a second signal
+		bool idle = clients.empty() && (worker.id != 0 || __sync_add_and_fetch(&workers_running, 0) == 0);
+		if (draining && (idle || server_force_stop || time(NULL) >= drain_deadline))
+			break;
+		if (worker.id == 0 && server_reload)
+		{
+			server_reload = 0;
+			if (!draining && ReloadConfiguration(argv[1], sm))
+			{
+				server_socket_count = pollfds::ReplaceServerFd(pfds, server_socket_count, sm.get_servers());
+				PublishServers(sm);
+				update_configuration = true;
+			}
+		}
+		if (worker.id == 0 && server_upgrade)
+		{
+			server_upgrade = 0;
+			if (!draining)
+				UpgradeBinary(argv, sm, pfds, server_socket_count);
+		}
+		// after a reload: multi_accept and shutdown_timeout of the new configuration
+		if (update_configuration && !draining)
+		{
+			update_configuration = false;
+			if (worker.id != 0)
+				server_socket_count = RefreshServers(worker, sm, pfds, server_socket_count);
+			database->release();
+			database = AcquireConfiguration();
+			multi_accept = database->multi_accept();
+		}
+		// poll for events, while draining wake up in time for the deadline
+		int poll_timeout = POLL_TIMEOUT * 1000;
+		if (draining && (drain_deadline - time(NULL)) < POLL_TIMEOUT)
+			poll_timeout = (drain_deadline - time(NULL)) * 1000;
+		int poll_count = poller.wait(pfds, poll_timeout);
 		if (poll_count == -1)
 		{
-			std::cerr << "poll: " << strerror(errno) << std::endl;
+			if (errno == EINTR)
+				continue;
+			std::cerr << poller.name() << ": " << strerror(errno) << std::endl;
 			// TODO: error handling
 			err = kPollError;
 			break;
 		}
+		if (pfds[SIGNAL_PFD].revents & POLLIN)
+		{
+			char signal_buf[16];
+			while (read(worker.wake_pipe[0], signal_buf, sizeof(signal_buf)) > 0)
+				;
+			if (worker.id == 0)
+				WakeWorkers();
+			else
+				update_configuration = true;
+		}
+		if (pfds[COMPLETION_PFD].revents & POLLIN)
+			client_count -= FinishTasks(worker, clients, sm, pfds);
 		// check events for server sockets
-		for (int i = 0; i < server_socket_count; i++)
+		for (int i = SERVER_PFDS_BEGIN; i < SERVER_PFDS_BEGIN + server_socket_count; i++)
 		{
 			if (pfds[i].revents & POLLIN)
 			{
-				if (client_count < max_clients)
+				// accept connections if max clients not reached, at most multi_accept of them
+				int budget = max_clients - client_count;
+				if (budget > multi_accept)
+					budget = multi_accept;
+				if (budget <= 0)
+					continue;
+				if (poller.completes_io())
 				{
-					// accept connection if max clients not reached
-					int client_socket_fd = sm.accept_client(pfds[i].fd);
-					if (client_socket_fd == -1)
-						continue;
-					else
-					{
-						// add client to pollfd
-						pollfds::AddClientFd(pfds, client_socket_fd);
-						client_count++;
-						// add client to clients vector
-						struct Client client;
-						struct ClientSocket *client_socket = sm.get_one_client(client_socket_fd);
-						client_lifespan::InitClient(client, client_socket);
-						clients.push_back(client);
+					poller.accept(pfds[i].fd, budget, accepted);
+					sm.adopt_clients(pfds[i].fd, accepted);
+				}
+				else
+					sm.accept_clients(pfds[i].fd, budget, accepted);
+				for (std::vector<int>::iterator it = accepted.begin(); it != accepted.end(); it++)
+				{
+					// add client to pollfd, read optimistically in this iteration: with defer_accept
+					// or a fast client the request is usually already there
+					pollfds::AddClientFd(pfds, *it);
+					pfds.back().revents = POLLIN;
+					client_count++;
+					// add client to clients vector
+					struct Client client;
+					struct ClientSocket *client_socket = sm.get_one_client(*it);
+					client_lifespan::InitClient(client, client_socket);
+					clients.push_back(client);
 #ifndef NDEBUG
-						std::cerr << "Client " << client.client_socket->socket << ": accepted at server fd " << pfds[i].fd << std::endl;
+					std::cerr << "Client " << client.client_socket->socket << ": accepted at server fd " << pfds[i].fd << std::endl;
 #endif
-						PrintClients(clients);
-					}
 				}
+				PrintClients(clients);
 			}
 		}
 		// check events for client sockets
-		for (unsigned long i = server_socket_count; i < pfds.size(); i++)
+		for (unsigned long i = SERVER_PFDS_BEGIN + server_socket_count; i < pfds.size(); i++)
 		{
 			// get the client struct by checking the pfds[i].fd
 			struct Client *clt = client_lifespan::GetClientByFd(clients, pfds[i].fd);
@@ -206,7 +702,7 @@ int main(int argc, char **argv)
 			if ((pfds[i].revents & POLLERR))
 			{
 				PrintDebugMessage("POLLERR (removed from pfds)", pfds[i].fd);
-				close(pfds[i].fd);
+				event_poller->close(pfds[i].fd);
 				DeleteClient(clients, sm, pfds[i].fd);
 				pollfds::DeleteClientFd(pfds, i);
 				PrintClients(clients);
@@ -217,7 +713,7 @@ int main(int argc, char **argv)
 			else if ((pfds[i].revents & POLLHUP))
 			{
 				PrintDebugMessage("POLLHUP (removed from pfds)", pfds[i].fd);
-				close(pfds[i].fd);
+				event_poller->close(pfds[i].fd);
 				DeleteClient(clients, sm, pfds[i].fd);
 				pollfds::DeleteClientFd(pfds, i);
 				PrintClients(clients);
@@ -230,7 +726,7 @@ int main(int argc, char **argv)
 				if (timeout == true)
 				{
 					PrintDebugMessage("Timeout at revents that are not POLLIN nor POLLOUT (removed from pfds)", pfds[i].fd);
-					close(pfds[i].fd);
+					event_poller->close(pfds[i].fd);
 					DeleteClient(clients, sm, pfds[i].fd);
 					pollfds::DeleteClientFd(pfds, i);
 					PrintClients(clients);
@@ -249,18 +745,30 @@ int main(int argc, char **argv)
 					// set 408 in client struct and process::ProcessRequest()
 					// client_lifespan::UpdateStatusCode(clt, k408);
 					clt->status_code = k408;
-					pfds[i].events = POLLOUT;
 					clt->keepAlive = false;
-					process::ProcessRequest(clt);
+					if (!HandleRequest(worker, clients, sm, pfds, i))
+					{
+						client_count--;
+						i--;
+					}
 					continue;
 				}
 				// recv from client and add to request buffer
-				ssize_t recv_len = sm.recv_append(pfds[i].fd, recv_buf);
+				ssize_t recv_len;
+				if (poller.completes_io())
+					recv_len = poller.receive(pfds[i].fd, clt->client_socket->req_buf);
+				else
+					recv_len = sm.recv_append(pfds[i].fd);
 				// 1st timestamp for timeout, using Maybe<time_t> first_recv_time in the else block of recv_append()
-				if (recv_len <= 0)
+				if (recv_len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				{
+					// nothing to read yet after an optimistic read
+					continue;
+				}
+				else if (recv_len <= 0)
 				{
 					PrintDebugMessage("recv_len <= 0 (removed from pfds)", pfds[i].fd);
-					close(pfds[i].fd);
+					event_poller->close(pfds[i].fd);
 					DeleteClient(clients, sm, pfds[i].fd);
 					pollfds::DeleteClientFd(pfds, i);
 					PrintClients(clients);
@@ -288,66 +796,88 @@ int main(int argc, char **argv)
 							}
 							clt->client_socket->req_buf.erase(0, remove_size);
 						}
-						if (clt->client_socket->req_buf.find("\r\n\r\n") == std::string::npos)
+						std::string &req_buf = clt->client_socket->req_buf;
+						if (http_parser::FindEmptyLine(req_buf.data(), req_buf.size()) == req_buf.size())
 						{
 							// parse request line and headers as once
 							continue;
 						}
-						size_t find_index = clt->client_socket->req_buf.find("\r\n");
-						if (find_index != std::string::npos)
+						// the received bytes are pinned in the request, which refers to its
+						// request line, header values and a small body where they are
+						clt->req.pinHead(req_buf);
+						const std::string &head = clt->req.getPinnedHead();
+						size_t head_start = 0;
+						size_t head_length = 0;
+						size_t find_index = http_parser::FindNewLine(head.data(), head.size());
+						if (find_index != head.size())
 						{
-							temporary::arena.clear();
-							http_parser::ParseOutput parsed_request_line = http_parser::ParseRequestLine(http_parser::StringSlice(clt->client_socket->req_buf.c_str(), find_index + 2));
-							if (!parsed_request_line.is_valid())
+							RequestLine request_line;
+							// the common "GET /path?query HTTP/1.1" is analysed without a parse tree
+							size_t request_line_length = AnalysisOriginFormRequestLine(head.data(), find_index, &request_line, &error);
+							if (request_line_length == 0)
 							{
-								// handle only syntax error
-								PrintDebugMessage("Request line syntax error", pfds[i].fd);
-								clt->status_code = k400;
-								clt->keepAlive = false;
-								process::ProcessRequest(clt);
-								pfds[i].events = POLLOUT;
 								temporary::arena.clear();
-								continue;
-							}
-							else
-							{
-								RequestLine request_line;
+								http_parser::ParseOutput parsed_request_line = http_parser::ParseRequestLine(http_parser::StringSlice(head.c_str(), find_index + 2));
+								if (!parsed_request_line.is_valid())
+								{
+									// handle only syntax error
+									clt->req.unpinRest(req_buf, 0, 0);
+									PrintDebugMessage("Request line syntax error", pfds[i].fd);
+									clt->status_code = k400;
+									clt->keepAlive = false;
+									if (!HandleRequest(worker, clients, sm, pfds, i))
+									{
+										client_count--;
+										i--;
+									}
+									temporary::arena.clear();
+									continue;
+								}
 								error = AnalysisRequestLine(static_cast<http_parser::PTNodeRequestLine *>(parsed_request_line.result), &request_line);
-								if (error != kNone)
-									clt->consume_body = false;
-								clt->status_code = ParseErrorToStatusCode(error);
-								clt->req.setRequestLine(request_line);
-								clt->client_socket->req_buf.erase(0, parsed_request_line.length + 2);
+								request_line_length = parsed_request_line.length;
+								temporary::arena.clear();
 							}
-							temporary::arena.clear();
+							if (error != kNone)
+								clt->consume_body = false;
+							clt->status_code = ParseErrorToStatusCode(error);
+							clt->req.swapRequestLine(request_line);
+							head_start = request_line_length + 2;
 						}
-						find_index = clt->client_socket->req_buf.find("\r\n\r\n");
-						if (find_index != std::string::npos)
+						find_index = http_parser::FindEmptyLine(head.data() + head_start, head.size() - head_start);
+						if (find_index != head.size() - head_start)
 						{
 							temporary::arena.clear();
-							http_parser::ParseOutput parsed_headers = ParseFields(http_parser::StringSlice(clt->client_socket->req_buf.c_str(), find_index + 4));
+							http_parser::ParseOutput parsed_headers = ParseFields(http_parser::StringSlice(head.c_str() + head_start, find_index + 4));
 							if (!parsed_headers.is_valid())
 							{
 								// handle only syntax error
+								clt->req.unpinRest(req_buf, head_start, 0);
 								PrintDebugMessage("Request fields syntax error", pfds[i].fd);
 								clt->status_code = k400;
 								clt->keepAlive = false;
-								process::ProcessRequest(clt);
-								pfds[i].events = POLLOUT;
+								if (!HandleRequest(worker, clients, sm, pfds, i))
+								{
+									client_count--;
+									i--;
+								}
 								temporary::arena.clear();
 								continue;
 							}
 							else
 							{
-								enum ParseError errorReqHeaders = AnalysisRequestHeaders(static_cast<http_parser::PTNodeFields *>(parsed_headers.result), &clt->req.headers_);
+								enum ParseError errorReqHeaders = AnalysisRequestHeaders(static_cast<http_parser::PTNodeFields *>(parsed_headers.result), &clt->req);
 								if (error == kSyntaxError)
 								{
 									// handle only syntax error
+									clt->req.unpinRest(req_buf, head_start, 0);
 									PrintDebugMessage("Request field value syntax error", pfds[i].fd);
 									clt->status_code = k400;
 									clt->keepAlive = false;
-									process::ProcessRequest(clt);
-									pfds[i].events = POLLOUT;
+									if (!HandleRequest(worker, clients, sm, pfds, i))
+									{
+										client_count--;
+										i--;
+									}
 									continue;
 								}
 								if (errorReqHeaders != kNone)
@@ -355,11 +885,27 @@ int main(int argc, char **argv)
 								if (error == kNone)
 									error = errorReqHeaders;
 								clt->status_code = ParseErrorToStatusCode(error);
-								clt->client_socket->req_buf.erase(0, parsed_headers.length + 2);
+								head_length = head_start + parsed_headers.length + 2;
 							}
 							temporary::arena.clear();
 						}
+						else
+							head_length = head_start;
 						client_lifespan::CheckHeaderBeforeProcess(clt); // We Suppose the first read will contain all the headers
+						if (draining)
+							clt->keepAlive = false;
+						// a body received whole with the head stays pinned, the rest is read
+						// into the receive buffer
+						size_t pinned_body = 0;
+						if (!clt->is_chunked && clt->consume_body)
+						{
+							HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer(kHeaderContentLength));
+							if (content_length && content_length->content() > 0 &&
+								static_cast<size_t>(content_length->content()) <= clt->max_body_size &&
+								static_cast<size_t>(content_length->content()) <= head.size() - head_length)
+								pinned_body = content_length->content();
+						}
+						clt->req.unpinRest(req_buf, head_length, pinned_body);
 					}
 					if (clt->is_chunked)
 					{
@@ -369,22 +915,26 @@ int main(int argc, char **argv)
 						{
 							bool syntax_error_during_unchunk = false;
 							int	chunk_size = 0;
+							std::string &req_buf = clt->client_socket->req_buf;
+							// the chunks are read in place, and the buffer is compacted once
+							size_t consumed = 0;
 							do
 							{
-								unsigned long index = clt->client_socket->req_buf.find("\r\n");
+								unsigned long index = req_buf.find("\r\n", consumed);
 								if (index == std::string::npos)
 								{
 									require_more_bytes = true;
 									break;
 								}
-								http_parser::ParseOutput chunk_size_line = http_parser::ParseChunkSizeLine(http_parser::Input(clt->client_socket->req_buf.c_str(), index));
+								const char *chunk_start = req_buf.c_str() + consumed;
+								http_parser::ParseOutput chunk_size_line = http_parser::ParseChunkSizeLine(http_parser::Input(chunk_start, index - consumed));
 								if (!chunk_size_line.is_valid())
 								{
 									syntax_error_during_unchunk = true;
 									break;
 								}
 								unsigned int bytes_before_chunk_data = chunk_size_line.length + 2;
-								if (!http_parser::ScanNewLine(http_parser::Input(clt->client_socket->req_buf.c_str() + chunk_size_line.length, 2)).is_valid())
+								if (!http_parser::ScanNewLine(http_parser::Input(chunk_start + chunk_size_line.length, 2)).is_valid())
 								{
 									syntax_error_during_unchunk = true;
 									break;
@@ -395,7 +945,7 @@ int main(int argc, char **argv)
 									if (chunk_size == 0)
 									{
 										// last chunk
-										clt->client_socket->req_buf.erase(0, bytes_before_chunk_data);
+										consumed += bytes_before_chunk_data;
 										break;
 									}
 								}
@@ -404,23 +954,21 @@ int main(int argc, char **argv)
 									clt->exceed_max_body_size = true;
 								}
 								unsigned int bytes_entire_chunk = bytes_before_chunk_data + chunk_size + 2;
-								if (clt->client_socket->req_buf.length() < bytes_entire_chunk)
+								if (req_buf.length() - consumed < bytes_entire_chunk)
 								{
 									require_more_bytes = true;
 									break;
 								}
-								else if (!http_parser::ScanNewLine(http_parser::Input(clt->client_socket->req_buf.c_str() + bytes_before_chunk_data + chunk_size, 2)).is_valid())
+								else if (!http_parser::ScanNewLine(http_parser::Input(chunk_start + bytes_before_chunk_data + chunk_size, 2)).is_valid())
 								{
 									syntax_error_during_unchunk = true;
 									break;
 								}
 								if (!clt->exceed_max_body_size && clt->consume_body)
-								{
-									std::string chunk = clt->client_socket->req_buf.substr(bytes_before_chunk_data, chunk_size);
-									clt->req.requestBody_.append(chunk);
-								}
-								clt->client_socket->req_buf.erase(0, bytes_entire_chunk);
+									clt->req.requestBody_.append(chunk_start + bytes_before_chunk_data, chunk_size);
+								consumed += bytes_entire_chunk;
 							} while (chunk_size > 0);
+							req_buf.erase(0, consumed);
 							if (require_more_bytes)
 							{
 								continue;
@@ -429,8 +977,11 @@ int main(int argc, char **argv)
 							{
 								clt->status_code = k400;
 								clt->keepAlive = false;
-								process::ProcessRequest(clt);
-								pfds[i].events = POLLOUT;
+								if (!HandleRequest(worker, clients, sm, pfds, i))
+								{
+									client_count--;
+									i--;
+								}
 								continue;
 							}
 						}
@@ -465,8 +1016,11 @@ int main(int argc, char **argv)
 							{
 								clt->status_code = k400;
 								clt->keepAlive = false;
-								process::ProcessRequest(clt);
-								pfds[i].events = POLLOUT;
+								if (!HandleRequest(worker, clients, sm, pfds, i))
+								{
+									client_count--;
+									i--;
+								}
 								continue;
 							}
 							if (require_more_bytes)
@@ -481,40 +1035,64 @@ int main(int argc, char **argv)
 							clt->status_code = k413;
 							clt->keepAlive = false;
 						}
-						process::ProcessRequest(clt);
-						pfds[i].events = POLLOUT;
+						if (!HandleRequest(worker, clients, sm, pfds, i))
+						{
+							client_count--;
+							i--;
+							continue;
+						}
 					}
 					else
 					{
 						if (!clt->continue_reading)
 						{
-							HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer("Content-Length"));
+							HeaderInt *content_length = static_cast<HeaderInt *>(clt->req.returnValueAsPointer(kHeaderContentLength));
 							if (content_length && content_length->content() > (int)clt->max_body_size)
 							{
 								PrintDebugMessage("Exceed max body size", pfds[i].fd);
 								clt->exceed_max_body_size = true;
 								clt->status_code = k413;
 								clt->keepAlive = false;
-								process::ProcessRequest(clt);
-								pfds[i].events = POLLOUT;
+								if (!HandleRequest(worker, clients, sm, pfds, i))
+								{
+									client_count--;
+									i--;
+								}
 								continue;
 							}
 							if (content_length)
 								clt->content_length = content_length->content();
 						}
 						clt->continue_reading = false;
-						if (clt->content_length > clt->client_socket->req_buf.length())
+						std::string &req_buf = clt->client_socket->req_buf;
+						// a body received with the head is pinned in the request already
+						if (!clt->req.hasPinnedBody())
 						{
-							clt->continue_reading = true;
-							continue;
+							if (clt->content_length > req_buf.length())
+							{
+								clt->continue_reading = true;
+								continue;
+							}
+							if (clt->consume_body && req_buf.size() == clt->content_length)
+							{
+								// the receive buffer becomes the body, and the memory of the
+								// previous body becomes the receive buffer
+								clt->req.requestBody_.swap(req_buf);
+								req_buf.clear();
+							}
+							else
+							{
+								if (clt->consume_body)
+									clt->req.requestBody_.assign(req_buf, 0, clt->content_length);
+								req_buf.erase(0, clt->content_length);
+							}
 						}
-						if (clt->consume_body)
+						if (!HandleRequest(worker, clients, sm, pfds, i))
 						{
-							clt->req.requestBody_ = clt->client_socket->req_buf.substr(0, clt->content_length);
+							client_count--;
+							i--;
+							continue;
 						}
-						clt->client_socket->req_buf.erase(0, clt->content_length);
-						process::ProcessRequest(clt);
-						pfds[i].events = POLLOUT;
 					}
 				}
 				PrintDebugMessage("POLLIN request end", pfds[i].fd);
@@ -525,52 +1103,177 @@ int main(int argc, char **argv)
 				// send response to client
 				PrintDebugMessage("POLLOUT", pfds[i].fd);
 				PrintClients(clients);
-				if (!clt->client_socket->res_buf.empty())
+				if (!FlushResponse(clients, sm, pfds, i))
 				{
-					ssize_t sent_len = sm.send_to_client(pfds[i].fd);
-					if (sent_len <= 0)
-					{
-						PrintDebugMessage("POLLOUT send() error (removed from pdfs)", pfds[i].fd);
-						close(pfds[i].fd);
-						DeleteClient(clients, sm, pfds[i].fd);
-						pollfds::DeleteClientFd(pfds, i);
-						PrintClients(clients);
-						client_count--;
-						i--;
-					}
-				}
-				else
-				{
-					// check if client is still alive
-					if (client_lifespan::IsClientAlive(clt) == false)
-					{
-						PrintDebugMessage("POLLOUT is not alive (removed from pdfs)", pfds[i].fd);
-						close(pfds[i].fd);
-						DeleteClient(clients, sm, pfds[i].fd);
-						pollfds::DeleteClientFd(pfds, i);
-						PrintClients(clients);
-						client_count--;
-						i--;
-					}
-					else
-					{
-						// all bytes are sent, and client is still alive
-						pfds[i].events = POLLIN;
-						sm.set_time_assets(pfds[i].fd);
-						client_lifespan::ResetClient(*clt);
-						PrintDebugMessage("Reset", pfds[i].fd);
-						PrintClients(clients);
-					}
-
+					client_count--;
+					i--;
 				}
 			}
 		}
 	}
 	// cleanup: close all client sockets, clean vector of pollfds
-	for (unsigned long i = server_socket_count; i < pfds.size(); i++)
+	if (!clients.empty())
+		std::cout << "closing " << clients.size() << " unfinished connections" << std::endl;
+	for (unsigned long i = SERVER_PFDS_BEGIN + server_socket_count; i < pfds.size(); i++)
+	{
+		event_poller->close(pfds[i].fd);
+	}
+	for (std::vector<struct Client>::iterator it = clients.begin(); it != clients.end(); it++)
+	{
+		if (it->task)
+			it->task->cancelled = true;
+		client_lifespan::ReleaseConfiguration(*it);
+	}
+	// the pool pushes the unfinished tasks to the completion queue of this worker
+	while (worker.pending_tasks > 0)
 	{
-		close(pfds[i].fd);
+		struct pollfd pfd;
+		pfd.fd = worker.completions.fd();
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		poll(&pfd, 1, -1);
+		Task *task = worker.completions.pop_all();
+		while (task != NULL)
+		{
+			Task *next = task->next_completed;
+			delete task;
+			task = next;
+			worker.pending_tasks--;
+		}
+	}
+	worker.completions.close();
+	database->release();
+	event_poller = NULL;
+	return (err);
+}
+
+void *RunWorker(void *arg)
+{
+	struct Worker *worker = static_cast<struct Worker *>(arg);
+	Configuration *database = AcquireConfiguration();
+	SocketManager sm(database->worker_connections());
+	database->release();
+	pthread_mutex_lock(&listeners_lock);
+	std::vector<struct ServerSocket> servers = listeners;
+	worker->generation = listeners_generation;
+	pthread_mutex_unlock(&listeners_lock);
+	sm.share_servers(servers);
+	worker->result = EventLoop(*worker, sm, NULL);
+	__sync_sub_and_fetch(&workers_running, 1);
+	// worker 0 waits for the other workers before it stops
+	ssize_t written = write(signal_pipe[1], "", 1);
+	(void)written;
+	return (NULL);
+}
+
+// Worker 0 is the main thread. The other workers block the signals, so that the signal
+// handler always runs in the main thread.
+void StartWorkers(size_t count, const SocketManager &sm)
+{
+	PublishServers(sm);
+	workers.resize(count);
+	workers[0].id = 0;
+	workers[0].wake_pipe[0] = signal_pipe[0];
+	workers[0].wake_pipe[1] = signal_pipe[1];
+	workers[0].generation = listeners_generation;
+	workers[0].result = kNoError;
+
+	sigset_t signals;
+	sigset_t previous;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGHUP);
+	sigaddset(&signals, SIGUSR2);
+	pthread_sigmask(SIG_BLOCK, &signals, &previous);
+	for (size_t i = 1; i < count; i++)
+	{
+		workers[i].id = i;
+		workers[i].generation = 0;
+		workers[i].result = kNoError;
+		if (!OpenWakePipe(workers[i].wake_pipe))
+		{
+			workers.resize(i);
+			break;
+		}
+		__sync_add_and_fetch(&workers_running, 1);
+		int error = pthread_create(&workers[i].thread, NULL, RunWorker, &workers[i]);
+		if (error != 0)
+		{
+			std::cerr << "pthread_create: " << strerror(error) << std::endl;
+			__sync_sub_and_fetch(&workers_running, 1);
+			close(workers[i].wake_pipe[0]);
+			close(workers[i].wake_pipe[1]);
+			workers.resize(i);
+			break;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	if (count > 1)
+		std::cout << "worker threads: " << workers.size() << std::endl;
+}
+
+enum SocketError StopWorkers(enum SocketError err)
+{
+	for (size_t i = 1; i < workers.size(); i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		close(workers[i].wake_pipe[0]);
+		close(workers[i].wake_pipe[1]);
+		if (err == kNoError)
+			err = workers[i].result;
+	}
+	workers.clear();
+	return (err);
+}
+
+// to size the blocks of the arena from the requests the server has seen
+void	PrintArenaStatistics(const char *name, const ArenaStatistics &statistics)
+{
+	std::cout << name << ": " << statistics.high_water << " bytes high water, "
+		<< statistics.chain_high_water << " blocks chained at most, "
+		<< statistics.block_allocations << " blocks allocated ("
+		<< statistics.huge_block_allocations << " with huge pages)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 2)
+	{
+		std::cout << "Usage: " << argv[0] << " configuration_file" << std::endl;
+		return (1);
+	}
+	else if (!SetupSignals())
+		return (1);
+	executable_path = ResolveExecutablePath(argv[0]);
+	Configuration *database = LoadConfiguration(argv[1]);
+	if (database == NULL)
+		return (1);
+	ReplaceConfiguration(database);
+
+	SocketManager sm(ws_database->worker_connections());
+	sm.inherit_servers(InheritedListenFds());
+	enum SocketError err = sm.set_servers(ws_database->all_server_sockets(), *ws_database);
+	if (err != kNoError)
+	{
+		ReplaceConfiguration(NULL);
+		return (err);
 	}
+	if (ws_database->aio_threads() > 0 && disk_pool.start(ws_database->aio_threads()))
+		std::cout << "aio threads: " << ws_database->aio_threads() << std::endl;
+	if (ws_database->cpu_threads() > 0 && cpu_pool.start(ws_database->cpu_threads()))
+		std::cout << "cpu threads: " << ws_database->cpu_threads() << std::endl;
+	StartWorkers(ws_database->worker_threads(), sm);
+	err = EventLoop(workers[0], sm, argv);
+	err = StopWorkers(err);
+	disk_pool.stop();
+	if (cpu_pool.running())
+		std::cout << "cpu threads: " << cpu_pool.stolen() << " tasks stolen" << std::endl;
+	cpu_pool.stop();
+	PrintArenaStatistics("temporary arena", temporary::arena.statistics());
+	close(signal_pipe[0]);
+	close(signal_pipe[1]);
+	ReplaceConfiguration(NULL);
 	std::cout << "server stopped" << std::endl;
 	return (err);
 }
@@ -0,0 +1,40 @@
+#include "StringView.hpp"
+
+#include <cstring>
+
+StringView::StringView() : bytes(NULL), length(0) {}
+
+StringView::StringView(const char *bytes, size_t length)
+  : bytes(bytes), length(length) {}
+
+StringView::StringView(const char *string)
+  : bytes(string), length(std::strlen(string)) {}
+
+StringView::StringView(const std::string &string)
+  : bytes(string.data()), length(string.size()) {}
+
+bool  StringView::empty() const
+{
+  return length == 0;
+}
+
+std::string StringView::str() const
+{
+  return length ? std::string(bytes, length) : std::string();
+}
+
+void  StringView::append_to(std::string &output) const
+{
+  if (length)
+    output.append(bytes, length);
+}
+
+bool  StringView::operator==(const StringView &other) const
+{
+  return length == other.length && (length == 0 || std::memcmp(bytes, other.bytes, length) == 0);
+}
+
+bool  StringView::operator!=(const StringView &other) const
+{
+  return !(*this == other);
+}
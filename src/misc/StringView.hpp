@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Bytes owned by someone else
+ *
+ * A request refers to the buffer it was received in with views, which do not
+ * outlive the bytes they look at. str() copies the bytes out of the buffer.
+*/
+struct StringView
+{
+  const char  *bytes;
+  size_t      length;
+
+  StringView();
+  StringView(const char *bytes, size_t length);
+  StringView(const char *string);
+  StringView(const std::string &string);
+
+  bool        empty() const;
+  std::string str() const;
+  void        append_to(std::string &output) const;
+
+  bool  operator==(const StringView &other) const;
+  bool  operator!=(const StringView &other) const;
+};
@@ -0,0 +1,36 @@
+#include "BufferPool.hpp"
+
+BufferPool::BufferPool(size_t buffer_size, size_t max_free)
+	: buffer_size_(buffer_size), max_free_(max_free)
+{
+	free_.reserve(max_free);
+}
+
+BufferPool::~BufferPool()
+{
+	std::vector<char *>::iterator it;
+	for (it = free_.begin(); it != free_.end(); it++)
+		delete[] *it;
+}
+
+char *BufferPool::acquire()
+{
+	if (free_.empty())
+		return (new char[buffer_size_]);
+	char *buffer = free_.back();
+	free_.pop_back();
+	return (buffer);
+}
+
+void BufferPool::release(char *buffer)
+{
+	if (free_.size() < max_free_)
+		free_.push_back(buffer);
+	else
+		delete[] buffer;
+}
+
+size_t BufferPool::buffer_size() const
+{
+	return (buffer_size_);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//Fixed size I/O buffers lent to a socket only while it reads.
+//Connections do not own a read buffer, so an idle keep-alive connection costs no buffer memory.
+//Released buffers are kept for reuse, at most max_free of them.
+class BufferPool
+{
+	public:
+		BufferPool(size_t buffer_size, size_t max_free);
+		~BufferPool();
+
+		char *acquire();
+		void release(char *buffer);
+
+		size_t buffer_size() const;
+
+	private:
+		size_t buffer_size_;
+		size_t max_free_;
+		std::vector<char *> free_;
+
+		BufferPool(const BufferPool &src);
+		BufferPool &operator=(const BufferPool &src);
+};
@@ -0,0 +1,261 @@
+#include "EventPoller.hpp"
+#include "IoUring.hpp"
+
+#include <unistd.h>
+#include <string.h>
+#include <cerrno>
+#include <iostream>
+#ifdef __linux__
+# include <sys/epoll.h>
+#endif
+
+#define EPOLL_MAX_EVENTS 256 //events returned by one epoll_wait()
+
+EventPoller::EventPoller() : method_(kPoll), epoll_fd_(-1), uring_(NULL) {}
+
+EventPoller::~EventPoller()
+{
+	if (epoll_fd_ != -1)
+		::close(epoll_fd_);
+	delete uring_;
+}
+
+enum EventPoller::Method EventPoller::open(const std::string &method)
+{
+	method_ = kPoll;
+	if (method == "io_uring")
+	{
+		uring_ = new IoUring();
+		if (uring_->open())
+		{
+			method_ = kIoUring;
+			return (method_);
+		}
+		std::cerr << "io_uring: " << strerror(errno) << ", falling back to epoll" << std::endl;
+		delete uring_;
+		uring_ = NULL;
+	}
+#ifdef __linux__
+	if (method == "epoll" || method == "io_uring")
+	{
+		epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+		if (epoll_fd_ != -1)
+			method_ = kEpoll;
+		else
+			std::cerr << "epoll_create1: " << strerror(errno) << ", falling back to poll" << std::endl;
+	}
+#else
+	if (method == "epoll" || method == "io_uring")
+		std::cerr << "epoll is not available on this system, falling back to poll" << std::endl;
+#endif
+	return (method_);
+}
+
+const char *EventPoller::name() const
+{
+	if (method_ == kIoUring)
+		return ("io_uring");
+	return (method_ == kEpoll ? "epoll" : "poll");
+}
+
+bool EventPoller::completes_io() const
+{
+	return (method_ == kIoUring);
+}
+
+int EventPoller::wait(std::vector<struct pollfd> &pfds, int timeout)
+{
+	if (method_ == kPoll)
+		return (poll(pfds.data(), pfds.size(), timeout));
+	clear_reported(pfds);
+	for (std::vector<int>::iterator it = failed_.begin(); it != failed_.end(); it++)
+		report(pfds, *it, POLLERR);
+	failed_.clear();
+	if (method_ == kIoUring)
+		return (wait_uring(pfds, timeout));
+	return (wait_epoll(pfds, timeout));
+}
+
+// pfds[i] has just been added, the main loop may set its revents before the next wait
+void EventPoller::watch(std::vector<struct pollfd> &pfds, size_t i, enum Kind kind)
+{
+	int fd = pfds[i].fd;
+	pfds[i].revents = 0;
+	if (method_ == kPoll)
+		return ;
+	if (static_cast<size_t>(fd) >= index_.size())
+	{
+		registered_.resize(fd + 1, NOT_REGISTERED);
+		index_.resize(fd + 1, -1);
+	}
+	index_[fd] = i;
+	reported_.push_back(fd);
+	if (method_ == kIoUring)
+		uring_->watch(fd, kind, pfds[i].events);
+	else if (!update_interest(fd, pfds[i].events))
+		failed_.push_back(fd);
+}
+
+// events is 0 while the response of a client is built in a pool thread
+void EventPoller::modify(struct pollfd &pfd, short events)
+{
+	if (pfd.events == events)
+		return ;
+	pfd.events = events;
+	if (method_ == kIoUring)
+		uring_->modify(pfd.fd, events);
+	else if (method_ == kEpoll && !update_interest(pfd.fd, events))
+		failed_.push_back(pfd.fd);
+}
+
+void EventPoller::moved(const std::vector<struct pollfd> &pfds, size_t from)
+{
+	if (method_ == kPoll)
+		return ;
+	for (size_t i = from; i < pfds.size(); i++)
+		index_[pfds[i].fd] = i;
+}
+
+void EventPoller::remove(int fd)
+{
+	if (method_ == kPoll || fd < 0 || static_cast<size_t>(fd) >= index_.size())
+		return ;
+	index_[fd] = -1;
+	if (method_ == kIoUring)
+	{
+		uring_->remove(fd);
+		return ;
+	}
+#ifdef __linux__
+	if (registered_[fd] != NOT_REGISTERED)
+	{
+		// the fd may already be closed, then the kernel has removed it
+		epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, NULL);
+		registered_[fd] = NOT_REGISTERED;
+	}
+#endif
+}
+
+// io_uring closes the fd once the operations armed for it are finished
+void EventPoller::close(int fd)
+{
+	if (method_ != kIoUring)
+	{
+		remove(fd);
+		::close(fd);
+		return ;
+	}
+	if (fd >= 0 && static_cast<size_t>(fd) < index_.size())
+		index_[fd] = -1;
+	uring_->close(fd);
+}
+
+int EventPoller::accept(int server_fd, int budget, std::vector<int> &accepted)
+{
+	return (uring_->accept(server_fd, budget, accepted));
+}
+
+ssize_t EventPoller::receive(int fd, std::string &buffer)
+{
+	return (uring_->receive(fd, buffer));
+}
+
+int EventPoller::send(int fd, OutputQueue &output, bool nopush)
+{
+	return (uring_->send(fd, output, nopush));
+}
+
+// only the revents set by the last wait, or by the main loop after watch(), are cleared
+void EventPoller::clear_reported(std::vector<struct pollfd> &pfds)
+{
+	for (std::vector<int>::iterator it = reported_.begin(); it != reported_.end(); it++)
+	{
+		if (index_[*it] != -1)
+			pfds[index_[*it]].revents = 0;
+	}
+	reported_.clear();
+}
+
+void EventPoller::report(std::vector<struct pollfd> &pfds, int fd, short revents)
+{
+	if (static_cast<size_t>(fd) >= index_.size() || index_[fd] == -1)
+		return ;
+	pfds[index_[fd]].revents |= revents;
+	reported_.push_back(fd);
+}
+
+int EventPoller::wait_uring(std::vector<struct pollfd> &pfds, int timeout)
+{
+	int ready = uring_->wait(ready_, timeout);
+	if (ready == -1)
+		return (-1);
+	for (std::vector<struct pollfd>::iterator it = ready_.begin(); it != ready_.end(); it++)
+		report(pfds, it->fd, it->revents);
+	return (ready);
+}
+
+#ifdef __linux__
+
+bool EventPoller::update_interest(int fd, short events)
+{
+	struct epoll_event event;
+
+	memset(&event, 0, sizeof(event));
+	if (events & POLLIN)
+		event.events |= EPOLLIN;
+	if (events & POLLOUT)
+		event.events |= EPOLLOUT;
+	event.data.fd = fd;
+	int op = registered_[fd] == NOT_REGISTERED ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+	if (epoll_ctl(epoll_fd_, op, fd, &event) == -1)
+	{
+		// the interest list and registered_ disagree, retry with the other operation
+		op = op == EPOLL_CTL_ADD ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+		if (epoll_ctl(epoll_fd_, op, fd, &event) == -1)
+		{
+			std::cerr << "epoll_ctl: " << strerror(errno) << std::endl;
+			return (false);
+		}
+	}
+	registered_[fd] = events;
+	return (true);
+}
+
+int EventPoller::wait_epoll(std::vector<struct pollfd> &pfds, int timeout)
+{
+	struct epoll_event events[EPOLL_MAX_EVENTS];
+
+	int ready = epoll_wait(epoll_fd_, events, EPOLL_MAX_EVENTS, timeout);
+	if (ready == -1)
+		return (-1);
+	for (int n = 0; n < ready; n++)
+	{
+		short revents = 0;
+		if (events[n].events & EPOLLIN)
+			revents |= POLLIN;
+		if (events[n].events & EPOLLOUT)
+			revents |= POLLOUT;
+		if (events[n].events & EPOLLERR)
+			revents |= POLLERR;
+		if (events[n].events & EPOLLHUP)
+			revents |= POLLHUP;
+		report(pfds, events[n].data.fd, revents);
+	}
+	return (ready);
+}
+
+#else
+
+bool EventPoller::update_interest(int fd, short events)
+{
+	(void)fd;
+	(void)events;
+	return (false);
+}
+
+int EventPoller::wait_epoll(std::vector<struct pollfd> &pfds, int timeout)
+{
+	return (poll(pfds.data(), pfds.size(), timeout));
+}
+
+#endif
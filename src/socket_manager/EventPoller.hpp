@@ -0,0 +1,83 @@
+#pragma once
+
+#include <poll.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "OutputQueue.hpp"
+
+#define NOT_REGISTERED -1 //registered_ value of an fd that is not in the epoll interest list
+
+class IoUring;
+
+//Waits for the events requested in the pollfd vector of the main loop and fills in revents.
+//The main loop keeps working with pollfds and tells the poller about every change: an fd that
+//joins the vector with watch(), new events with modify(), entries that moved in the vector
+//with moved(), and an fd that leaves it with remove() or close(). With epoll and io_uring only
+//these changes reach the kernel, the vector is not scanned by wait().
+//
+//With io_uring the kernel also does the I/O of the sockets (completes_io()): listening sockets
+//accept with a multishot accept, connections receive into buffers provided to the ring and send
+//their output queue as a linked chain that reads the files of the queue on the way. The main
+//loop takes the results with accept(), receive() and send() instead of calling the socket
+//functions itself.
+class EventPoller
+{
+	public:
+		enum Method
+		{
+			kPoll,
+			kEpoll,
+			kIoUring
+		};
+		enum Kind
+		{
+			kListen, //listening socket
+			kConnection, //client socket
+			kNotify //pipe or eventfd that the main loop reads itself
+		};
+
+		EventPoller();
+		~EventPoller();
+
+		//select the method by its name in the use directive, io_uring falls back to epoll and
+		//epoll to poll when the kernel does not support them
+		enum Method open(const std::string &method);
+		const char *name() const;
+		bool completes_io() const;
+
+		int wait(std::vector<struct pollfd> &pfds, int timeout);
+
+		//interest changes of the pollfd vector
+		void watch(std::vector<struct pollfd> &pfds, size_t i, enum Kind kind);
+		void modify(struct pollfd &pfd, short events);
+		void moved(const std::vector<struct pollfd> &pfds, size_t from); //entries from index from have moved
+		void remove(int fd); //the fd is closed by the caller
+		void close(int fd); //remove and close the fd
+
+		//I/O done by io_uring, only when completes_io()
+		int accept(int server_fd, int budget, std::vector<int> &accepted);
+		ssize_t receive(int fd, std::string &buffer); //like read(): bytes appended, 0 at the end, -1 and errno
+		int send(int fd, OutputQueue &output, bool nopush); //-1 and errno, 1 while sending, 0 when done
+
+	private:
+		enum Method method_;
+		int epoll_fd_;
+		IoUring *uring_;
+		std::vector<short> registered_; //events in the epoll interest list, indexed by fd
+		std::vector<int> index_; //position in pfds, indexed by fd
+		std::vector<int> reported_; //fds whose revents were set by the last wait
+		std::vector<int> failed_; //fds whose interest could not be updated, reported with POLLERR
+		std::vector<struct pollfd> ready_; //events returned by io_uring
+
+		void clear_reported(std::vector<struct pollfd> &pfds);
+		void report(std::vector<struct pollfd> &pfds, int fd, short revents);
+		int wait_epoll(std::vector<struct pollfd> &pfds, int timeout);
+		int wait_uring(std::vector<struct pollfd> &pfds, int timeout);
+		bool update_interest(int fd, short events);
+
+		EventPoller(const EventPoller &src);
+		EventPoller &operator=(const EventPoller &src);
+};
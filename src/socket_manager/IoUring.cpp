@@ -0,0 +1,935 @@
+#include "IoUring.hpp"
+#include "SocketManager.hpp"
+
+#include <unistd.h>
+#include <cerrno>
+
+#ifdef IO_URING_AVAILABLE
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <endian.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+
+#define URING_BUFFER_GROUP 0 //group of the provided receive buffers
+#define URING_CLOSE_WAIT 100 //milliseconds waited for the cancelled operations, at most 10 times, when the ring is closed
+
+namespace
+{
+	enum OperationType
+	{
+		kAcceptOperation,
+		kPollOperation,
+		kRecvOperation,
+		kReadOperation,
+		kSendOperation,
+		kWritableOperation //poll for POLLOUT at the start of a chain
+	};
+
+	// operations used by the backend, the kernel of a ring with provided buffer rings may still
+	// be built without some of them
+	const unsigned char kRequiredOperations[] = {IORING_OP_ACCEPT, IORING_OP_POLL_ADD, IORING_OP_RECV,
+		IORING_OP_READ, IORING_OP_SENDMSG, IORING_OP_ASYNC_CANCEL};
+
+	int Setup(unsigned entries, struct io_uring_params *params)
+	{
+		return (syscall(SYS_io_uring_setup, entries, params));
+	}
+
+	int Enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t size)
+	{
+		return (syscall(SYS_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, size));
+	}
+
+	int Register(int ring_fd, unsigned opcode, void *arg, unsigned count)
+	{
+		return (syscall(SYS_io_uring_register, ring_fd, opcode, arg, count));
+	}
+
+	// the heads and tails of the rings are shared with the kernel
+	unsigned LoadShared(const unsigned *value)
+	{
+		unsigned loaded = *const_cast<const volatile unsigned *>(value);
+		__sync_synchronize();
+		return (loaded);
+	}
+
+	void StoreShared(unsigned *value, unsigned stored)
+	{
+		__sync_synchronize();
+		*const_cast<volatile unsigned *>(value) = stored;
+	}
+
+	__u64 UserData(const void *pointer)
+	{
+		return (reinterpret_cast<uintptr_t>(pointer));
+	}
+
+	// poll32_events holds the events in the byte order of the kernel poll ABI
+	__u32 PollEvents(unsigned events)
+	{
+#if __BYTE_ORDER == __BIG_ENDIAN
+		events = (events << 16) | (events >> 16);
+#endif
+		return (events);
+	}
+}
+
+struct IoUring::Operation
+{
+	Slot *slot;
+	int type;
+	size_t length; //bytes the operation has to transfer
+	int file_fd; //read operations
+	off_t file_offset;
+	struct msghdr msg; //send operations
+	struct iovec iov[SEND_IOV_MAX];
+};
+
+struct IoUring::Slot
+{
+	int fd;
+	enum EventPoller::Kind kind;
+	short events;
+	bool touched; //in touched_
+	bool closing; //removed from the pollfd vector, freed after the last completion
+	bool owns_fd; //closed by the backend, after the last completion
+	int in_flight; //operations that will still complete
+	Operation input; //accept, poll or recv
+	bool input_armed;
+	//listening socket
+	std::deque<int> accepted;
+	bool accept_stopping; //the multishot accept is cancelled, URING_ACCEPT_QUEUE connections wait
+	//pipe or eventfd
+	bool notified;
+	//connection
+	bool received; //result of the last recv, held for receive()
+	int recv_result;
+	int recv_buffer; //provided buffer of the result, -1 for own_buffer
+	bool no_buffers; //the provided buffers ran out, the next recv reads into own_buffer
+	char *own_buffer;
+	OutputQueue output; //output of the running send chain
+	bool nopush;
+	int chain_pending; //operations of the send chain that have not completed
+	bool send_blocked; //a send of the chain found the socket buffer full, the next chain waits for POLLOUT
+	int send_error;
+	std::vector<Operation *> chain;
+	std::vector<char *> file_chunks;
+
+	Slot(int fd, enum EventPoller::Kind kind, short events)
+	: fd(fd), kind(kind), events(events), touched(false), closing(false), owns_fd(false), in_flight(0),
+	input_armed(false), accept_stopping(false), notified(false), received(false), recv_result(0), recv_buffer(-1),
+	no_buffers(false), own_buffer(NULL), nopush(false), chain_pending(0), send_blocked(false), send_error(0)
+	{
+		input.slot = this;
+	}
+
+	~Slot()
+	{
+		for (std::deque<int>::iterator it = accepted.begin(); it != accepted.end(); it++)
+			::close(*it);
+		output.clear();
+		for (size_t i = 0; i < chain.size(); i++)
+			delete chain[i];
+		for (size_t i = 0; i < file_chunks.size(); i++)
+			delete[] file_chunks[i];
+		delete[] own_buffer;
+	}
+};
+
+IoUring::IoUring()
+: ring_fd_(-1), rings_(NULL), rings_size_(0), sqes_(NULL), sqes_size_(0), sq_head_(NULL), sq_tail_(NULL),
+sq_mask_(0), sq_entries_(0), cq_head_(NULL), cq_tail_(NULL), cq_mask_(0), cqes_(NULL), sq_local_tail_(0),
+buffer_ring_(NULL), recv_buffers_(NULL), buffer_tail_(0)
+{}
+
+IoUring::~IoUring()
+{
+	for (size_t fd = 0; fd < slots_.size(); fd++)
+	{
+		if (slots_[fd] != NULL)
+			remove(fd);
+	}
+	// the kernel may still write into the buffers of the cancelled operations
+	for (int tries = 0; ring_fd_ != -1 && !closing_.empty() && tries < 10; tries++)
+	{
+		if (submit(1, URING_CLOSE_WAIT) == -1 && errno != ETIME && errno != EINTR)
+			break;
+		reap();
+	}
+	if (ring_fd_ != -1)
+		::close(ring_fd_);
+	while (!closing_.empty())
+		release(closing_.back());
+	if (buffer_ring_ != NULL)
+		munmap(buffer_ring_, URING_RECV_BUFFERS * sizeof(struct io_uring_buf));
+	delete[] recv_buffers_;
+	if (sqes_ != NULL)
+		munmap(sqes_, sqes_size_);
+	if (rings_ != NULL)
+		munmap(rings_, rings_size_);
+}
+
+bool IoUring::open()
+{
+	return (setup_ring() && setup_buffers());
+}
+
+bool IoUring::setup_ring()
+{
+	struct io_uring_params params;
+
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+	params.cq_entries = URING_CQ_ENTRIES;
+	ring_fd_ = Setup(URING_SQ_ENTRIES, &params);
+	if (ring_fd_ == -1 && errno == EINVAL)
+	{
+		// SUBMIT_ALL and COOP_TASKRUN are only hints
+		memset(&params, 0, sizeof(params));
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = URING_CQ_ENTRIES;
+		ring_fd_ = Setup(URING_SQ_ENTRIES, &params);
+	}
+	if (ring_fd_ == -1)
+		return (false);
+	unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+	if ((params.features & required) != required)
+	{
+		errno = ENOSYS;
+		return (false);
+	}
+	rings_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+		params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+	rings_ = mmap(NULL, rings_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+	if (rings_ == MAP_FAILED)
+	{
+		rings_ = NULL;
+		return (false);
+	}
+	sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+	void *sqes = mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+		return (false);
+	sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+	char *rings = static_cast<char *>(rings_);
+	sq_head_ = reinterpret_cast<unsigned *>(rings + params.sq_off.head);
+	sq_tail_ = reinterpret_cast<unsigned *>(rings + params.sq_off.tail);
+	sq_mask_ = *reinterpret_cast<unsigned *>(rings + params.sq_off.ring_mask);
+	sq_entries_ = params.sq_entries;
+	unsigned *array = reinterpret_cast<unsigned *>(rings + params.sq_off.array);
+	for (unsigned i = 0; i < sq_entries_; i++)
+		array[i] = i;
+	sq_local_tail_ = *sq_tail_;
+	cq_head_ = reinterpret_cast<unsigned *>(rings + params.cq_off.head);
+	cq_tail_ = reinterpret_cast<unsigned *>(rings + params.cq_off.tail);
+	cq_mask_ = *reinterpret_cast<unsigned *>(rings + params.cq_off.ring_mask);
+	cqes_ = reinterpret_cast<struct io_uring_cqe *>(rings + params.cq_off.cqes);
+
+	size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+	struct io_uring_probe *probe = static_cast<struct io_uring_probe *>(calloc(1, probe_size));
+	if (probe == NULL)
+		return (false);
+	bool supported = (Register(ring_fd_, IORING_REGISTER_PROBE, probe, 256) == 0);
+	for (size_t i = 0; supported && i < sizeof(kRequiredOperations); i++)
+	{
+		unsigned char op = kRequiredOperations[i];
+		supported = (op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED));
+	}
+	free(probe);
+	if (!supported)
+		errno = ENOSYS;
+	return (supported);
+}
+
+// The receive buffers are lent to the kernel through a ring, a recv takes one when data arrives
+// instead of every waiting connection holding its own.
+bool IoUring::setup_buffers()
+{
+	void *ring = mmap(NULL, URING_RECV_BUFFERS * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ring == MAP_FAILED)
+		return (false);
+	buffer_ring_ = static_cast<struct io_uring_buf *>(ring);
+	struct io_uring_buf_reg registration;
+	memset(&registration, 0, sizeof(registration));
+	registration.ring_addr = UserData(ring);
+	registration.ring_entries = URING_RECV_BUFFERS;
+	registration.bgid = URING_BUFFER_GROUP;
+	if (Register(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+		return (false);
+	recv_buffers_ = new char[URING_RECV_BUFFERS * IO_BUFFER_SIZE];
+	for (int id = 0; id < URING_RECV_BUFFERS; id++)
+		recycle_buffer(id);
+	return (true);
+}
+
+// The ring is an array of io_uring_buf, the tail overlays the resv field of its first entry.
+// The bufs member of io_uring_buf_ring is not used, its empty struct has a size in C++.
+void IoUring::recycle_buffer(int id)
+{
+	struct io_uring_buf *buffer = &buffer_ring_[buffer_tail_ & (URING_RECV_BUFFERS - 1)];
+	buffer->addr = UserData(recv_buffers_ + id * IO_BUFFER_SIZE);
+	buffer->len = IO_BUFFER_SIZE;
+	buffer->bid = id;
+	buffer_tail_++;
+	__sync_synchronize();
+	*const_cast<volatile __u16 *>(&buffer_ring_[0].resv) = buffer_tail_;
+}
+
+// make room for count entries, a linked chain is never split across two submissions
+void IoUring::reserve(unsigned count)
+{
+	while (sq_local_tail_ - LoadShared(sq_head_) + count > sq_entries_)
+	{
+		// EBUSY: the completion queue overflowed, it has to be reaped first
+		if (submit(0, 0) == -1 && errno == EBUSY)
+			reap();
+	}
+}
+
+struct io_uring_sqe *IoUring::get_sqe()
+{
+	reserve(1);
+	struct io_uring_sqe *sqe = &sqes_[sq_local_tail_ & sq_mask_];
+	memset(sqe, 0, sizeof(*sqe));
+	sq_local_tail_++;
+	return (sqe);
+}
+
+// Pass the new entries to the kernel and wait for min_complete completions, at most timeout
+// milliseconds (-1 without a limit). The pending task work of the ring runs in any case.
+int IoUring::submit(unsigned min_complete, int timeout)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+
+	StoreShared(sq_tail_, sq_local_tail_);
+	unsigned to_submit = sq_local_tail_ - LoadShared(sq_head_);
+	memset(&arg, 0, sizeof(arg));
+	arg.sigmask_sz = _NSIG / 8;
+	if (timeout >= 0)
+	{
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000L;
+		arg.ts = UserData(&ts);
+	}
+	return (Enter(ring_fd_, to_submit, min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+}
+
+// The head is moved past each completion before it is handled, a handler that needs a
+// submission entry may reap again while the queue is full.
+void IoUring::reap()
+{
+	while (true)
+	{
+		unsigned head = *cq_head_;
+		if (head == LoadShared(cq_tail_))
+			break;
+		struct io_uring_cqe cqe = cqes_[head & cq_mask_];
+		StoreShared(cq_head_, head + 1);
+		// cancellations have no user data
+		if (cqe.user_data != 0)
+			complete(reinterpret_cast<Operation *>(static_cast<uintptr_t>(cqe.user_data)), cqe.res, cqe.flags);
+	}
+}
+
+int IoUring::wait(std::vector<struct pollfd> &ready, int timeout)
+{
+	ready.clear();
+	if (submit(0, 0) == -1 && errno != EINTR && errno != EBUSY)
+		return (-1);
+	reap();
+	collect(ready);
+	if (ready.empty())
+	{
+		if (submit(1, timeout) == -1 && errno != ETIME && errno != EBUSY)
+			return (-1);
+		reap();
+		collect(ready);
+	}
+	return (ready.size());
+}
+
+// The reported slots are looked at again in the next wait, like poll reports them until
+// their state changes.
+void IoUring::collect(std::vector<struct pollfd> &ready)
+{
+	std::vector<int> touched;
+	touched.swap(touched_);
+	for (std::vector<int>::iterator it = touched.begin(); it != touched.end(); it++)
+	{
+		Slot *slot = live_slot(*it);
+		if (slot == NULL || !slot->touched)
+			continue;
+		slot->touched = false;
+		short events = revents(slot);
+		if (events == 0)
+			continue;
+		struct pollfd pfd;
+		pfd.fd = slot->fd;
+		pfd.events = slot->events;
+		pfd.revents = events;
+		ready.push_back(pfd);
+		if (slot->kind == EventPoller::kNotify)
+			slot->notified = false;
+		touch(slot);
+	}
+}
+
+short IoUring::revents(Slot *slot) const
+{
+	short events = 0;
+	if (slot->kind == EventPoller::kListen && !slot->accepted.empty())
+		events = POLLIN;
+	else if (slot->kind == EventPoller::kNotify && slot->notified)
+		events = POLLIN;
+	else if (slot->kind == EventPoller::kConnection)
+	{
+		if (slot->received)
+			events |= POLLIN;
+		if (slot->chain_pending == 0)
+			events |= POLLOUT;
+	}
+	return (events & slot->events);
+}
+
+void IoUring::touch(Slot *slot)
+{
+	if (slot->touched)
+		return ;
+	slot->touched = true;
+	touched_.push_back(slot->fd);
+}
+
+IoUring::Slot *IoUring::live_slot(int fd) const
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= slots_.size())
+		return (NULL);
+	return (slots_[fd]);
+}
+
+void IoUring::watch(int fd, enum EventPoller::Kind kind, short events)
+{
+	if (static_cast<size_t>(fd) >= slots_.size())
+		slots_.resize(fd + 1, NULL);
+	if (slots_[fd] != NULL)
+		remove(fd);
+	Slot *slot = new Slot(fd, kind, events);
+	slots_[fd] = slot;
+	if (kind == EventPoller::kListen)
+		arm_accept(slot);
+	else if (kind == EventPoller::kNotify)
+		arm_poll(slot);
+	else if (events & POLLIN)
+		arm_recv(slot);
+}
+
+void IoUring::modify(int fd, short events)
+{
+	Slot *slot = live_slot(fd);
+	if (slot == NULL)
+		return ;
+	slot->events = events;
+	if (slot->kind == EventPoller::kConnection && (events & POLLIN) && !slot->input_armed && !slot->received)
+		arm_recv(slot);
+	touch(slot);
+}
+
+// The operations of the fd are cancelled. A listening socket stops accepting right away, the
+// connections it still accepts go to the next slot of the same socket after a reload, or are closed.
+void IoUring::remove(int fd)
+{
+	Slot *slot = live_slot(fd);
+	if (slot == NULL)
+		return ;
+	slots_[fd] = NULL;
+	slot->closing = true;
+	if (slot->in_flight == 0)
+	{
+		release(slot);
+		return ;
+	}
+	closing_.push_back(slot);
+	cancel_all(slot);
+	submit(0, 0);
+}
+
+void IoUring::close(int fd)
+{
+	Slot *slot = live_slot(fd);
+	if (slot == NULL)
+	{
+		::close(fd);
+		return ;
+	}
+	slot->owns_fd = true;
+	// a send waiting for the peer returns at once
+	if (slot->in_flight > 0)
+		shutdown(fd, SHUT_RDWR);
+	remove(fd);
+}
+
+void IoUring::release(Slot *slot)
+{
+	std::vector<Slot *>::iterator it = std::find(closing_.begin(), closing_.end(), slot);
+	if (it != closing_.end())
+		closing_.erase(it);
+	if (slot->owns_fd)
+		::close(slot->fd);
+	delete slot;
+}
+
+// by user data, the fd of a listening socket is often closed already
+void IoUring::cancel(Operation *operation)
+{
+	struct io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->addr = UserData(operation);
+}
+
+void IoUring::cancel_all(Slot *slot)
+{
+	if (slot->input_armed)
+		cancel(&slot->input);
+	if (slot->chain_pending > 0)
+	{
+		for (size_t i = 0; i < slot->chain.size(); i++)
+			cancel(slot->chain[i]);
+	}
+}
+
+void IoUring::arm_accept(Slot *slot)
+{
+	struct io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = slot->fd;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data = UserData(&slot->input);
+	slot->input.type = kAcceptOperation;
+	slot->input_armed = true;
+	slot->accept_stopping = false;
+	slot->in_flight++;
+}
+
+void IoUring::arm_poll(Slot *slot)
+{
+	struct io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = slot->fd;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->poll32_events = PollEvents(POLLIN);
+	sqe->user_data = UserData(&slot->input);
+	slot->input.type = kPollOperation;
+	slot->input_armed = true;
+	slot->in_flight++;
+}
+
+void IoUring::arm_recv(Slot *slot)
+{
+	struct io_uring_sqe *sqe = get_sqe();
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = slot->fd;
+	sqe->len = IO_BUFFER_SIZE;
+	if (slot->no_buffers)
+	{
+		if (slot->own_buffer == NULL)
+			slot->own_buffer = new char[IO_BUFFER_SIZE];
+		sqe->addr = UserData(slot->own_buffer);
+		slot->no_buffers = false;
+	}
+	else
+	{
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = URING_BUFFER_GROUP;
+	}
+	sqe->user_data = UserData(&slot->input);
+	slot->input.type = kRecvOperation;
+	slot->input_armed = true;
+	slot->in_flight++;
+}
+
+void IoUring::complete(Operation *operation, int result, unsigned flags)
+{
+	Slot *slot = operation->slot;
+	switch (operation->type)
+	{
+		case kAcceptOperation:
+			complete_accept(slot, result, flags);
+			break;
+		case kPollOperation:
+			if (!(flags & IORING_CQE_F_MORE))
+			{
+				slot->input_armed = false;
+				slot->in_flight--;
+			}
+			if (result >= 0)
+				slot->notified = true;
+			else if (result != -ECANCELED)
+				std::cerr << "io_uring poll: " << strerror(-result) << std::endl;
+			if (!slot->input_armed && !slot->closing)
+				arm_poll(slot);
+			break;
+		case kRecvOperation:
+			complete_recv(slot, result, flags);
+			break;
+		default:
+			complete_chain(operation, result);
+			break;
+	}
+	if (slot->closing && slot->in_flight == 0)
+		release(slot);
+	else if (!slot->closing)
+		touch(slot);
+}
+
+void IoUring::complete_accept(Slot *slot, int result, unsigned flags)
+{
+	if (!(flags & IORING_CQE_F_MORE))
+	{
+		slot->input_armed = false;
+		slot->in_flight--;
+	}
+	if (result >= 0)
+	{
+		Slot *target = slot;
+		if (slot->closing)
+		{
+			target = live_slot(slot->fd);
+			if (target != NULL && target->kind != EventPoller::kListen)
+				target = NULL;
+		}
+		if (target == NULL)
+			::close(result);
+		else
+		{
+			target->accepted.push_back(result);
+			touch(target);
+		}
+	}
+	else if (result != -ECANCELED)
+		std::cerr << "accept: " << strerror(-result) << std::endl;
+	if (slot->closing)
+		return ;
+	if (!slot->input_armed && slot->accepted.size() < URING_ACCEPT_QUEUE)
+		arm_accept(slot);
+	else if (slot->input_armed && !slot->accept_stopping && slot->accepted.size() >= URING_ACCEPT_QUEUE)
+	{
+		// the connections wait in the kernel accept queue until accept() takes these
+		cancel(&slot->input);
+		slot->accept_stopping = true;
+	}
+}
+
+int IoUring::accept(int fd, int budget, std::vector<int> &accepted)
+{
+	accepted.clear();
+	Slot *slot = live_slot(fd);
+	if (slot == NULL)
+		return (0);
+	while (static_cast<int>(accepted.size()) < budget && !slot->accepted.empty())
+	{
+		accepted.push_back(slot->accepted.front());
+		slot->accepted.pop_front();
+	}
+	if (!slot->input_armed && slot->accepted.size() < URING_ACCEPT_QUEUE)
+		arm_accept(slot);
+	return (accepted.size());
+}
+
+void IoUring::complete_recv(Slot *slot, int result, unsigned flags)
+{
+	slot->input_armed = false;
+	slot->in_flight--;
+	int buffer = (flags & IORING_CQE_F_BUFFER) ? static_cast<int>(flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+	if (slot->closing || result == -ECANCELED)
+	{
+		if (buffer != -1)
+			recycle_buffer(buffer);
+		return ;
+	}
+	// EAGAIN only if the recv ran in a worker thread of the kernel on the non-blocking socket
+	if (result == -ENOBUFS || result == -EAGAIN)
+	{
+		slot->no_buffers = true;
+		arm_recv(slot);
+		return ;
+	}
+	slot->received = true;
+	slot->recv_result = result;
+	slot->recv_buffer = buffer;
+}
+
+// the result of the last recv, a new one is armed while the pollfd asks for POLLIN
+ssize_t IoUring::receive(int fd, std::string &buffer)
+{
+	Slot *slot = live_slot(fd);
+	if (slot == NULL || !slot->received)
+	{
+		if (slot != NULL && !slot->input_armed && (slot->events & POLLIN))
+			arm_recv(slot);
+		errno = EAGAIN;
+		return (-1);
+	}
+	// the end of the stream and errors are kept until the connection is closed
+	if (slot->recv_result <= 0)
+	{
+		if (slot->recv_result == 0)
+		{
+			std::cout << "recv: client disconnected" << std::endl;
+			return (0);
+		}
+		errno = -slot->recv_result;
+		std::cerr << "recv: " << strerror(errno) << std::endl;
+		return (-1);
+	}
+	ssize_t length = slot->recv_result;
+	if (slot->recv_buffer == -1)
+		buffer.append(slot->own_buffer, length);
+	else
+	{
+		buffer.append(recv_buffers_ + slot->recv_buffer * IO_BUFFER_SIZE, length);
+		recycle_buffer(slot->recv_buffer);
+	}
+	slot->received = false;
+	if (slot->events & POLLIN)
+		arm_recv(slot);
+	return (length);
+}
+
+// Takes the content of output and sends it with linked operations. Returns 1 while they run,
+// 0 once everything is sent, -1 with errno when the connection failed.
+int IoUring::send(int fd, OutputQueue &output, bool nopush)
+{
+	Slot *slot = live_slot(fd);
+	if (slot->chain_pending > 0)
+		return (1);
+	if (slot->send_error != 0)
+	{
+		errno = slot->send_error;
+		std::cerr << "send: " << strerror(errno) << std::endl;
+		slot->send_error = 0;
+		slot->output.clear();
+		return (-1);
+	}
+	if (output.empty())
+		return (0);
+	slot->output.swap(output);
+	slot->nopush = nopush;
+	start_chain(slot);
+	return (1);
+}
+
+// One chain sends what is left of the output queue: a sendmsg for each run of memory segments,
+// a read into a chunk buffer and a send of the chunk for the files. Every send asks for all of
+// its bytes, a short one breaks the chain and the next chain starts where it stopped.
+// The ring retries a send on the non-blocking socket once it is writable, except when the send
+// runs in a worker thread of the kernel behind a read: then it ends with EAGAIN or short, and
+// the next chain starts with a poll for POLLOUT.
+void IoUring::start_chain(Slot *slot)
+{
+	OutputQueue::Part parts[SEND_IOV_MAX];
+	size_t count = slot->output.parts(parts, SEND_IOV_MAX);
+	if (slot->chain.empty())
+	{
+		for (int i = 0; i < URING_CHAIN_OPS; i++)
+		{
+			slot->chain.push_back(new Operation());
+			slot->chain.back()->slot = slot;
+		}
+	}
+	size_t ops = 0;
+	size_t chunks = 0;
+	size_t p = 0;
+	if (slot->send_blocked)
+	{
+		slot->chain[ops++]->type = kWritableOperation;
+		slot->send_blocked = false;
+	}
+	while (p < count && ops < URING_CHAIN_OPS)
+	{
+		Operation *operation = slot->chain[ops];
+		memset(&operation->msg, 0, sizeof(operation->msg));
+		operation->msg.msg_iov = operation->iov;
+		if (parts[p].data != NULL)
+		{
+			operation->type = kSendOperation;
+			operation->length = 0;
+			for (; p < count && parts[p].data != NULL; p++)
+			{
+				operation->iov[operation->msg.msg_iovlen].iov_base = const_cast<char *>(parts[p].data);
+				operation->iov[operation->msg.msg_iovlen].iov_len = parts[p].length;
+				operation->msg.msg_iovlen++;
+				operation->length += parts[p].length;
+			}
+			ops++;
+			continue;
+		}
+		if (ops + 2 > URING_CHAIN_OPS || chunks == URING_FILE_CHUNKS)
+			break;
+		if (slot->file_chunks.size() == chunks)
+			slot->file_chunks.push_back(new char[SEND_FILE_CHUNK]);
+		size_t length = std::min(parts[p].length, static_cast<size_t>(SEND_FILE_CHUNK));
+		operation->type = kReadOperation;
+		operation->length = length;
+		operation->file_fd = parts[p].fd;
+		operation->file_offset = parts[p].file_offset;
+		operation->iov[0].iov_base = slot->file_chunks[chunks];
+		operation->iov[0].iov_len = length;
+		Operation *send = slot->chain[ops + 1];
+		memset(&send->msg, 0, sizeof(send->msg));
+		send->type = kSendOperation;
+		send->length = length;
+		send->iov[0] = operation->iov[0];
+		send->msg.msg_iov = send->iov;
+		send->msg.msg_iovlen = 1;
+		parts[p].file_offset += length;
+		parts[p].length -= length;
+		if (parts[p].length == 0)
+			p++;
+		chunks++;
+		ops += 2;
+	}
+	reserve(ops);
+	size_t queued = 0;
+	for (size_t i = 0; i < ops; i++)
+	{
+		Operation *operation = slot->chain[i];
+		struct io_uring_sqe *sqe = get_sqe();
+		if (operation->type == kWritableOperation)
+		{
+			sqe->opcode = IORING_OP_POLL_ADD;
+			sqe->fd = slot->fd;
+			sqe->poll32_events = PollEvents(POLLOUT);
+		}
+		else if (operation->type == kReadOperation)
+		{
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = operation->file_fd;
+			sqe->addr = UserData(operation->iov[0].iov_base);
+			sqe->len = operation->length;
+			sqe->off = operation->file_offset;
+		}
+		else
+		{
+			sqe->opcode = IORING_OP_SENDMSG;
+			sqe->fd = slot->fd;
+			sqe->addr = UserData(&operation->msg);
+			sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+			queued += operation->length;
+			// with tcp_nopush, only the last part of the response may be sent in a partial frame
+			if (slot->nopush && queued < slot->output.size())
+				sqe->msg_flags |= MSG_MORE;
+		}
+		if (i + 1 < ops)
+			sqe->flags = IOSQE_IO_LINK;
+		sqe->user_data = UserData(operation);
+	}
+	slot->chain_pending = ops;
+	slot->in_flight += ops;
+}
+
+void IoUring::complete_chain(Operation *operation, int result)
+{
+	Slot *slot = operation->slot;
+	slot->in_flight--;
+	slot->chain_pending--;
+	// ECANCELED: an operation before it in the chain failed, or the connection was closed
+	if (result == -EAGAIN && operation->type == kSendOperation)
+		slot->send_blocked = true;
+	else if (result < 0 && result != -ECANCELED && slot->send_error == 0)
+		slot->send_error = -result;
+	else if (result >= 0 && operation->type == kReadOperation && static_cast<size_t>(result) < operation->length)
+	{
+		// the file was truncated after its size was sent in Content-Length
+		std::cerr << "read: unexpected end of file" << std::endl;
+		slot->send_error = EIO;
+	}
+	else if (result >= 0 && operation->type == kSendOperation && !slot->closing)
+	{
+		slot->output.consume(result);
+		if (static_cast<size_t>(result) < operation->length)
+			slot->send_blocked = true;
+	}
+	if (slot->chain_pending == 0 && slot->send_error == 0 && !slot->closing && !slot->output.empty())
+		start_chain(slot);
+}
+
+#else
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {}
+
+bool IoUring::open()
+{
+	errno = ENOSYS;
+	return (false);
+}
+
+void IoUring::watch(int fd, enum EventPoller::Kind kind, short events)
+{
+	(void)fd;
+	(void)kind;
+	(void)events;
+}
+
+void IoUring::modify(int fd, short events)
+{
+	(void)fd;
+	(void)events;
+}
+
+void IoUring::remove(int fd)
+{
+	(void)fd;
+}
+
+void IoUring::close(int fd)
+{
+	::close(fd);
+}
+
+int IoUring::wait(std::vector<struct pollfd> &ready, int timeout)
+{
+	(void)ready;
+	(void)timeout;
+	errno = ENOSYS;
+	return (-1);
+}
+
+int IoUring::accept(int fd, int budget, std::vector<int> &accepted)
+{
+	(void)fd;
+	(void)budget;
+	accepted.clear();
+	return (0);
+}
+
+ssize_t IoUring::receive(int fd, std::string &buffer)
+{
+	(void)fd;
+	(void)buffer;
+	errno = ENOSYS;
+	return (-1);
+}
+
+int IoUring::send(int fd, OutputQueue &output, bool nopush)
+{
+	(void)fd;
+	(void)output;
+	(void)nopush;
+	errno = ENOSYS;
+	return (-1);
+}
+
+#endif
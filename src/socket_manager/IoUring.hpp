@@ -0,0 +1,116 @@
+#pragma once
+
+#include "EventPoller.hpp"
+#include "OutputQueue.hpp"
+
+#include <poll.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+# include <linux/version.h>
+# if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 19, 0)
+#  define IO_URING_AVAILABLE //multishot accept and provided buffer rings
+# endif
+#endif
+
+#define URING_SQ_ENTRIES 256
+#define URING_CQ_ENTRIES 4096
+#define URING_RECV_BUFFERS 256 //IO_BUFFER_SIZE buffers provided to the ring, a power of two
+#define URING_ACCEPT_QUEUE 128 //accepted connections kept before the multishot accept is stopped
+#define URING_CHAIN_OPS 8 //operations linked in one send chain
+#define URING_FILE_CHUNKS 4 //SEND_FILE_CHUNK buffers read by one send chain
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+//The io_uring backend of EventPoller, on the raw system calls.
+//Every fd of the pollfd vector has a slot, which keeps the operations armed for it:
+//- a listening socket keeps a multishot accept, its connections wait in the slot until accept()
+//  takes them, and the accept is stopped while URING_ACCEPT_QUEUE of them wait;
+//- a pipe or eventfd keeps a multishot poll;
+//- a connection keeps one recv into a buffer chosen by the kernel from the provided buffer ring
+//  while it waits for POLLIN, the result is held until receive() copies it out. Its output
+//  queue is sent by chains of linked sendmsg, and read then send for the file segments, started
+//  by send() and continued by the completions until the queue is empty.
+//A slot is reported like poll would: POLLIN when an accept, a poll or a recv result is held,
+//POLLOUT when the send chain is finished, as long as the events of the pollfd ask for it.
+//
+//A closed connection is shut down and its operations are cancelled, the fd is only closed when
+//the last of them has completed, so that its number is not reused while a linked operation
+//may still resolve it.
+class IoUring
+{
+	public:
+		IoUring();
+		~IoUring();
+
+		bool open(); //false with errno when the kernel lacks a feature, the caller falls back
+
+		void watch(int fd, enum EventPoller::Kind kind, short events);
+		void modify(int fd, short events);
+		void remove(int fd);
+		void close(int fd);
+		int wait(std::vector<struct pollfd> &ready, int timeout);
+
+		int accept(int fd, int budget, std::vector<int> &accepted);
+		ssize_t receive(int fd, std::string &buffer);
+		int send(int fd, OutputQueue &output, bool nopush);
+
+	private:
+		struct Slot;
+		struct Operation;
+
+		int ring_fd_;
+		void *rings_;
+		size_t rings_size_;
+		struct io_uring_sqe *sqes_;
+		size_t sqes_size_;
+		unsigned *sq_head_;
+		unsigned *sq_tail_;
+		unsigned sq_mask_;
+		unsigned sq_entries_;
+		unsigned *cq_head_;
+		unsigned *cq_tail_;
+		unsigned cq_mask_;
+		struct io_uring_cqe *cqes_;
+		unsigned sq_local_tail_; //filled entries, published at the next submit
+
+		struct io_uring_buf *buffer_ring_;
+		char *recv_buffers_;
+		unsigned short buffer_tail_;
+
+		std::vector<Slot *> slots_; //indexed by fd, NULL when the fd is not watched
+		std::vector<Slot *> closing_; //slots waiting for their last completion
+		std::vector<int> touched_; //fds whose state changed since the last wait
+
+		bool setup_ring();
+		bool setup_buffers();
+		struct io_uring_sqe *get_sqe();
+		void reserve(unsigned count);
+		int submit(unsigned min_complete, int timeout);
+		void reap();
+		void collect(std::vector<struct pollfd> &ready);
+		void complete(Operation *operation, int result, unsigned flags);
+
+		Slot *live_slot(int fd) const;
+		void arm_accept(Slot *slot);
+		void arm_poll(Slot *slot);
+		void arm_recv(Slot *slot);
+		void cancel(Operation *operation);
+		void cancel_all(Slot *slot);
+		void recycle_buffer(int id);
+		void start_chain(Slot *slot);
+		void complete_accept(Slot *slot, int result, unsigned flags);
+		void complete_recv(Slot *slot, int result, unsigned flags);
+		void complete_chain(Operation *operation, int result);
+		short revents(Slot *slot) const;
+		void release(Slot *slot);
+		void touch(Slot *slot);
+
+		IoUring(const IoUring &src);
+		IoUring &operator=(const IoUring &src);
+};
@@ -0,0 +1,134 @@
+#include "OutputQueue.hpp"
+
+#include <unistd.h>
+#include <cassert>
+#include <algorithm>
+
+OutputQueue::OutputQueue() : offset_(0), size_(0) {}
+
+OutputQueue::~OutputQueue() {}
+
+void OutputQueue::push(std::string &data)
+{
+	if (data.empty())
+		return ;
+	segments_.push_back(Segment());
+	Segment &segment = segments_.back();
+	segment.data.swap(data);
+	segment.fd = -1;
+	segment.file_offset = 0;
+	segment.length = segment.data.size();
+	size_ += segment.length;
+}
+
+void OutputQueue::push_file(int fd, off_t offset, size_t length)
+{
+	if (length == 0)
+	{
+		close(fd);
+		return ;
+	}
+	segments_.push_back(Segment());
+	Segment &segment = segments_.back();
+	segment.fd = fd;
+	segment.file_offset = offset;
+	segment.length = length;
+	size_ += length;
+}
+
+bool OutputQueue::empty() const
+{
+	return (size_ == 0);
+}
+
+size_t OutputQueue::size() const
+{
+	return (size_);
+}
+
+bool OutputQueue::front_is_file() const
+{
+	return (!segments_.empty() && segments_.front().fd != -1);
+}
+
+int OutputQueue::to_iovec(struct iovec *iov, int max_iov) const
+{
+	int count = 0;
+	size_t offset = offset_;
+	std::deque<Segment>::const_iterator it;
+	for (it = segments_.begin(); it != segments_.end() && count < max_iov; it++)
+	{
+		if (it->fd != -1)
+			break;
+		iov[count].iov_base = const_cast<char *>(it->data.data() + offset);
+		iov[count].iov_len = it->length - offset;
+		offset = 0;
+		count++;
+	}
+	return (count);
+}
+
+int OutputQueue::front_file(off_t *offset, size_t *length) const
+{
+	assert(front_is_file() && "OutputQueue::front_file: front segment is not a file");
+	const Segment &segment = segments_.front();
+	*offset = segment.file_offset + offset_;
+	*length = segment.length - offset_;
+	return (segment.fd);
+}
+
+size_t OutputQueue::parts(Part *parts, size_t max_parts) const
+{
+	size_t count = 0;
+	size_t offset = offset_;
+	std::deque<Segment>::const_iterator it;
+	for (it = segments_.begin(); it != segments_.end() && count < max_parts; it++)
+	{
+		parts[count].data = it->fd == -1 ? it->data.data() + offset : NULL;
+		parts[count].fd = it->fd;
+		parts[count].file_offset = it->file_offset + offset;
+		parts[count].length = it->length - offset;
+		offset = 0;
+		count++;
+	}
+	return (count);
+}
+
+void OutputQueue::consume(size_t bytes)
+{
+	assert(bytes <= size_ && "OutputQueue::consume: more bytes than queued");
+	size_ -= bytes;
+	while (bytes > 0)
+	{
+		size_t left = segments_.front().length - offset_;
+		if (bytes < left)
+		{
+			offset_ += bytes;
+			return ;
+		}
+		bytes -= left;
+		pop_front();
+	}
+}
+
+void OutputQueue::clear()
+{
+	while (!segments_.empty())
+		pop_front();
+	size_ = 0;
+}
+
+void OutputQueue::swap(OutputQueue &other)
+{
+	segments_.swap(other.segments_);
+	std::swap(offset_, other.offset_);
+	std::swap(size_, other.size_);
+}
+
+void OutputQueue::pop_front()
+{
+	if (segments_.front().fd != -1)
+		close(segments_.front().fd);
+	segments_.pop_front();
+	offset_ = 0;
+}
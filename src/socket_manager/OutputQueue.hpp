@@ -0,0 +1,64 @@
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <deque>
+#include <string>
+
+//Pending output of one client socket.
+//A response is queued as segments: memory buffers (status line and headers, body)
+//and file regions. Sent bytes only move the read offset of the front segment, so a
+//large response is never shifted in memory.
+//
+//The queue is copied together with its ClientSocket inside a std::vector, so the
+//destructor does not close the file descriptors. Call clear() when the client is
+//reset or deleted.
+class OutputQueue
+{
+	public:
+		//what is left of one segment, data is NULL for a file segment
+		struct Part
+		{
+			const char *data;
+			int fd;
+			off_t file_offset;
+			size_t length;
+		};
+
+		OutputQueue();
+		~OutputQueue();
+
+		void push(std::string &data); //takes the content of data, data is left empty
+		void push_file(int fd, off_t offset, size_t length); //takes the ownership of fd
+
+		bool empty() const;
+		size_t size() const; //bytes left to send
+		bool front_is_file() const;
+
+		//fill iov with the memory segments in front of the first file segment
+		int to_iovec(struct iovec *iov, int max_iov) const;
+		//front file segment: file descriptor, position and length left
+		int front_file(off_t *offset, size_t *length) const;
+		//describe the segments from the front, memory and files alike
+		size_t parts(Part *parts, size_t max_parts) const;
+
+		void consume(size_t bytes);
+		void clear();
+		void swap(OutputQueue &other);
+
+	private:
+		struct Segment
+		{
+			std::string data;
+			int fd; //-1 for memory segments
+			off_t file_offset;
+			size_t length;
+		};
+
+		std::deque<Segment> segments_;
+		size_t offset_; //bytes of the front segment already sent
+		size_t size_;
+
+		void pop_front();
+};
@@ -6,22 +6,28 @@
 #include <string.h>
 #include <cerrno>
 #include <cassert>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#ifdef __linux__
+# include <sys/sendfile.h>
+#endif
 
 #include "misc/Maybe.hpp"
 #include "Uri/Authority.hpp"
 #include "Configuration.hpp"
+#include "constants.hpp"
 
-#define LISTEN_BACKLOG 10
+SocketManager::SocketManager() : owns_servers_(true), buffers_(IO_BUFFER_SIZE, RECV_IOV_MAX) {}
 
-SocketManager::SocketManager() {}
-
-SocketManager::SocketManager(int max_clients)
+SocketManager::SocketManager(int max_clients) : owns_servers_(true), buffers_(IO_BUFFER_SIZE, RECV_IOV_MAX)
 {
 	clients_.reserve(max_clients);
 }
 
 SocketManager::~SocketManager()
 {
+	if (!owns_servers_)
+		return ;
 	std::vector<ServerSocket>::iterator it;
 	for (it = servers_.begin(); it != servers_.end(); it++)
 	{
@@ -33,75 +39,276 @@ SocketManager::~SocketManager()
 
 // setter for servers_, which uses getaddrinfo(), socket(), bind(), listen() to set up the server sockets
 // This means server.start()
-enum SocketError SocketManager::set_servers(std::vector<const uri::Authority *> socket_configs)
+enum SocketError SocketManager::set_servers(std::vector<const uri::Authority *> socket_configs, Configuration &database)
 {
 	assert(socket_configs.size() > 0);
 
-	struct addrinfo hints;
-	int serv_sock;
-	int status;
+	std::vector<const uri::Authority *>::const_iterator it;
+	for (it = socket_configs.begin(); it != socket_configs.end(); it++)
+	{
+		ServerSocket server;
+		enum SocketError err = open_server(**it, database.listen_options(**it), server);
+		if (err != kNoError)
+			return (err);
+		servers_.push_back(server);
+		database.register_server_socket(server.socket, **it);
+	}
+	close_inherited_servers();
+	return (kNoError);
+}
+
+// Socket options of the listen directive parameters. They are tuning knobs, so a failure is
+// reported but does not prevent the server from starting.
+static void ApplyListenOptions(int serv_sock, const directive::ListenOptions &options)
+{
+	if (options.rcvbuf > 0 && setsockopt(serv_sock, SOL_SOCKET, SO_RCVBUF, &options.rcvbuf, sizeof(int)) == -1)
+		std::cerr << "setsockopt SO_RCVBUF: " << strerror(errno) << std::endl;
+	if (options.sndbuf > 0 && setsockopt(serv_sock, SOL_SOCKET, SO_SNDBUF, &options.sndbuf, sizeof(int)) == -1)
+		std::cerr << "setsockopt SO_SNDBUF: " << strerror(errno) << std::endl;
+#ifdef TCP_DEFER_ACCEPT
+	if (setsockopt(serv_sock, IPPROTO_TCP, TCP_DEFER_ACCEPT, &options.defer_accept, sizeof(int)) == -1)
+		std::cerr << "setsockopt TCP_DEFER_ACCEPT: " << strerror(errno) << std::endl;
+#else
+	if (options.defer_accept > 0)
+		std::cerr << "defer_accept is not supported on this system" << std::endl;
+#endif
+#ifdef TCP_FASTOPEN
+	if (options.fastopen > 0 && setsockopt(serv_sock, IPPROTO_TCP, TCP_FASTOPEN, &options.fastopen, sizeof(int)) == -1)
+		std::cerr << "setsockopt TCP_FASTOPEN: " << strerror(errno) << std::endl;
+#else
+	if (options.fastopen > 0)
+		std::cerr << "fastopen is not supported on this system" << std::endl;
+#endif
+}
+
+// Only listening stream sockets are kept, so that a stray fd in LISTEN_FDS can not be mistaken
+// for a server socket. They are matched against the listen directives by set_servers().
+void SocketManager::inherit_servers(const std::vector<int> &fds)
+{
+	std::vector<int>::const_iterator it;
+	for (it = fds.begin(); it != fds.end(); it++)
+	{
+		int type = 0;
+		int listening = 0;
+		socklen_t len = sizeof(int);
+		if (getsockopt(*it, SOL_SOCKET, SO_TYPE, &type, &len) == -1 || type != SOCK_STREAM)
+		{
+			std::cerr << "inherited fd " << *it << " is not a stream socket" << std::endl;
+			continue;
+		}
+		len = sizeof(int);
+		if (getsockopt(*it, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) == -1 || !listening)
+		{
+			std::cerr << "inherited fd " << *it << " is not listening" << std::endl;
+			continue;
+		}
+		inherited_.push_back(*it);
+	}
+}
 
+static bool IsSameAddress(const struct sockaddr *a, const struct sockaddr *b)
+{
+	if (a->sa_family != b->sa_family)
+		return (false);
+	if (a->sa_family == AF_INET)
+	{
+		const struct sockaddr_in *a4 = (const struct sockaddr_in *)a;
+		const struct sockaddr_in *b4 = (const struct sockaddr_in *)b;
+		return (a4->sin_port == b4->sin_port && a4->sin_addr.s_addr == b4->sin_addr.s_addr);
+	}
+	if (a->sa_family == AF_INET6)
+	{
+		const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *)a;
+		const struct sockaddr_in6 *b6 = (const struct sockaddr_in6 *)b;
+		return (a6->sin6_port == b6->sin6_port && memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(struct in6_addr)) == 0);
+	}
+	return (false);
+}
+
+// returns the inherited socket that is bound to addr, or -1
+int SocketManager::take_inherited_server(const struct sockaddr *addr)
+{
+	std::vector<int>::iterator it;
+	for (it = inherited_.begin(); it != inherited_.end(); it++)
+	{
+		struct sockaddr_storage bound;
+		socklen_t len = sizeof(bound);
+		if (getsockname(*it, (struct sockaddr *)&bound, &len) == -1)
+			continue;
+		if (IsSameAddress((struct sockaddr *)&bound, addr))
+		{
+			int fd = *it;
+			inherited_.erase(it);
+			return (fd);
+		}
+	}
+	return (-1);
+}
+
+// inherited sockets without a listen directive in the current configuration
+void SocketManager::close_inherited_servers()
+{
+	std::vector<int>::iterator it;
+	for (it = inherited_.begin(); it != inherited_.end(); it++)
+	{
+		std::cout << "inherited socket: " << *it << " is not configured, closed" << std::endl;
+		close(*it);
+	}
+	inherited_.clear();
+}
+
+static bool IsSameSocket(const uri::Authority &a, const uri::Authority &b)
+{
+	return (a.family() == b.family() && a.host.value == b.host.value && a.port == b.port);
+}
+
+// Used by a configuration reload: sockets that are still configured are kept open, so that
+// connections waiting in their listen queue are not lost. If a new socket cannot be opened,
+// nothing is changed and the old configuration stays in use.
+enum SocketError SocketManager::update_servers(std::vector<const uri::Authority *> socket_configs, Configuration &database)
+{
+	assert(socket_configs.size() > 0);
+
+	std::vector<ServerSocket> servers;
+	std::vector<ServerSocket> opened;
 	std::vector<const uri::Authority *>::const_iterator it;
 	for (it = socket_configs.begin(); it != socket_configs.end(); it++)
 	{
-		// for setsockopt()
-		int yes = 1;
-		struct addrinfo *res;
-		int res_len = -1;
-
-		// set socketaddress hints
-		memset(&hints, 0, sizeof(hints));
-		if ((*it)->family() == uri::Host::IPV4)
-			hints.ai_family = AF_INET;
-		else if ((*it)->family() == uri::Host::IPV6)
-			hints.ai_family = AF_INET6;
-		else
-			hints.ai_family = AF_UNSPEC;
-		hints.ai_socktype = SOCK_STREAM;
-		// testing the address and port and family
-		//  std::cout << "host: " << (*it)->host.value << " port: " << (*it)->port << " family: " << (*it)->family() <<std::endl;
-		if ((*it)->host.value == "::" || (*it)->host.value.empty() || (*it)->host.value == "0.0.0.0")
+		std::vector<ServerSocket>::iterator server_it;
+		for (server_it = servers_.begin(); server_it != servers_.end(); server_it++)
 		{
-			hints.ai_flags = AI_PASSIVE;
-			status = getaddrinfo(NULL, (*it)->port.c_str(), &hints, &res);
+			if (IsSameSocket(server_it->authority, **it))
+				break;
 		}
-		else
-			status = getaddrinfo((*it)->host.value.c_str(), (*it)->port.c_str(), &hints, &res);
-		if (status != 0)
+		const directive::ListenOptions &options = database.listen_options(**it);
+		if (server_it != servers_.end())
 		{
-			std::cerr << "getaddrinfo: " << gai_strerror(status) << std::endl;
-			return (kGetAddrInfoError);
+			// a larger backlog takes effect by calling listen() again
+			if (server_it->options.backlog != options.backlog && listen(server_it->socket, options.backlog) == -1)
+				std::cerr << "listen: " << strerror(errno) << std::endl;
+			ApplyListenOptions(server_it->socket, options);
+			server_it->options = options;
+			servers.push_back(*server_it);
+			continue;
 		}
-		struct addrinfo *ai_ptr;
-		for (ai_ptr = res; ai_ptr != NULL; ai_ptr = ai_ptr->ai_next)
+		ServerSocket server;
+		enum SocketError err = open_server(**it, options, server);
+		if (err != kNoError)
 		{
-			// testing the address and port and family
-			std::cout << "famliy: " << ai_ptr->ai_family << " socktype: " << ai_ptr->ai_socktype << " protocol: " << ai_ptr->ai_protocol << std::endl;
-			// end of testing
-			res_len++;
-			serv_sock = socket(ai_ptr->ai_family, ai_ptr->ai_socktype, ai_ptr->ai_protocol);
-			if (serv_sock == -1)
-			{
-				std::cerr << "socket: " << strerror(errno) << std::endl;
-				continue;
-			}
-			if (setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int)) == -1)
-			{
-				std::cerr << "setsockopt: " << strerror(errno) << std::endl;
-				close(serv_sock);
-				freeaddrinfo(res);
-				return (kSetSockOptError);
-			}
-#ifdef __linux__
-			int yes = 1;
-			if (ai_ptr->ai_family == AF_INET6 && setsockopt(serv_sock, IPPROTO_IPV6, IPV6_V6ONLY, &yes, sizeof(int)) == -1)
-			{
-				std::cerr << "setsockopt linux: " << strerror(errno) << std::endl;
-				close(serv_sock);
-				freeaddrinfo(res);
-				return (kSetSockOptError);
-			}
-#endif
+			for (server_it = opened.begin(); server_it != opened.end(); server_it++)
+				close_server(*server_it);
+			return (err);
+		}
+		servers.push_back(server);
+		opened.push_back(server);
+	}
+	// close the sockets that are not in the new configuration anymore
+	std::vector<ServerSocket>::iterator old_it;
+	for (old_it = servers_.begin(); old_it != servers_.end(); old_it++)
+	{
+		std::vector<ServerSocket>::iterator server_it;
+		for (server_it = servers.begin(); server_it != servers.end(); server_it++)
+		{
+			if (server_it->socket == old_it->socket)
+				break;
+		}
+		if (server_it == servers.end())
+		{
+			std::cout << "server socket: " << old_it->socket << " is closed" << std::endl;
+			close_server(*old_it);
+		}
+	}
+	servers_ = servers;
+	for (old_it = servers_.begin(); old_it != servers_.end(); old_it++)
+		database.register_server_socket(old_it->socket, old_it->authority);
+	return (kNoError);
+}
+
+// The worker threads accept from the listening sockets of worker 0, which opens, updates and
+// closes them. The shared copies have no addrinfo and their own accept statistics.
+void SocketManager::share_servers(const std::vector<struct ServerSocket> &servers)
+{
+	assert((servers_.empty() || !owns_servers_) && "SocketManager::share_servers: servers are owned");
+	owns_servers_ = false;
+	servers_ = servers;
+	std::vector<ServerSocket>::iterator it;
+	for (it = servers_.begin(); it != servers_.end(); it++)
+	{
+		it->add_info = NULL;
+		memset(&it->stats, 0, sizeof(it->stats));
+	}
+}
+
+// used when shutting down, pending connections in the accept queue are refused
+void SocketManager::close_servers()
+{
+	if (!owns_servers_)
+	{
+		servers_.clear();
+		return ;
+	}
+	std::vector<ServerSocket>::iterator it;
+	for (it = servers_.begin(); it != servers_.end(); it++)
+	{
+		std::cout << "server socket: " << it->socket << " is closed" << std::endl;
+		close_server(*it);
+	}
+	servers_.clear();
+}
+
+void SocketManager::close_server(ServerSocket &server)
+{
+	close(server.socket);
+	if (server.add_info != NULL)
+		freeaddrinfo(server.add_info);
+	server.add_info = NULL;
+}
+
+enum SocketError SocketManager::open_server(const uri::Authority &socket_config, const directive::ListenOptions &options, ServerSocket &server)
+{
+	struct addrinfo hints;
+	int serv_sock;
+	int status;
+
+	// for setsockopt()
+	int yes = 1;
+	struct addrinfo *res;
+	int res_len = -1;
+
+	// set socketaddress hints
+	memset(&hints, 0, sizeof(hints));
+	if (socket_config.family() == uri::Host::IPV4)
+		hints.ai_family = AF_INET;
+	else if (socket_config.family() == uri::Host::IPV6)
+		hints.ai_family = AF_INET6;
+	else
+		hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	// testing the address and port and family
+	//  std::cout << "host: " << socket_config.host.value << " port: " << socket_config.port << " family: " << socket_config.family() <<std::endl;
+	if (socket_config.host.value == "::" || socket_config.host.value.empty() || socket_config.host.value == "0.0.0.0")
+	{
+		hints.ai_flags = AI_PASSIVE;
+		status = getaddrinfo(NULL, socket_config.port.c_str(), &hints, &res);
+	}
+	else
+		status = getaddrinfo(socket_config.host.value.c_str(), socket_config.port.c_str(), &hints, &res);
+	if (status != 0)
+	{
+		std::cerr << "getaddrinfo: " << gai_strerror(status) << std::endl;
+		return (kGetAddrInfoError);
+	}
+	struct addrinfo *ai_ptr;
+	for (ai_ptr = res; ai_ptr != NULL; ai_ptr = ai_ptr->ai_next)
+	{
+		// testing the address and port and family
+		std::cout << "famliy: " << ai_ptr->ai_family << " socktype: " << ai_ptr->ai_socktype << " protocol: " << ai_ptr->ai_protocol << std::endl;
+		// end of testing
+		res_len++;
+		serv_sock = take_inherited_server(ai_ptr->ai_addr);
+		if (serv_sock != -1)
+		{
+			std::cout << "server socket: " << serv_sock << " is inherited" << std::endl;
 			if (fcntl(serv_sock, F_SETFL, O_NONBLOCK) == -1)
 			{
 				std::cerr << "fcntl: " << strerror(errno) << std::endl;
@@ -109,108 +316,231 @@ enum SocketError SocketManager::set_servers(std::vector<const uri::Authority *>
 				freeaddrinfo(res);
 				return (kFcntlError);
 			}
-			if (bind(serv_sock, ai_ptr->ai_addr, ai_ptr->ai_addrlen) == -1)
-			{
-				std::cerr << "bind of socket addresses: " << strerror(errno) << std::endl;
-				close(serv_sock);
-				continue;
-			}
-			// if (hints.ai_family == AF_UNSPEC && ai_ptr->ai_next != NULL)
-			// {
-			// 	printf("server socket is bind to both ipv4 and ipv6\n");
-			// 	continue;
-			// }
 			break;
 		}
-		if (ai_ptr == NULL)
+		serv_sock = socket(ai_ptr->ai_family, ai_ptr->ai_socktype, ai_ptr->ai_protocol);
+		if (serv_sock == -1)
 		{
-			std::cerr << "bind: failed to bind" << std::endl;
+			std::cerr << "socket: " << strerror(errno) << std::endl;
+			continue;
+		}
+		if (setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int)) == -1)
+		{
+			std::cerr << "setsockopt: " << strerror(errno) << std::endl;
+			close(serv_sock);
 			freeaddrinfo(res);
-			return (kBindError);
+			return (kSetSockOptError);
 		}
-		if (listen(serv_sock, LISTEN_BACKLOG) == -1)
+#ifdef __linux__
+		int yes = 1;
+		if (ai_ptr->ai_family == AF_INET6 && setsockopt(serv_sock, IPPROTO_IPV6, IPV6_V6ONLY, &yes, sizeof(int)) == -1)
 		{
-			std::cerr << "listen: " << strerror(errno) << std::endl;
+			std::cerr << "setsockopt linux: " << strerror(errno) << std::endl;
 			close(serv_sock);
 			freeaddrinfo(res);
-			return (kListenError);
+			return (kSetSockOptError);
 		}
-		// free the addrinfo struct and close the socket fd in SocketManager destructor
-		ServerSocket server;
-		server.socket = serv_sock;
-		server.add_info = res;
-		server.addr_to_bind = res_len;
-		servers_.push_back(server);
-		ws_database.register_server_socket(serv_sock, **it);
-		// for testing the address and port
-		void *addr;
-		std::string ipver;
-		char ipstr[INET6_ADDRSTRLEN];
-		int port;
-		// get the pointer to the address itself, different fields in IPv4 and IPv6:
-		if (ai_ptr->ai_family == AF_INET)
-		{ // IPv4
-			struct sockaddr_in *ipv4 = (struct sockaddr_in *)ai_ptr->ai_addr;
-			addr = &(ipv4->sin_addr);
-			port = ntohs(ipv4->sin_port);
-			ipver = "IPv4";
+#endif
+		if (fcntl(serv_sock, F_SETFL, O_NONBLOCK) == -1)
+		{
+			std::cerr << "fcntl: " << strerror(errno) << std::endl;
+			close(serv_sock);
+			freeaddrinfo(res);
+			return (kFcntlError);
 		}
-		else
-		{ // IPv6, if ai_family is UNSPEC, getaddrinfo() will return socket addresses either IPv4 or IPv6. In out case, it returns IPv6.
-			struct sockaddr_in6 *ipv6 = (struct sockaddr_in6 *)ai_ptr->ai_addr;
-			addr = &(ipv6->sin6_addr);
-			port = ntohs(ipv6->sin6_port);
-			ipver = "IPv6";
+		if (bind(serv_sock, ai_ptr->ai_addr, ai_ptr->ai_addrlen) == -1)
+		{
+			std::cerr << "bind of socket addresses: " << strerror(errno) << std::endl;
+			close(serv_sock);
+			continue;
 		}
-		// convert the IP to a string and print it:
-		inet_ntop(ai_ptr->ai_family, addr, ipstr, sizeof ipstr);
-		std::cout << "server socket: " << serv_sock << " is listeing on: " << ipver << ": [" << ipstr << "]:" << port << std::endl;
-		// end of testing
+		// if (hints.ai_family == AF_UNSPEC && ai_ptr->ai_next != NULL)
+		// {
+		// 	printf("server socket is bind to both ipv4 and ipv6\n");
+		// 	continue;
+		// }
+		break;
+	}
+	if (ai_ptr == NULL)
+	{
+		std::cerr << "bind: failed to bind" << std::endl;
+		freeaddrinfo(res);
+		return (kBindError);
+	}
+	ApplyListenOptions(serv_sock, options);
+	if (listen(serv_sock, options.backlog) == -1)
+	{
+		std::cerr << "listen: " << strerror(errno) << std::endl;
+		close(serv_sock);
+		freeaddrinfo(res);
+		return (kListenError);
+	}
+	// free the addrinfo struct and close the socket fd in SocketManager destructor
+	server.socket = serv_sock;
+	server.add_info = res;
+	server.addr_to_bind = res_len;
+	server.authority = socket_config;
+	server.options = options;
+	memset(&server.stats, 0, sizeof(server.stats));
+	// for testing the address and port
+	void *addr;
+	std::string ipver;
+	char ipstr[INET6_ADDRSTRLEN];
+	int port;
+	// get the pointer to the address itself, different fields in IPv4 and IPv6:
+	if (ai_ptr->ai_family == AF_INET)
+	{ // IPv4
+		struct sockaddr_in *ipv4 = (struct sockaddr_in *)ai_ptr->ai_addr;
+		addr = &(ipv4->sin_addr);
+		port = ntohs(ipv4->sin_port);
+		ipver = "IPv4";
+	}
+	else
+	{ // IPv6, if ai_family is UNSPEC, getaddrinfo() will return socket addresses either IPv4 or IPv6. In out case, it returns IPv6.
+		struct sockaddr_in6 *ipv6 = (struct sockaddr_in6 *)ai_ptr->ai_addr;
+		addr = &(ipv6->sin6_addr);
+		port = ntohs(ipv6->sin6_port);
+		ipver = "IPv6";
 	}
+	// convert the IP to a string and print it:
+	inet_ntop(ai_ptr->ai_family, addr, ipstr, sizeof ipstr);
+	std::cout << "server socket: " << serv_sock << " is listeing on: " << ipver << ": [" << ipstr << "]:" << port << std::endl;
+	// end of testing
 	return (kNoError);
 }
 
-int SocketManager::accept_client(int server_socket)
+// Accept up to budget connections from the accept queue until it is empty, so that a burst of
+// connections is taken in one event loop iteration. Returns the amount of accepted clients.
+int SocketManager::accept_clients(int server_socket, int budget, std::vector<int> &accepted)
 {
-	ClientSocket client;
-	socklen_t addrlen;
-	addrlen = sizeof(client.ip_addr);
-
-	int client_socket = accept(server_socket, (struct sockaddr *)&client.ip_addr, &addrlen);
-	if (client_socket == -1)
-	{
-		std::cerr << "accept: " << strerror(errno) << std::endl;
-		return (-1);
-	}
-	else
+	struct ServerSocket *server = find_server(server_socket);
+	assert(server != NULL);
+	update_accept_queue_stats(*server);
+	accepted.clear();
+	while ((int)accepted.size() < budget)
 	{
-		if (fcntl(client_socket, F_SETFL, O_NONBLOCK) == -1)
+		struct sockaddr_storage ip_addr;
+		socklen_t addrlen;
+		addrlen = sizeof(ip_addr);
+
+#ifdef __linux__
+		int client_socket = accept4(server_socket, (struct sockaddr *)&ip_addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+		int client_socket = accept(server_socket, (struct sockaddr *)&ip_addr, &addrlen);
+#endif
+		if (client_socket == -1)
 		{
-			std::cerr << "fcntl: client socket" << strerror(errno) << std::endl;
-			return (-1);
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				std::cerr << "accept: " << strerror(errno) << std::endl;
+			return (accepted.size());
 		}
-		else
+#ifndef __linux__
+		if (fcntl(client_socket, F_SETFL, O_NONBLOCK) == -1 || fcntl(client_socket, F_SETFD, FD_CLOEXEC) == -1)
 		{
-			client.socket = client_socket;
-			client.server = get_one_server(server_socket);
-			client.last_active = time(NULL);
-			client.first_recv_time = Maybe<time_t>();
-			client.timeout = false;
-			clients_.push_back(client);
-			return (client_socket);
+			std::cerr << "fcntl: client socket" << strerror(errno) << std::endl;
+			close(client_socket);
+			continue;
 		}
+#endif
+		add_client(*server, client_socket, ip_addr);
+		accepted.push_back(client_socket);
+	}
+	server->stats.budget_exhausted++;
+	return (accepted.size());
+}
+
+// Connections accepted by io_uring. A multishot accept shares one address buffer between all of
+// its connections, so the peer address is asked with getpeername().
+void SocketManager::adopt_clients(int server_socket, const std::vector<int> &accepted)
+{
+	struct ServerSocket *server = find_server(server_socket);
+	assert(server != NULL);
+	update_accept_queue_stats(*server);
+	for (std::vector<int>::const_iterator it = accepted.begin(); it != accepted.end(); it++)
+	{
+		struct sockaddr_storage ip_addr;
+		socklen_t addrlen = sizeof(ip_addr);
+		memset(&ip_addr, 0, sizeof(ip_addr));
+		// ENOTCONN when the peer has reset the connection already, the next recv reports it
+		if (getpeername(*it, (struct sockaddr *)&ip_addr, &addrlen) == -1 && errno != ENOTCONN)
+			std::cerr << "getpeername: " << strerror(errno) << std::endl;
+		add_client(*server, *it, ip_addr);
+	}
+}
+
+void SocketManager::add_client(struct ServerSocket &server, int client_socket, const struct sockaddr_storage &ip_addr)
+{
+	ClientSocket client;
+	client.socket = client_socket;
+	client.ip_addr = ip_addr;
+	client.server = server;
+	client.last_active = time(NULL);
+	client.first_recv_time = Maybe<time_t>();
+	client.timeout = false;
+	client.nodelay = false;
+	client.nopush = false;
+	client.read_size = constants::kDefaultClientHeaderBufferSize;
+	clients_.push_back(client);
+	server.stats.accepted++;
+}
+
+// The accept queue of a listening socket is not visible to poll(), on Linux TCP_INFO reports
+// its current length (tcpi_unacked) and its limit (tcpi_sacked).
+void SocketManager::update_accept_queue_stats(ServerSocket &server)
+{
+#ifdef __linux__
+	struct tcp_info info;
+	socklen_t len = sizeof(info);
+	if (getsockopt(server.socket, IPPROTO_TCP, TCP_INFO, &info, &len) == -1)
+		return ;
+	if (info.tcpi_unacked > server.stats.longest_queue)
+		server.stats.longest_queue = info.tcpi_unacked;
+	if (info.tcpi_sacked > 0 && info.tcpi_unacked >= info.tcpi_sacked)
+		server.stats.queue_full++;
+#else
+	(void)server;
+#endif
+}
+
+void SocketManager::print_accept_stats() const
+{
+	std::vector<ServerSocket>::const_iterator it;
+	for (it = servers_.begin(); it != servers_.end(); it++)
+	{
+		std::cout << "server socket: " << it->socket
+			<< " accepted: " << it->stats.accepted
+			<< ", multi_accept exhausted: " << it->stats.budget_exhausted
+			<< ", accept queue full: " << it->stats.queue_full
+			<< ", longest accept queue: " << it->stats.longest_queue
+			<< " (backlog " << it->options.backlog << ")" << std::endl;
 	}
 }
 
-ssize_t SocketManager::recv_append(int client_socket, char *buf)
+// Read up to read_size bytes with one readv() into buffers borrowed from the pool,
+// and append them to the request buffer. The buffers go back to the pool right away.
+ssize_t SocketManager::recv_append(int client_socket)
 {
-	ssize_t recv_len;
-	recv_len = recv(client_socket, buf, BUF_SIZE, 0);
+	ClientSocket *client = get_one_client(client_socket);
+	struct iovec iov[RECV_IOV_MAX];
+	size_t left = client->read_size;
+	int count = 0;
+
+	while (left > 0 && count < RECV_IOV_MAX)
+	{
+		iov[count].iov_base = buffers_.acquire();
+		iov[count].iov_len = left < buffers_.buffer_size() ? left : buffers_.buffer_size();
+		left -= iov[count].iov_len;
+		count++;
+	}
+	ssize_t recv_len = readv(client_socket, iov, count);
 	if (recv_len <= 0)
 	{
 		if (recv_len < 0)
 		{
-			std::cerr << "recv: " << strerror(errno) << std::endl;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				std::cerr << "recv: " << strerror(errno) << std::endl;
 		}
 		else
 		{
@@ -219,31 +549,122 @@ ssize_t SocketManager::recv_append(int client_socket, char *buf)
 	}
 	else
 	{
-		ClientSocket *client = get_one_client(client_socket);
-		client->req_buf.append(buf, recv_len);
+		client->req_buf.reserve(client->req_buf.size() + recv_len);
+		size_t copied = 0;
+		for (int i = 0; copied < static_cast<size_t>(recv_len); i++)
+		{
+			size_t len = static_cast<size_t>(recv_len) - copied;
+			if (len > iov[i].iov_len)
+				len = iov[i].iov_len;
+			client->req_buf.append(static_cast<char *>(iov[i].iov_base), len);
+			copied += len;
+		}
 	}
+	for (int i = 0; i < count; i++)
+		buffers_.release(static_cast<char *>(iov[i].iov_base));
 	return (recv_len);
 }
 
+// Flush the output queue until it is empty or the socket buffer is full.
+// Memory segments are gathered into one sendmsg() call, file segments go through sendfile().
+// Returns the number of bytes sent, or -1 when the connection has to be closed.
 ssize_t SocketManager::send_to_client(int client_socket)
 {
 	ClientSocket *client = get_one_client(client_socket);
-	ssize_t sent_bytes = 0;
+	OutputQueue &output = client->output;
+	ssize_t total = 0;
+
+	while (!output.empty())
+	{
+		ssize_t sent_bytes;
+		if (output.front_is_file())
+			sent_bytes = send_file_segment(client_socket, output);
+		else
+		{
+			struct iovec iov[SEND_IOV_MAX];
+			struct msghdr msg;
+			size_t len = 0;
+			int flags = 0;
+
+			memset(&msg, 0, sizeof(msg));
+			msg.msg_iov = iov;
+			msg.msg_iovlen = output.to_iovec(iov, SEND_IOV_MAX);
+			for (size_t i = 0; i < static_cast<size_t>(msg.msg_iovlen); i++)
+				len += iov[i].iov_len;
+#ifdef MSG_NOSIGNAL
+			flags |= MSG_NOSIGNAL;
+#endif
+#ifdef MSG_MORE
+			// with tcp_nopush, only the last part of the response may be sent in a partial frame
+			if (client->nopush && len < output.size())
+				flags |= MSG_MORE;
+#endif
+			sent_bytes = sendmsg(client_socket, &msg, flags);
+		}
+		if (sent_bytes == -1)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			if (errno == EINTR)
+				continue;
+			std::cerr << "send: " << strerror(errno) << std::endl;
+			return (-1);
+		}
+		if (sent_bytes == 0)
+			break;
+		output.consume(sent_bytes);
+		total += sent_bytes;
+	}
+	return (total);
+}
 
-	sent_bytes = send(client_socket, client->res_buf.c_str(), client->res_buf.size() > BUF_SIZE ? BUF_SIZE : client->res_buf.size(), 0);
-	if (sent_bytes == -1)
+ssize_t SocketManager::send_file_segment(int client_socket, OutputQueue &output)
+{
+	off_t offset;
+	size_t length;
+	int fd = output.front_file(&offset, &length);
+#ifdef __linux__
+	ssize_t sent_bytes = sendfile(client_socket, fd, &offset, length);
+	if (sent_bytes == 0) // the file was truncated after its size was sent in Content-Length
 	{
-		std::cerr << "send: " << strerror(errno) << std::endl;
+		std::cerr << "sendfile: unexpected end of file" << std::endl;
+		errno = EIO;
+		return (-1);
 	}
-	else if (sent_bytes == 0)
+	return (sent_bytes);
+#else
+	char buf[SEND_FILE_CHUNK];
+	if (length > sizeof(buf))
+		length = sizeof(buf);
+	ssize_t read_bytes = pread(fd, buf, length, offset);
+	if (read_bytes <= 0)
 	{
-		std::cout << "send: failed in the blocking mode" << std::endl;
+		std::cerr << "pread: unexpected end of file" << std::endl;
+		errno = EIO;
+		return (-1);
 	}
-	else
+	int flags = 0;
+#ifdef MSG_NOSIGNAL
+	flags |= MSG_NOSIGNAL;
+#endif
+	return (send(client_socket, buf, read_bytes, flags));
+#endif
+}
+
+// TCP_NODELAY is only changed when the location asks for another value than the current one
+void SocketManager::set_tcp_options(int client_socket, bool nodelay, bool nopush)
+{
+	ClientSocket *client = get_one_client(client_socket);
+	client->nopush = nopush;
+	if (client->nodelay == nodelay)
+		return ;
+	int value = nodelay;
+	if (setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(int)) == -1)
 	{
-		client->res_buf.erase(0, sent_bytes);
+		std::cerr << "setsockopt TCP_NODELAY: " << strerror(errno) << std::endl;
+		return ;
 	}
-	return (sent_bytes);
+	client->nodelay = nodelay;
 }
 
 void SocketManager::delete_client_socket(int client_socket)
@@ -253,6 +674,7 @@ void SocketManager::delete_client_socket(int client_socket)
 	{
 		if (it->socket == client_socket)
 		{
+			it->output.clear();
 			clients_.erase(it);
 			break;
 		}
@@ -286,6 +708,17 @@ struct ServerSocket SocketManager::get_one_server(int server_socket) const
 	return (server);
 }
 
+struct ServerSocket *SocketManager::find_server(int server_socket)
+{
+	std::vector<ServerSocket>::iterator it;
+	for (it = servers_.begin(); it != servers_.end(); it++)
+	{
+		if (it->socket == server_socket)
+			return (&(*it));
+	}
+	return (NULL);
+}
+
 struct ClientSocket *SocketManager::get_one_client(int client_socket)
 {
 	std::vector<ClientSocket>::iterator it;
@@ -2,6 +2,8 @@
 
 #include "SocketError.hpp"
 #include "Configuration.hpp"
+#include "OutputQueue.hpp"
+#include "BufferPool.hpp"
 
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -12,7 +14,19 @@
 #include <iostream>
 
 #define TIMEOUT 75
-#define BUF_SIZE 1024
+#define IO_BUFFER_SIZE 16384 //size of one pooled read buffer
+#define RECV_IOV_MAX 8 //pooled buffers filled by one readv()
+#define SEND_IOV_MAX 64 //memory segments gathered by one sendmsg()
+#define SEND_FILE_CHUNK 65536 //bytes read per pread() when sendfile() is not available, and per read of an io_uring send chain
+
+//counters of one listening socket, printed when the server shuts down
+struct AcceptStats
+{
+	unsigned long accepted;
+	unsigned long budget_exhausted; //multi_accept stopped before the accept queue was empty
+	unsigned long queue_full; //wakeups with a full accept queue, the kernel was dropping connections
+	unsigned int longest_queue;
+};
 
 //save the full linked list of res from getaddrinfo()
 //use addr_to_bind to query the correct node in the linked list
@@ -21,6 +35,9 @@ struct ServerSocket
 	int socket;
 	struct addrinfo *add_info;
 	int addr_to_bind;
+	uri::Authority authority; //the listen directive this socket was created for
+	directive::ListenOptions options;
+	struct AcceptStats stats;
 };
 
 struct ClientSocket
@@ -30,7 +47,8 @@ struct ClientSocket
 	// int server_socket;
 	struct ServerSocket server;
 	std::string req_buf;
-	std::string res_buf;
+	size_t read_size; //bytes asked per read, client_header_buffer_size or client_body_buffer_size
+	OutputQueue output; //response bytes waiting for POLLOUT
 
 	//for checking if body is received completely
 	// bool body_leftover; // ? do I need to check it?
@@ -39,6 +57,10 @@ struct ClientSocket
 	time_t last_active; //accept time or last request time
 	Maybe<time_t> first_recv_time; //time of first recv of one request
 	bool timeout;
+
+	//socket options of the location that answers the request
+	bool nodelay; //current TCP_NODELAY state of the socket
+	bool nopush; //send with MSG_MORE until the last byte of the response
 };
 
 class SocketManager
@@ -50,13 +72,20 @@ class SocketManager
 		~SocketManager();
 
 		//methods
-		int accept_client(int server_socket);
-		ssize_t recv_append(int client_socket, char *buf);
+		int accept_clients(int server_socket, int budget, std::vector<int> &accepted);
+		void adopt_clients(int server_socket, const std::vector<int> &accepted); //accepted by io_uring
+		ssize_t recv_append(int client_socket);
 		ssize_t send_to_client(int client_socket);
+		void set_tcp_options(int client_socket, bool nodelay, bool nopush);
 		//helpers
 		void delete_client_socket(int client_socket);
+		void close_servers(); //stop accepting new connections
+		void inherit_servers(const std::vector<int> &fds); //listening sockets passed by systemd or by the previous binary
+		void share_servers(const std::vector<struct ServerSocket> &servers); //listening sockets of another worker thread, never closed here
+		void print_accept_stats() const;
 		//getters and setters
-		enum SocketError set_servers(std::vector<const uri::Authority*> socket_configs); //getaddrinfo(), socket(), bind(), listen()
+		enum SocketError set_servers(std::vector<const uri::Authority*> socket_configs, Configuration &database); //getaddrinfo(), socket(), bind(), listen()
+		enum SocketError update_servers(std::vector<const uri::Authority*> socket_configs, Configuration &database); //keep existing sockets, open new ones, close removed ones
 		std::vector<struct ServerSocket> get_servers() const;
 		std::vector<struct ClientSocket> * get_clients();
 		struct ServerSocket get_one_server(int server_socket) const; //query server by socket
@@ -71,6 +100,18 @@ class SocketManager
 	private:
 		std::vector<struct ServerSocket> servers_;
 		std::vector<struct ClientSocket> clients_;
+		std::vector<int> inherited_; //inherited listening sockets that are not matched to a listen directive yet
+		bool owns_servers_; //false when servers_ are shared from the SocketManager of worker 0
+		BufferPool buffers_;
+
+		int take_inherited_server(const struct sockaddr *addr);
+		void close_inherited_servers();
+		struct ServerSocket *find_server(int server_socket);
+		void add_client(struct ServerSocket &server, int client_socket, const struct sockaddr_storage &ip_addr);
+		ssize_t send_file_segment(int client_socket, OutputQueue &output);
+		void update_accept_queue_stats(struct ServerSocket &server);
+		enum SocketError open_server(const uri::Authority &socket_config, const directive::ListenOptions &options, struct ServerSocket &server);
+		void close_server(struct ServerSocket &server);
 
 		SocketManager(const SocketManager &src);
 		SocketManager &operator=(const SocketManager &src);